@@ -0,0 +1,98 @@
+/*
+ * Minimal reader for taskmgr's shared-memory snapshot.
+ *
+ *   cc -O2 -I../src shm_reader.c -o shm_reader   (add -lrt on older glibc)
+ *   ./shm_reader [top_n]
+ *
+ * Maps the region read-only, takes a consistent copy with the seqlock
+ * protocol described in taskmgr_shm.h and prints the busiest processes.
+ */
+#include "taskmgr_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct mapping {
+    int fd;
+    void* base;
+    size_t size;
+};
+
+static int map_region(struct mapping* m) {
+    struct stat st;
+    if (fstat(m->fd, &st) < 0 || (size_t)st.st_size < sizeof(struct taskmgr_shm_header)) return -1;
+    if (m->base) munmap(m->base, m->size);
+    m->size = (size_t)st.st_size;
+    m->base = mmap(NULL, m->size, PROT_READ, MAP_SHARED, m->fd, 0);
+    return m->base == MAP_FAILED ? -1 : 0;
+}
+
+/* Copies header and records into caller-owned buffers; returns the record count */
+static long read_snapshot(struct mapping* m, struct taskmgr_shm_header* out,
+                          struct taskmgr_shm_process** records, size_t* records_cap) {
+    for (;;) {
+        const struct taskmgr_shm_header* header = (const struct taskmgr_shm_header*)m->base;
+        uint64_t s1 = __atomic_load_n(&header->seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1) continue;
+
+        memcpy(out, header, sizeof(*out));
+        if (taskmgr_shm_size(out->capacity) > m->size) {
+            if (map_region(m) < 0) return -1;
+            continue;
+        }
+
+        uint64_t count = out->process_count <= out->capacity ? out->process_count : 0;
+        if (count > *records_cap) {
+            *records = realloc(*records, count * sizeof(**records));
+            *records_cap = count;
+        }
+        memcpy(*records, taskmgr_shm_processes((struct taskmgr_shm_header*)header),
+               count * sizeof(**records));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&header->seq, __ATOMIC_RELAXED) == s1) return (long)count;
+    }
+}
+
+static int by_cpu(const void* a, const void* b) {
+    double x = ((const struct taskmgr_shm_process*)a)->cpu_usage;
+    double y = ((const struct taskmgr_shm_process*)b)->cpu_usage;
+    return (x < y) - (x > y);
+}
+
+int main(int argc, char** argv) {
+    int top_n = argc > 1 ? atoi(argv[1]) : 10;
+    char name[64];
+    snprintf(name, sizeof(name), TASKMGR_SHM_NAME_FMT, (unsigned)getuid());
+
+    struct mapping m = {shm_open(name, O_RDONLY, 0), NULL, 0};
+    if (m.fd < 0 || map_region(&m) < 0) {
+        perror("taskmgr shared memory");
+        return 1;
+    }
+    if (((const struct taskmgr_shm_header*)m.base)->magic != TASKMGR_SHM_MAGIC) {
+        fprintf(stderr, "unexpected layout\n");
+        return 1;
+    }
+
+    struct taskmgr_shm_header header;
+    struct taskmgr_shm_process* records = NULL;
+    size_t records_cap = 0;
+    long count = read_snapshot(&m, &header, &records, &records_cap);
+    if (count < 0) return 1;
+
+    qsort(records, (size_t)count, sizeof(*records), by_cpu);
+    printf("tick %llu: %ld processes, cpu %.1f%%\n",
+           (unsigned long long)header.snapshot_seq, count, header.total_cpu_usage);
+    for (long i = 0; i < count && i < top_n; i++) {
+        printf("%7d %6.1f%% %8llu KB  %-16s %s\n", records[i].pid, records[i].cpu_usage,
+               (unsigned long long)(records[i].memory_rss / 1024), records[i].user, records[i].name);
+    }
+
+    free(records);
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include "app_groups.h"
+#include "snapshot.h"
+
+void AppGroups::set_mode(Mode new_mode) {
+    mode = new_mode;
+    clear();
+}
+
+void AppGroups::clear() {
+    primed = false;
+    members.clear();
+    children.clear();
+    groups.clear();
+    changed.clear();
+}
+
+pid_t AppGroups::find_ancestor(pid_t pid, const Member& member) const {
+    const Member* current = &member;
+    // Bounded in case a stale ppid ever closes a loop
+    for (int depth = 0; depth < 64; depth++) {
+        // Kernel threads all hang off kthreadd
+        if (current->ppid == 2) return 2;
+        if (current->ppid <= 1) break;
+        auto parent = members.find(current->ppid);
+        // A user's systemd starts everything in the session, so it counts as init
+        if (parent == members.end() || parent->second.name == "systemd") break;
+        pid = current->ppid;
+        current = &parent->second;
+    }
+    return pid;
+}
+
+std::string AppGroups::ancestor_key(pid_t pid, const Member& member, std::string& name) const {
+    pid_t ancestor = find_ancestor(pid, member);
+    auto it = members.find(ancestor);
+    name = it != members.end() ? it->second.name : member.name;
+    return std::to_string(ancestor);
+}
+
+void AppGroups::subtract(const Member& member) {
+    auto it = groups.find(member.key);
+    if (it == groups.end()) return;
+    changed.insert(member.key);
+
+    AppGroup& group = it->second;
+    if (--group.processes <= 0) {
+        groups.erase(it);
+        return;
+    }
+    group.cpu_usage -= member.cpu_usage;
+    group.memory_usage -= member.memory_usage;
+    group.memory_rss -= member.memory_rss;
+    group.thread_count -= member.thread_count;
+    // Floating-point leftovers from processes that came and went
+    if (group.cpu_usage < 0) group.cpu_usage = 0;
+    if (group.memory_usage < 0) group.memory_usage = 0;
+}
+
+void AppGroups::add(pid_t pid, Member& member, const ProcessInfo& proc) {
+    std::string name;
+    if (mode == BY_EXECUTABLE) {
+        if (proc.pid == 2 || proc.ppid == 2) {
+            // kworker/0:1 and friends would each be a group of their own
+            member.key = "[kernel]";
+            name = "Kernel threads";
+        } else if (!proc.exe_path.empty()) {
+            member.key = proc.exe_path;
+            size_t slash = proc.exe_path.rfind('/');
+            name = slash == std::string::npos ? proc.exe_path : proc.exe_path.substr(slash + 1);
+        } else {
+            // Kernel threads, and other users' processes without privileges
+            member.key = "[" + proc.name + "]";
+            name = proc.name;
+        }
+    } else {
+        member.key = ancestor_key(pid, member, name);
+    }
+
+    member.cpu_usage = proc.cpu_usage;
+    member.memory_usage = proc.memory_usage;
+    member.memory_rss = proc.memory_rss;
+    member.thread_count = proc.thread_count;
+    join(member, name);
+}
+
+void AppGroups::join(const Member& member, const std::string& name) {
+    AppGroup& group = groups[member.key];
+    if (group.processes == 0) group.name = name;
+    group.processes++;
+    group.cpu_usage += member.cpu_usage;
+    group.memory_usage += member.memory_usage;
+    group.memory_rss += member.memory_rss;
+    group.thread_count += member.thread_count;
+    changed.insert(member.key);
+}
+
+void AppGroups::link(pid_t pid, pid_t ppid) {
+    children[ppid].push_back(pid);
+}
+
+void AppGroups::unlink(pid_t pid, pid_t ppid) {
+    auto it = children.find(ppid);
+    if (it == children.end()) return;
+    std::vector<pid_t>& list = it->second;
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i] != pid) continue;
+        list[i] = list.back();
+        list.pop_back();
+        break;
+    }
+    if (list.empty()) children.erase(it);
+}
+
+void AppGroups::rekey(const std::vector<pid_t>& roots) {
+    // Walks only the descendants of processes that exited, appeared or were
+    // reparented, and moves those whose ancestor changed; they keep their
+    // last contribution, it just goes to another group
+    std::unordered_set<pid_t> seen;
+    std::vector<pid_t> queue;
+    for (pid_t root : roots) {
+        if (seen.insert(root).second) queue.push_back(root);
+    }
+
+    std::string name;
+    for (size_t i = 0; i < queue.size(); i++) {
+        auto found = children.find(queue[i]);
+        if (found == children.end()) continue;
+        for (pid_t child : found->second) {
+            // A stale ppid could close a loop
+            if (!seen.insert(child).second) continue;
+            queue.push_back(child);
+
+            auto it = members.find(child);
+            if (it == members.end()) continue;
+            Member& member = it->second;
+            std::string key = ancestor_key(child, member, name);
+            if (key == member.key) continue;
+            subtract(member);
+            member.key = key;
+            join(member, name);
+        }
+    }
+}
+
+bool AppGroups::apply(const Snapshot& snapshot) {
+    const ProcessDelta& delta = snapshot.process_delta;
+    changed.clear();
+
+    bool rebuild = !primed || delta.full;
+    bool by_ancestor = mode == BY_ANCESTOR;
+    // In BY_ANCESTOR mode a process's key depends on its whole chain of
+    // parents, so an exit or reparenting can move everything below it
+    std::vector<pid_t> moved;
+    std::vector<const ProcessInfo*> touched;
+    if (rebuild) {
+        members.clear();
+        children.clear();
+        groups.clear();
+        touched.reserve(snapshot.processes->size());
+        for (const auto& proc : *snapshot.processes) touched.push_back(&proc);
+        primed = true;
+    } else {
+        for (pid_t pid : delta.removed) {
+            auto it = members.find(pid);
+            if (it == members.end()) continue;
+            subtract(it->second);
+            if (by_ancestor) {
+                unlink(pid, it->second.ppid);
+                moved.push_back(pid);
+            }
+            members.erase(it);
+        }
+        touched.reserve(delta.updated.size());
+        for (size_t index : delta.updated) touched.push_back(&(*snapshot.processes)[index]);
+    }
+
+    // Take out old contributions and record parentage for everything touched
+    // before resolving any keys, so an ancestor that appeared in this same
+    // delta is already known
+    std::vector<Member*> pending;
+    pending.reserve(touched.size());
+    for (const ProcessInfo* proc : touched) {
+        auto found = members.find(proc->pid);
+        if (found != members.end()) {
+            Member& member = found->second;
+            subtract(member);
+            if (by_ancestor && (member.ppid != proc->ppid || member.name != proc->name)) {
+                if (member.ppid != proc->ppid) {
+                    unlink(proc->pid, member.ppid);
+                    link(proc->pid, proc->ppid);
+                }
+                moved.push_back(proc->pid);
+            }
+        } else {
+            found = members.insert(std::make_pair(proc->pid, Member())).first;
+            if (by_ancestor) {
+                link(proc->pid, proc->ppid);
+                // Only matters if orphans from a reused PID still name it
+                if (!rebuild) moved.push_back(proc->pid);
+            }
+        }
+        found->second.ppid = proc->ppid;
+        found->second.name = proc->name;
+        pending.push_back(&found->second);
+    }
+    for (size_t i = 0; i < touched.size(); i++) {
+        add(touched[i]->pid, *pending[i], *touched[i]);
+    }
+    if (!moved.empty()) rekey(moved);
+    return rebuild;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include "proc_parser.h"
+
+struct Snapshot;
+
+struct AppGroup {
+    std::string name;       // Executable basename, or the ancestor's name
+    int processes = 0;
+    double cpu_usage = 0;
+    double memory_usage = 0;
+    uint64_t memory_rss = 0;
+    int thread_count = 0;
+};
+
+// Per-application totals kept up to date from each snapshot's process delta:
+// only processes that appeared, changed or exited are subtracted from and
+// added to their group, rather than summing every process each refresh.
+class AppGroups {
+public:
+    enum Mode {
+        BY_EXECUTABLE,      // exe_path; the name when it can't be read
+        BY_ANCESTOR         // Highest ancestor below init or a systemd manager
+    };
+
+    // Forgets every group; the next apply() rebuilds from scratch
+    void set_mode(Mode mode);
+    void clear();
+
+    // Folds the snapshot's process delta in. Returns true when it rebuilt
+    // everything (first call, or a full delta), in which case every group
+    // should be treated as changed.
+    bool apply(const Snapshot& snapshot);
+
+    const std::unordered_map<std::string, AppGroup>& get_groups() const { return groups; }
+    // Keys touched by the last apply(); those missing from get_groups() are gone
+    const std::unordered_set<std::string>& get_changed() const { return changed; }
+
+private:
+    // What a process last contributed, so it can be taken back out
+    struct Member {
+        pid_t ppid = 0;
+        std::string name;
+        std::string key;
+        double cpu_usage = 0;
+        double memory_usage = 0;
+        uint64_t memory_rss = 0;
+        int thread_count = 0;
+    };
+
+    void subtract(const Member& member);
+    void add(pid_t pid, Member& member, const ProcessInfo& proc);
+    void join(const Member& member, const std::string& name);
+    pid_t find_ancestor(pid_t pid, const Member& member) const;
+    std::string ancestor_key(pid_t pid, const Member& member, std::string& name) const;
+    void link(pid_t pid, pid_t ppid);
+    void unlink(pid_t pid, pid_t ppid);
+    void rekey(const std::vector<pid_t>& roots);
+
+    Mode mode = BY_EXECUTABLE;
+    bool primed = false;
+    std::unordered_map<pid_t, Member> members;
+    // ppid -> members naming it as parent, whether or not it is still alive;
+    // only kept in BY_ANCESTOR mode
+    std::unordered_map<pid_t, std::vector<pid_t>> children;
+    std::unordered_map<std::string, AppGroup> groups;
+    std::unordered_set<std::string> changed;
+};
@@ -0,0 +1,7 @@
+// taskmgr-batch: batch mode without the GUI, for hosts that have no GTK.
+// Takes the same options as `taskmgr --batch`; --batch itself is optional.
+#include "batch_mode.h"
+
+int main(int argc, char* argv[]) {
+    return BatchMode::run(argc, argv);
+}
@@ -0,0 +1,324 @@
+#include "batch_mode.h"
+#include "systemd_manager.h"
+#include "snapshot.h"
+#include "rules_engine.h"
+#include <getopt.h>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <memory>
+
+// Gap between the priming sample and the first printed one, so its CPU% is real
+#define PRIME_INTERVAL_MS 100
+
+// Long-only options
+enum { OPT_PROC_ROOT = 256, OPT_SYS_ROOT, OPT_RULES, OPT_DRY_RUN };
+
+bool BatchMode::requested(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0 || strcmp(argv[i], "-b") == 0) return true;
+    }
+    return false;
+}
+
+void BatchMode::print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " --batch [options]\n"
+              << "  -n, --iterations N   number of snapshots, 0 = until interrupted (default 1)\n"
+              << "  -d, --delay SECONDS  interval between snapshots (default 1.0)\n"
+              << "  -t, --top N          rows per snapshot, 0 = all (default 20)\n"
+              << "  -s, --sort KEY       cpu, mem, pid or name (default cpu)\n"
+              << "  -f, --format FORMAT  text, csv or json (default text)\n"
+              << "  -p, --filter TEXT    only processes whose name contains TEXT\n"
+              << "  -u, --user NAME      only processes owned by NAME\n"
+              << "  -S, --services       also print systemd services (text and json)\n"
+              << "      --proc-root DIR  read procfs from DIR instead of /proc\n"
+              << "      --sys-root DIR   read sysfs from DIR instead of /sys\n"
+              << "      --rules FILE     check threshold rules every snapshot, logging to stderr\n"
+              << "      --dry-run        log rule actions without carrying them out\n";
+}
+
+bool BatchMode::parse_options(int argc, char* argv[], Options& options) {
+    static const struct option long_options[] = {
+        {"batch", no_argument, nullptr, 'b'},
+        {"iterations", required_argument, nullptr, 'n'},
+        {"delay", required_argument, nullptr, 'd'},
+        {"top", required_argument, nullptr, 't'},
+        {"sort", required_argument, nullptr, 's'},
+        {"format", required_argument, nullptr, 'f'},
+        {"filter", required_argument, nullptr, 'p'},
+        {"user", required_argument, nullptr, 'u'},
+        {"services", no_argument, nullptr, 'S'},
+        {"help", no_argument, nullptr, 'h'},
+        {"proc-root", required_argument, nullptr, OPT_PROC_ROOT},
+        {"sys-root", required_argument, nullptr, OPT_SYS_ROOT},
+        {"rules", required_argument, nullptr, OPT_RULES},
+        {"dry-run", no_argument, nullptr, OPT_DRY_RUN},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "bn:d:t:s:f:p:u:Sh", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 'b':
+            break;
+        case 'n':
+            options.iterations = atoi(optarg);
+            if (options.iterations < 0) return false;
+            break;
+        case 'd':
+            options.interval = atof(optarg);
+            if (options.interval <= 0) return false;
+            break;
+        case 't':
+            options.top = atoi(optarg);
+            if (options.top < 0) return false;
+            break;
+        case 's':
+            if (strcmp(optarg, "cpu") == 0) options.sort = SortKey::CPU;
+            else if (strcmp(optarg, "mem") == 0) options.sort = SortKey::MEM;
+            else if (strcmp(optarg, "pid") == 0) options.sort = SortKey::PID;
+            else if (strcmp(optarg, "name") == 0) options.sort = SortKey::NAME;
+            else return false;
+            break;
+        case 'f':
+            if (strcmp(optarg, "text") == 0) options.format = Format::TEXT;
+            else if (strcmp(optarg, "csv") == 0) options.format = Format::CSV;
+            else if (strcmp(optarg, "json") == 0) options.format = Format::JSON;
+            else return false;
+            break;
+        case 'p':
+            options.name_filter = optarg;
+            break;
+        case 'u':
+            options.user_filter = optarg;
+            break;
+        case 'S':
+            options.services = true;
+            break;
+        case OPT_PROC_ROOT:
+            ProcParser::set_proc_root(optarg);
+            break;
+        case OPT_SYS_ROOT:
+            ProcParser::set_sys_root(optarg);
+            break;
+        case OPT_RULES:
+            options.rules_path = optarg;
+            break;
+        case OPT_DRY_RUN:
+            options.dry_run = true;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    // One CSV stream can only have one header
+    if (options.services && options.format == Format::CSV) {
+        std::cerr << "--services is not available with --format csv" << std::endl;
+        return false;
+    }
+    return optind == argc;
+}
+
+std::vector<ProcessInfo> BatchMode::select_processes(std::vector<ProcessInfo> processes,
+                                                     const Options& options) {
+    if (!options.name_filter.empty() || !options.user_filter.empty()) {
+        processes.erase(std::remove_if(processes.begin(), processes.end(),
+            [&options](const ProcessInfo& proc) {
+                if (!options.user_filter.empty() && proc.user != options.user_filter) return true;
+                return !options.name_filter.empty() &&
+                       !strcasestr(proc.name.c_str(), options.name_filter.c_str());
+            }), processes.end());
+    }
+
+    auto compare = [&options](const ProcessInfo& a, const ProcessInfo& b) {
+        switch (options.sort) {
+        case SortKey::MEM:  return a.memory_rss > b.memory_rss;
+        case SortKey::PID:  return a.pid < b.pid;
+        case SortKey::NAME: return a.name < b.name;
+        default:            return a.cpu_usage > b.cpu_usage;
+        }
+    };
+
+    // Only the rows we print need to be ordered
+    size_t n = processes.size();
+    if (options.top > 0 && static_cast<size_t>(options.top) < n) n = options.top;
+    std::partial_sort(processes.begin(), processes.begin() + n, processes.end(), compare);
+    processes.resize(n);
+    return processes;
+}
+
+void BatchMode::print_text(const Options& options, const SystemStats& stats,
+                           const std::vector<ProcessInfo>& processes, size_t total) {
+    char clock_text[16];
+    time_t now = time(nullptr);
+    strftime(clock_text, sizeof(clock_text), "%H:%M:%S", localtime(&now));
+
+    uint64_t used_mem = stats.total_memory - stats.available_memory;
+    printf("taskmgr - %s  cpu %.1f%%  mem %lu/%lu MB  processes %zu\n",
+           clock_text, stats.total_cpu_usage,
+           static_cast<unsigned long>(used_mem / (1024 * 1024)),
+           static_cast<unsigned long>(stats.total_memory / (1024 * 1024)), total);
+    printf("%7s %-12s %6s %6s %9s %4s %2s %s\n",
+           "PID", "USER", "CPU%", "MEM%", "RSS(MB)", "THR", "S", "NAME");
+
+    for (const auto& proc : processes) {
+        printf("%7d %-12.12s %6.1f %6.1f %9.1f %4d %2s %s\n",
+               proc.pid, proc.user.c_str(), proc.cpu_usage, proc.memory_usage,
+               proc.memory_rss / (1024.0 * 1024.0), proc.thread_count,
+               proc.state.c_str(), proc.name.c_str());
+    }
+
+    if (options.services) {
+        try {
+            auto services = SystemdManager::get_all_services();
+            SystemdManager::update_service_resources(services);
+
+            printf("\n%-40s %-10s %7s %6s %9s %5s\n",
+                   "SERVICE", "ACTIVE", "PID", "CPU%", "MEM(MB)", "TASKS");
+            for (const auto& service : services) {
+                printf("%-40.40s %-10.10s %7d %6.1f %9.1f %5d\n",
+                       service.name.c_str(), service.active.c_str(), service.main_pid,
+                       service.cpu_usage, service.memory_current / (1024.0 * 1024.0),
+                       service.tasks_current);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error collecting services: " << e.what() << std::endl;
+        }
+    }
+    printf("\n");
+}
+
+void BatchMode::print_csv(const Options&, const std::vector<ProcessInfo>& processes, bool header) {
+    if (header) {
+        printf("time,pid,ppid,user,cpu,mem,rss,threads,nice,state,name\n");
+    }
+
+    long now = static_cast<long>(time(nullptr));
+    for (const auto& proc : processes) {
+        // Names are the only free-form field; quote them and double any quotes
+        std::string name = proc.name;
+        for (size_t pos = 0; (pos = name.find('"', pos)) != std::string::npos; pos += 2) {
+            name.insert(pos, 1, '"');
+        }
+        printf("%ld,%d,%d,%s,%.1f,%.1f,%lu,%d,%d,%s,\"%s\"\n",
+               now, proc.pid, proc.ppid, proc.user.c_str(), proc.cpu_usage, proc.memory_usage,
+               static_cast<unsigned long>(proc.memory_rss), proc.thread_count, proc.nice,
+               proc.state.c_str(), name.c_str());
+    }
+}
+
+void BatchMode::print_json(const Options& options, const SystemStats& stats,
+                           const std::vector<ProcessInfo>& processes) {
+    std::string out = "{\"time\":" + std::to_string(static_cast<long>(time(nullptr))) +
+                      ",\"cpu\":" + std::to_string(stats.total_cpu_usage) +
+                      ",\"mem_total\":" + std::to_string(stats.total_memory) +
+                      ",\"mem_available\":" + std::to_string(stats.available_memory) +
+                      ",\"processes\":[";
+    for (size_t i = 0; i < processes.size(); i++) {
+        if (i) out += ',';
+        append_process_json(out, processes[i]);
+    }
+    out += ']';
+
+    if (options.services) {
+        out += ",\"services\":[";
+        try {
+            auto services = SystemdManager::get_all_services();
+            SystemdManager::update_service_resources(services);
+            for (size_t i = 0; i < services.size(); i++) {
+                if (i) out += ',';
+                out += "{\"name\":";
+                append_json_string(out, services[i].name);
+                out += ",\"active\":";
+                append_json_string(out, services[i].active);
+                out += ",\"pid\":" + std::to_string(services[i].main_pid) +
+                       ",\"cpu\":" + std::to_string(services[i].cpu_usage) +
+                       ",\"memory\":" + std::to_string(services[i].memory_current) +
+                       ",\"tasks\":" + std::to_string(services[i].tasks_current) + "}";
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error collecting services: " << e.what() << std::endl;
+        }
+        out += ']';
+    }
+    out += "}\n";
+    fputs(out.c_str(), stdout);
+}
+
+int BatchMode::run(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    RulesEngine rules;
+    if (!options.rules_path.empty()) {
+        if (!rules.load(options.rules_path)) {
+            std::cerr << "Cannot read rules file " << options.rules_path << std::endl;
+            return 2;
+        }
+        rules.set_dry_run(options.dry_run);
+    }
+    std::unique_ptr<Snapshot> previous;
+
+    // CPU% is a delta against the previous sample, so take one up front
+    ProcParser::get_all_processes();
+    if (options.services) {
+        try {
+            auto services = SystemdManager::get_all_services();
+            SystemdManager::update_service_resources(services);
+        } catch (const std::exception& e) {
+            std::cerr << "Error collecting services: " << e.what() << std::endl;
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(PRIME_INTERVAL_MS));
+
+    auto interval = std::chrono::duration<double>(options.interval);
+    auto next = std::chrono::steady_clock::now();
+
+    for (int i = 0; options.iterations == 0 || i < options.iterations; i++) {
+        if (i > 0) {
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+            std::this_thread::sleep_until(next);
+        }
+
+        auto processes = ProcParser::get_all_processes();
+        SystemStats stats = ProcParser::get_system_stats();
+
+        uint64_t total_mem = stats.total_memory ? stats.total_memory : 1;
+        for (auto& proc : processes) {
+            proc.memory_usage = (static_cast<double>(proc.memory_rss) / total_mem) * 100.0;
+        }
+
+        // Rules work from the process delta, as in the GUI collector
+        if (rules.rule_count()) {
+            std::unique_ptr<Snapshot> current(new Snapshot());
+            current->taken = std::chrono::steady_clock::now();
+            current->stats = stats;
+            current->processes = std::make_shared<const std::vector<ProcessInfo>>(processes);
+            compute_process_delta(previous.get(), *current);
+            rules.evaluate(*current);
+            previous = std::move(current);
+        }
+
+        size_t total = processes.size();
+        auto selected = select_processes(std::move(processes), options);
+
+        switch (options.format) {
+        case Format::TEXT: print_text(options, stats, selected, total); break;
+        case Format::CSV:  print_csv(options, selected, i == 0); break;
+        case Format::JSON: print_json(options, stats, selected); break;
+        }
+
+        // Stop quietly once whoever reads us (head, a closed pipe) goes away
+        if (fflush(stdout) != 0) break;
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "proc_parser.h"
+
+// Headless `taskmgr --batch` mode: prints top-N process snapshots to stdout at
+// a fixed interval, for servers without a display. Never touches GTK.
+class BatchMode {
+public:
+    enum class Format { TEXT, CSV, JSON };
+    enum class SortKey { CPU, MEM, PID, NAME };
+
+    struct Options {
+        Format format = Format::TEXT;
+        SortKey sort = SortKey::CPU;
+        int top = 20;               // 0 prints every matching process
+        int iterations = 1;         // 0 runs until interrupted
+        double interval = 1.0;      // Seconds between snapshots
+        std::string name_filter;    // Case-insensitive substring of the process name
+        std::string user_filter;    // Exact user name
+        bool services = false;      // Also print systemd services
+        std::string rules_path;     // Threshold rules to check every snapshot
+        bool dry_run = false;       // Log rule actions without carrying them out
+    };
+
+    // True if argv asks for batch mode, so main can skip the GUI entirely
+    static bool requested(int argc, char* argv[]);
+    static int run(int argc, char* argv[]);
+
+private:
+    static bool parse_options(int argc, char* argv[], Options& options);
+    static void print_usage(const char* program);
+    static std::vector<ProcessInfo> select_processes(std::vector<ProcessInfo> processes,
+                                                     const Options& options);
+    static void print_text(const Options& options, const SystemStats& stats,
+                           const std::vector<ProcessInfo>& processes, size_t total);
+    static void print_csv(const Options& options, const std::vector<ProcessInfo>& processes,
+                          bool header);
+    static void print_json(const Options& options, const SystemStats& stats,
+                           const std::vector<ProcessInfo>& processes);
+};
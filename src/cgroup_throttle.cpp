@@ -0,0 +1,475 @@
+#include "cgroup_throttle.h"
+#include "proc_parser.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <gio/gio.h>
+
+namespace {
+    const char* SYSTEMD_BUS_NAME = "org.freedesktop.systemd1";
+    const char* SYSTEMD_OBJECT_PATH = "/org/freedesktop/systemd1";
+    const char* SYSTEMD_MANAGER_IFACE = "org.freedesktop.systemd1.Manager";
+    const char* const UNIT_PREFIX = "taskmgr-throttle-";
+
+    // Starting a scope only moves processes, so its job finishes at once
+    const guint JOB_TIMEOUT_SECONDS = 10;
+    // systemd's "infinity" for every limit we set
+    const guint64 NO_LIMIT = G_MAXUINT64;
+
+    // Worker thread only
+    GDBusConnection* bus = nullptr;
+    GMainContext* context = nullptr;
+
+    // The one job being waited on; JobRemoved for every other job is ignored
+    struct JobWait {
+        std::string path;       // Empty until the manager has replied
+        std::string result;
+        bool finished = false;
+    };
+
+    void on_job_removed(GDBusConnection*, const gchar*, const gchar*, const gchar*,
+                        const gchar*, GVariant* parameters, gpointer data) {
+        auto* wait = static_cast<JobWait*>(data);
+        guint32 id;
+        const gchar* job = nullptr;
+        const gchar* unit = nullptr;
+        const gchar* result = nullptr;
+        g_variant_get(parameters, "(u&o&s&s)", &id, &job, &unit, &result);
+        if (wait->path != job) return;
+        wait->result = result;
+        wait->finished = true;
+    }
+
+    gboolean on_job_timeout(gpointer data) {
+        *static_cast<bool*>(data) = true;
+        return G_SOURCE_REMOVE;
+    }
+
+    bool ends_with(const std::string& text, const char* suffix) {
+        size_t len = strlen(suffix);
+        return text.size() >= len && text.compare(text.size() - len, len, suffix) == 0;
+    }
+
+    bool connect_bus(std::string& error) {
+        if (bus) return true;
+
+        // A user can only manage their own processes through their own
+        // systemd instance; root manages the system one
+        GError* gerror = nullptr;
+        bus = g_bus_get_sync(geteuid() == 0 ? G_BUS_TYPE_SYSTEM : G_BUS_TYPE_SESSION, nullptr, &gerror);
+        if (!bus) {
+            error = std::string("cannot reach systemd: ") + gerror->message;
+            g_error_free(gerror);
+            return false;
+        }
+
+        // JobRemoved is dispatched on our own context, only while we wait for a job
+        context = g_main_context_new();
+        return true;
+    }
+
+    GVariant* call_manager(const char* method, GVariant* args, const GVariantType* reply_type,
+                           std::string& error) {
+        GError* gerror = nullptr;
+        GVariant* reply = g_dbus_connection_call_sync(bus, SYSTEMD_BUS_NAME, SYSTEMD_OBJECT_PATH,
+            SYSTEMD_MANAGER_IFACE, method, args, reply_type,
+            G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &gerror);
+        if (!reply) {
+            error = std::string(method) + ": " + gerror->message;
+            g_error_free(gerror);
+        }
+        return reply;
+    }
+
+    // Subscribed before the call that queues the job, since the job can finish
+    // before the reply is read; nothing is dispatched until wait_for_job()
+    guint watch_jobs(JobWait& wait) {
+        g_main_context_push_thread_default(context);
+        guint subscription = g_dbus_connection_signal_subscribe(bus, SYSTEMD_BUS_NAME,
+            SYSTEMD_MANAGER_IFACE, "JobRemoved", SYSTEMD_OBJECT_PATH, nullptr,
+            G_DBUS_SIGNAL_FLAGS_NONE, on_job_removed, &wait, nullptr);
+        g_main_context_pop_thread_default(context);
+        return subscription;
+    }
+
+    void unwatch_jobs(guint subscription) {
+        g_dbus_connection_signal_unsubscribe(bus, subscription);
+        // Drop signals already queued for it; they are never delivered
+        while (g_main_context_iteration(context, FALSE)) {}
+    }
+
+    bool wait_for_job(JobWait& wait, guint subscription, std::string& error) {
+        bool timed_out = false;
+        GSource* timeout = g_timeout_source_new_seconds(JOB_TIMEOUT_SECONDS);
+        g_source_set_callback(timeout, on_job_timeout, &timed_out, nullptr);
+        g_source_attach(timeout, context);
+        while (!wait.finished && !timed_out) {
+            g_main_context_iteration(context, TRUE);
+        }
+        g_source_destroy(timeout);
+        g_source_unref(timeout);
+        unwatch_jobs(subscription);
+
+        if (timed_out) {
+            error = "timed out waiting for job " + wait.path;
+            return false;
+        }
+        if (wait.result != "done") {
+            error = "job " + wait.result;
+            return false;
+        }
+        return true;
+    }
+
+    // Every whole disk, as the device node systemd resolves for IO*BandwidthMax
+    std::vector<std::string> block_devices() {
+        std::vector<std::string> devices;
+        DIR* block = opendir((ProcParser::get_sys_root() + "/block").c_str());
+        if (!block) return devices;
+        struct dirent* entry;
+        while ((entry = readdir(block)) != nullptr) {
+            if (entry->d_name[0] == '.') continue;
+            // Memory-backed devices have nothing to throttle
+            if (!strncmp(entry->d_name, "loop", 4) || !strncmp(entry->d_name, "ram", 3) ||
+                !strncmp(entry->d_name, "zram", 4)) continue;
+            devices.push_back(std::string("/dev/") + entry->d_name);
+        }
+        closedir(block);
+        return devices;
+    }
+
+    // An empty list clears every device's limit
+    GVariant* io_limit(const std::vector<std::string>& devices, uint64_t bps) {
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a(st)"));
+        for (size_t i = 0; bps && i < devices.size(); i++) {
+            g_variant_builder_add(&builder, "(st)", devices[i].c_str(), static_cast<guint64>(bps));
+        }
+        return g_variant_builder_end(&builder);
+    }
+
+    void add_limits(GVariantBuilder* properties, const ThrottleLimits& limits) {
+        guint64 quota = limits.cpu_percent > 0
+            ? static_cast<guint64>(limits.cpu_percent / 100.0 * G_USEC_PER_SEC) : NO_LIMIT;
+        g_variant_builder_add(properties, "(sv)", "CPUQuotaPerSecUSec", g_variant_new_uint64(quota));
+        g_variant_builder_add(properties, "(sv)", "MemoryHigh",
+            g_variant_new_uint64(limits.memory_high ? limits.memory_high : NO_LIMIT));
+
+        std::vector<std::string> devices = block_devices();
+        g_variant_builder_add(properties, "(sv)", "IOReadBandwidthMax", io_limit(devices, limits.io_bps));
+        g_variant_builder_add(properties, "(sv)", "IOWriteBandwidthMax", io_limit(devices, limits.io_bps));
+    }
+
+    GVariant* pid_list(const std::vector<pid_t>& pids) {
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("au"));
+        for (pid_t pid : pids) g_variant_builder_add(&builder, "u", static_cast<guint32>(pid));
+        return g_variant_builder_end(&builder);
+    }
+}
+
+std::string CgroupThrottle::read_cgroup(pid_t pid) {
+    // The unified hierarchy's line is "0::/path"
+    std::ifstream file(ProcParser::get_proc_root() + "/" + std::to_string(pid) + "/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 3, "0::") == 0) return line.substr(3);
+    }
+    return "";
+}
+
+CgroupThrottle::CgroupThrottle() {
+    worker = std::thread([this]() { worker_loop(); });
+}
+
+CgroupThrottle::~CgroupThrottle() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_one();
+    if (worker.joinable()) worker.join();
+
+    // Anything the worker finished is dropped along with its callback
+    if (finished_source) g_source_remove(finished_source);
+}
+
+bool CgroupThrottle::available() {
+    if (!probed) {
+        probed = true;
+        mount = ProcParser::get_sys_root() + "/fs/cgroup";
+        struct stat st;
+        usable = stat((mount + "/cgroup.controllers").c_str(), &st) == 0;
+        if (!usable) error = "cgroup v2 is not mounted at " + mount;
+    }
+    return usable;
+}
+
+std::string CgroupThrottle::unit_name(pid_t leader) {
+    return UNIT_PREFIX + std::to_string(leader) + ".scope";
+}
+
+std::string CgroupThrottle::check_movable(pid_t pid) {
+    std::string path = read_cgroup(pid);
+    std::string who = "PID " + std::to_string(pid);
+    if (path.empty()) return who + " is not in the cgroup v2 hierarchy";
+
+    std::string leaf = path.substr(path.rfind('/') + 1);
+    if (leaf.compare(0, strlen(UNIT_PREFIX), UNIT_PREFIX) == 0) return "";
+
+    // The processes below a user's systemd instance are that instance's to
+    // place; root taking them would break its delegation
+    if (geteuid() != 0) {
+        std::string uid = std::to_string(geteuid());
+        std::string manager = "/user.slice/user-" + uid + ".slice/user@" + uid + ".service/";
+        if (path.compare(0, manager.size(), manager) != 0) {
+            return who + " is not managed by your systemd user instance";
+        }
+    } else if (path.find("/user@") != std::string::npos) {
+        return who + " is managed by a user's systemd instance";
+    }
+
+    if (ends_with(leaf, ".service")) return who + " belongs to " + leaf + "; limit the service instead";
+    if (leaf == "init.scope") return who + " is the service manager";
+    // Below its unit, in a subtree the unit manages itself (containers, delegated services)
+    if (!ends_with(leaf, ".scope")) return who + " is in a cgroup delegated to its unit";
+    return "";
+}
+
+bool CgroupThrottle::start_scope(const std::string& unit, const std::vector<pid_t>& pids,
+                                 const ThrottleLimits& limits, std::string& error) {
+    GVariantBuilder properties;
+    g_variant_builder_init(&properties, G_VARIANT_TYPE("a(sv)"));
+    g_variant_builder_add(&properties, "(sv)", "Description", g_variant_new_string("Throttled by Task Manager"));
+    g_variant_builder_add(&properties, "(sv)", "PIDs", pid_list(pids));
+    add_limits(&properties, limits);
+
+    JobWait wait;
+    guint subscription = watch_jobs(wait);
+    GVariant* aux = g_variant_new_array(G_VARIANT_TYPE("(sa(sv))"), nullptr, 0);
+    GVariant* reply = call_manager("StartTransientUnit",
+        g_variant_new("(ss@a(sv)@a(sa(sv)))", unit.c_str(), "fail", g_variant_builder_end(&properties), aux),
+        G_VARIANT_TYPE("(o)"), error);
+    if (!reply) {
+        unwatch_jobs(subscription);
+        return false;
+    }
+
+    const gchar* job = nullptr;
+    g_variant_get(reply, "(&o)", &job);
+    wait.path = job;
+    g_variant_unref(reply);
+    return wait_for_job(wait, subscription, error);
+}
+
+bool CgroupThrottle::update_scope(const std::string& unit, const std::vector<pid_t>& pids,
+                                  const ThrottleLimits& limits, std::string& error) {
+    GVariantBuilder properties;
+    g_variant_builder_init(&properties, G_VARIANT_TYPE("a(sv)"));
+    add_limits(&properties, limits);
+
+    // Runtime only: the scope does not outlive its processes anyway
+    GVariant* reply = call_manager("SetUnitProperties",
+        g_variant_new("(sb@a(sv))", unit.c_str(), TRUE, g_variant_builder_end(&properties)),
+        nullptr, error);
+    if (!reply) return false;
+    g_variant_unref(reply);
+    if (pids.empty()) return true;
+
+    reply = call_manager("AttachProcessesToUnit",
+        g_variant_new("(ss@au)", unit.c_str(), "", pid_list(pids)), nullptr, error);
+    if (!reply) return false;
+    g_variant_unref(reply);
+    return true;
+}
+
+void CgroupThrottle::throttle(pid_t leader, const std::vector<pid_t>& pids, const ThrottleLimits& limits,
+                              Callback done) {
+    Request request;
+    request.leader = leader;
+    request.pids = pids;
+    request.limits = limits;
+    request.known = groups.count(leader) > 0;
+    request.done = done;
+    if (!available()) {
+        request.message = error;
+        finish(std::move(request));
+        return;
+    }
+    submit(std::move(request));
+}
+
+void CgroupThrottle::release(pid_t leader, Callback done) {
+    Request request;
+    request.release = true;
+    request.leader = leader;
+    request.known = true;
+    request.done = done;
+    if (!groups.count(leader)) {
+        request.message = "process " + std::to_string(leader) + " is not throttled";
+        finish(std::move(request));
+        return;
+    }
+    submit(std::move(request));
+}
+
+void CgroupThrottle::submit(Request&& request) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queue.push_back(std::move(request));
+    }
+    queue_cv.notify_one();
+}
+
+void CgroupThrottle::finish(Request&& request) {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    finished.push_back(std::move(request));
+    if (!finished_source) finished_source = g_idle_add(on_finished, this);
+}
+
+void CgroupThrottle::worker_loop() {
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping) return;
+            request = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        if (connect_bus(request.message)) {
+            if (request.release) {
+                run_release(request);
+            } else {
+                run_throttle(request);
+            }
+        }
+        finish(std::move(request));
+    }
+}
+
+void CgroupThrottle::run_throttle(Request& request) {
+    std::vector<pid_t> movable;
+    std::string refused;
+    for (pid_t pid : request.pids) {
+        std::string reason = check_movable(pid);
+        if (reason.empty()) {
+            movable.push_back(pid);
+        } else if (refused.empty()) {
+            refused = reason;
+        }
+    }
+    if (movable.empty()) {
+        request.message = refused;
+        return;
+    }
+
+    // A scope left from an earlier release, or from a previous run, is still
+    // there as long as anything is in it
+    std::string unit = unit_name(request.leader);
+    std::string ignored;
+    GVariant* existing = request.known ? nullptr
+        : call_manager("GetUnit", g_variant_new("(s)", unit.c_str()), G_VARIANT_TYPE("(o)"), ignored);
+    bool known = request.known || existing;
+    if (existing) g_variant_unref(existing);
+
+    if (!(known ? update_scope(unit, movable, request.limits, request.message)
+                : start_scope(unit, movable, request.limits, request.message))) return;
+
+    for (pid_t pid : movable) {
+        std::string path = read_cgroup(pid);
+        if (ends_with(path, ("/" + unit).c_str())) {
+            request.cgroup = path;
+            break;
+        }
+    }
+    request.ok = true;
+    request.message = refused;
+}
+
+void CgroupThrottle::run_release(Request& request) {
+    request.ok = update_scope(unit_name(request.leader), std::vector<pid_t>(), ThrottleLimits(),
+                              request.message);
+}
+
+int CgroupThrottle::on_finished(void* data) {
+    static_cast<CgroupThrottle*>(data)->apply_finished();
+    return G_SOURCE_REMOVE;
+}
+
+void CgroupThrottle::apply_finished() {
+    std::deque<Request> done;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        done.swap(finished);
+        finished_source = 0;
+    }
+
+    for (Request& request : done) {
+        if (request.ok && request.release) {
+            groups.erase(request.leader);
+        } else if (request.ok) {
+            Group& group = groups[request.leader];
+            group.limits = request.limits;
+            if (!request.cgroup.empty()) group.cgroup = request.cgroup;
+        }
+        if (request.done) request.done(request.ok, request.message);
+    }
+}
+
+pid_t CgroupThrottle::find_leader(const std::string& proc_cgroup) const {
+    if (groups.empty()) return 0;
+
+    // ProcessInfo::cgroup is the raw file; find ".../taskmgr-throttle-N.scope"
+    std::string prefix = std::string("/") + UNIT_PREFIX;
+    size_t at = proc_cgroup.find(prefix);
+    if (at == std::string::npos) return 0;
+    pid_t leader = static_cast<pid_t>(atoi(proc_cgroup.c_str() + at + prefix.size()));
+    return groups.count(leader) ? leader : 0;
+}
+
+const ThrottleLimits* CgroupThrottle::get_limits(pid_t leader) const {
+    auto it = groups.find(leader);
+    return it == groups.end() ? nullptr : &it->second.limits;
+}
+
+std::string CgroupThrottle::describe(const std::string& proc_cgroup) const {
+    pid_t leader = find_leader(proc_cgroup);
+    if (!leader) return "";
+
+    const ThrottleLimits& limits = groups.at(leader).limits;
+    std::ostringstream text;
+    if (limits.cpu_percent > 0) text << "CPU " << limits.cpu_percent << "%  ";
+    if (limits.memory_high) text << "Mem " << limits.memory_high / (1024 * 1024) << " MB  ";
+    if (limits.io_bps) text << "I/O " << limits.io_bps / (1024 * 1024) << " MB/s  ";
+    std::string result = text.str();
+    // Moved but every limit off
+    if (result.empty()) return "None";
+    return result.substr(0, result.size() - 2);
+}
+
+void CgroupThrottle::reap() {
+    // systemd stops an empty scope and removes its cgroup on its own
+    for (auto it = groups.begin(); it != groups.end(); ) {
+        if (it->second.cgroup.empty()) {
+            ++it;
+            continue;
+        }
+        std::ifstream events(mount + it->second.cgroup + "/cgroup.events");
+        std::string key;
+        int value = events ? 1 : 0;
+        while (events >> key >> value) {
+            if (key == "populated") break;
+        }
+        if (value == 0) {
+            it = groups.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include <cstdint>
+#include <sys/types.h>
+
+struct ThrottleLimits {
+    double cpu_percent = 0;     // Of one CPU, as CPUQuota; 0 = unlimited
+    uint64_t memory_high = 0;   // Bytes, reclaim pressure above this; 0 = unlimited
+    uint64_t io_bps = 0;        // Read and write bytes/s on each disk; 0 = unlimited
+};
+
+// Throttles processes by asking systemd to move them into a transient scope
+// (taskmgr-throttle-PID.scope) with CPUQuota, MemoryHigh and IO*BandwidthMax
+// set, one per throttled process and whichever children were moved with it.
+// A normal user talks to their own systemd instance, root to the system one;
+// cgroup files are never written directly. Processes of a service, or of a
+// subtree another manager owns, are refused rather than taken from it. The
+// scope goes away once everything in it has exited.
+//
+// The D-Bus calls, and the wait for systemd's job, run on a worker thread and
+// report back on the UI thread; everything else is UI thread only.
+class CgroupThrottle {
+public:
+    // Runs on the UI thread once the request is done. On success message
+    // holds the reason any PIDs were refused, if some were.
+    typedef std::function<void(bool ok, const std::string& message)> Callback;
+
+    CgroupThrottle();
+    ~CgroupThrottle();
+
+    CgroupThrottle(const CgroupThrottle&) = delete;
+    CgroupThrottle& operator=(const CgroupThrottle&) = delete;
+
+    // False without cgroup v2; see get_error(). Whether systemd can be
+    // reached only shows once a request runs.
+    bool available();
+
+    // Creates (or updates) the scope for leader, applies the limits and moves
+    // pids into it. Refused PIDs still count as success as long as one was moved.
+    void throttle(pid_t leader, const std::vector<pid_t>& pids, const ThrottleLimits& limits, Callback done);
+    // Lifts every limit on leader's scope. systemd cannot move processes back
+    // to the units they came from, so they stay in the scope until they exit.
+    void release(pid_t leader, Callback done);
+
+    // The throttle group a process is in, from ProcessInfo::cgroup; 0 if none
+    pid_t find_leader(const std::string& proc_cgroup) const;
+    const ThrottleLimits* get_limits(pid_t leader) const;
+    // "CPU 50%  Mem 512 MB" for the Processes tab; empty when not throttled
+    std::string describe(const std::string& proc_cgroup) const;
+
+    // Forgets groups whose processes have all exited
+    void reap();
+
+    const std::string& get_error() const { return error; }
+
+private:
+    struct Group {
+        ThrottleLimits limits;
+        std::string cgroup;     // The scope's cgroup, relative to mount
+    };
+
+    struct Request {
+        bool release = false;
+        pid_t leader = 0;
+        std::vector<pid_t> pids;
+        ThrottleLimits limits;
+        bool known = false;     // A group for leader already exists
+        Callback done;
+
+        // Filled in by the worker
+        bool ok = false;
+        std::string message;
+        std::string cgroup;
+    };
+
+    void submit(Request&& request);
+    void finish(Request&& request);
+    void worker_loop();
+    static void run_throttle(Request& request);
+    static void run_release(Request& request);
+    // A GSourceFunc; applies finished requests on the UI thread
+    static int on_finished(void* data);
+    void apply_finished();
+
+    static bool start_scope(const std::string& unit, const std::vector<pid_t>& pids,
+                            const ThrottleLimits& limits, std::string& error);
+    static bool update_scope(const std::string& unit, const std::vector<pid_t>& pids,
+                             const ThrottleLimits& limits, std::string& error);
+    static std::string unit_name(pid_t leader);
+    static std::string check_movable(pid_t pid);
+    static std::string read_cgroup(pid_t pid);
+
+    bool probed = false;
+    bool usable = false;
+    std::string mount;      // cgroup2 mount, normally /sys/fs/cgroup
+    std::map<pid_t, Group> groups;
+    std::string error;
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Request> queue;
+    std::deque<Request> finished;       // Guarded by queue_mutex
+    unsigned int finished_source = 0;   // Idle source for on_finished; guarded by queue_mutex
+    bool stopping = false;
+    std::thread worker;
+};
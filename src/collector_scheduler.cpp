@@ -0,0 +1,126 @@
+#include "collector_scheduler.h"
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+
+CollectorScheduler::CollectorScheduler() {
+    // steady_clock is CLOCK_MONOTONIC on Linux, so deadlines map 1:1 onto the timer
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (timer_fd < 0) perror("timerfd_create");
+
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd < 0) perror("eventfd");
+}
+
+CollectorScheduler::~CollectorScheduler() {
+    if (timer_fd >= 0) close(timer_fd);
+    if (wake_fd >= 0) close(wake_fd);
+}
+
+int CollectorScheduler::add_collector(const char* name, std::chrono::milliseconds period,
+                                      Cost cost, bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.size() >= static_cast<size_t>(MAX_COLLECTORS)) return -1;
+
+    entries.push_back({name, period, cost, enabled, Clock::now()});
+    return static_cast<int>(entries.size() - 1);
+}
+
+void CollectorScheduler::set_enabled(int id, bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (id < 0 || id >= static_cast<int>(entries.size())) return;
+        entries[id].enabled = enabled;
+    }
+    wake();
+}
+
+void CollectorScheduler::trigger(int id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (id < 0 || id >= static_cast<int>(entries.size())) return;
+        entries[id].due = Clock::now();
+    }
+    wake();
+}
+
+void CollectorScheduler::wake() {
+    uint64_t one = 1;
+    if (wake_fd >= 0 && write(wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+const char* CollectorScheduler::get_name(int id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return id >= 0 && id < static_cast<int>(entries.size()) ? entries[id].name : "";
+}
+
+CollectorScheduler::Clock::duration CollectorScheduler::early_slack(const Entry& entry) const {
+    switch (entry.cost) {
+    case CHEAP:    return entry.period / 4;
+    case MODERATE: return entry.period / 10;
+    default:       return Clock::duration::zero();
+    }
+}
+
+void CollectorScheduler::arm_timer(Clock::time_point deadline) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = ns / 1000000000LL;
+    spec.it_value.tv_nsec = ns % 1000000000LL;
+    // An all-zero it_value would disarm the timer rather than fire now
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) spec.it_value.tv_nsec = 1;
+
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        perror("timerfd_settime");
+    }
+}
+
+uint32_t CollectorScheduler::wait_due() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Clock::time_point earliest = Clock::time_point::max();
+        for (const auto& entry : entries) {
+            if (entry.enabled && entry.due < earliest) earliest = entry.due;
+        }
+        if (earliest != Clock::time_point::max()) arm_timer(earliest);
+    }
+
+    struct pollfd fds[2] = {
+        {timer_fd, POLLIN, 0},
+        {wake_fd, POLLIN, 0},
+    };
+    if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+        perror("poll");
+    }
+
+    uint64_t drained;
+    if (fds[0].revents & POLLIN) {
+        if (read(timer_fd, &drained, sizeof(drained)) < 0 && errno != EAGAIN) perror("timerfd read");
+    }
+    if (fds[1].revents & POLLIN) {
+        if (read(wake_fd, &drained, sizeof(drained)) < 0 && errno != EAGAIN) perror("eventfd read");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Clock::time_point now = Clock::now();
+    uint32_t due = 0;
+
+    for (size_t id = 0; id < entries.size(); id++) {
+        Entry& entry = entries[id];
+        if (!entry.enabled || entry.due > now + early_slack(entry)) continue;
+
+        due |= 1u << id;
+        // Advance from the deadline, not from now, so periods do not drift;
+        // after a long stall, restart from now instead of firing a burst
+        entry.due += entry.period;
+        if (entry.due <= now) entry.due = now + entry.period;
+    }
+    return due;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Deadline scheduler for the collector thread. Each collector declares its own
+// period and cost class; wait_due() sleeps on a single absolute timerfd until
+// the earliest deadline and returns every collector due by then. Collectors
+// that would come due shortly afterwards ride along on the same wakeup, within
+// a slack that shrinks as their cost grows, so the thread wakes as rarely as
+// possible without running expensive collectors early.
+class CollectorScheduler {
+public:
+    enum Cost {
+        CHEAP,      // May run up to a quarter period early
+        MODERATE,   // May run up to a tenth of a period early
+        EXPENSIVE   // Never runs early
+    };
+
+    static const int MAX_COLLECTORS = 32;
+
+    CollectorScheduler();
+    ~CollectorScheduler();
+
+    CollectorScheduler(const CollectorScheduler&) = delete;
+    CollectorScheduler& operator=(const CollectorScheduler&) = delete;
+
+    // Returns the collector's id, its bit in wait_due()'s mask. New collectors
+    // are due immediately.
+    int add_collector(const char* name, std::chrono::milliseconds period, Cost cost,
+                      bool enabled = true);
+    void set_enabled(int id, bool enabled);
+
+    // Makes a collector due now and wakes the waiting thread
+    void trigger(int id);
+    // Makes wait_due() return early (with an empty mask if nothing is due)
+    void wake();
+
+    // Blocks until at least one collector is due or wake() is called, then
+    // returns the due set and schedules each one's next deadline
+    uint32_t wait_due();
+
+    const char* get_name(int id) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        const char* name;
+        Clock::duration period;
+        Cost cost;
+        bool enabled;
+        Clock::time_point due;
+    };
+
+    Clock::duration early_slack(const Entry& entry) const;
+    void arm_timer(Clock::time_point deadline);
+
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+    int timer_fd = -1;
+    int wake_fd = -1;
+};
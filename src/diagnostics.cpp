@@ -0,0 +1,61 @@
+#include "diagnostics.h"
+#include <cstdio>
+
+static LatencyHistogram histograms[Diagnostics::PHASE_COUNT];
+
+const char* Diagnostics::phase_name(Phase phase) {
+    switch (phase) {
+    case TICK:     return "tick";
+    case SCAN:     return "scan";
+    case PARSE:    return "parse";
+    case SERVICES: return "services";
+    case DELTA:    return "delta";
+    case MODEL:    return "model";
+    case DRAW:     return "draw";
+    default:       return "unknown";
+    }
+}
+
+LatencyHistogram& Diagnostics::histogram(Phase phase) {
+    return histograms[phase];
+}
+
+void Diagnostics::reset() {
+    for (auto& histogram : histograms) histogram.reset();
+}
+
+std::string Diagnostics::format_report() {
+    std::string report;
+    char line[160];
+
+    snprintf(line, sizeof(line), "%-10s %10s %10s %10s %10s %10s %10s\n",
+             "phase", "count", "mean(us)", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+    report += line;
+
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const LatencyHistogram& h = histograms[i];
+        snprintf(line, sizeof(line), "%-10s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                 phase_name(static_cast<Phase>(i)), static_cast<unsigned long long>(h.count()),
+                 h.mean() / 1000.0, h.percentile(0.50) / 1000.0, h.percentile(0.90) / 1000.0,
+                 h.percentile(0.99) / 1000.0, h.max() / 1000.0);
+        report += line;
+    }
+    return report;
+}
+
+void Diagnostics::append_json(std::string& out) {
+    out += "{\"type\":\"diagnostics\",\"unit\":\"ns\",\"phases\":{";
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const LatencyHistogram& h = histograms[i];
+        if (i) out += ',';
+        out += "\"";
+        out += phase_name(static_cast<Phase>(i));
+        out += "\":{\"count\":" + std::to_string(h.count()) +
+               ",\"mean\":" + std::to_string(static_cast<uint64_t>(h.mean())) +
+               ",\"p50\":" + std::to_string(h.percentile(0.50)) +
+               ",\"p90\":" + std::to_string(h.percentile(0.90)) +
+               ",\"p99\":" + std::to_string(h.percentile(0.99)) +
+               ",\"max\":" + std::to_string(h.max()) + "}";
+    }
+    out += "}}\n";
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <ctime>
+#include "latency_histogram.h"
+#include "trace_recorder.h"
+
+// Always-on timing of the refresh pipeline, one histogram per phase. Shown in
+// the hidden Diagnostics tab (Ctrl+Shift+D) and served over IPC as
+// {"cmd":"diagnostics"}.
+class Diagnostics {
+public:
+    enum Phase {
+        TICK,       // Whole collector tick
+        SCAN,       // /proc walk for all processes
+        PARSE,      // One /proc/[pid] parse
+        SERVICES,   // Service list and cgroup resources
+        DELTA,      // Snapshot diff against the previous tick
+        MODEL,      // Applying a snapshot to the list stores
+        DRAW,       // One performance graph draw
+        PHASE_COUNT
+    };
+
+    static const char* phase_name(Phase phase);
+    static LatencyHistogram& histogram(Phase phase);
+    static void reset();
+
+    static void record(Phase phase, uint64_t ns) { histogram(phase).record(ns); }
+
+    static uint64_t now_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    // Human-readable table, and the same data as one JSON object
+    static std::string format_report();
+    static void append_json(std::string& out);
+
+    // Records the lifetime of the enclosing scope into a phase, and into the
+    // trace timeline while tracing is on
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Phase phase)
+            : phase(phase), traced(TraceRecorder::is_enabled()), started(now_ns()) {
+            if (traced) TraceRecorder::begin(phase_name(phase));
+        }
+        ~ScopedTimer() {
+            record(phase, now_ns() - started);
+            if (traced) TraceRecorder::end(phase_name(phase));
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Phase phase;
+        bool traced;
+        uint64_t started;
+    };
+};
@@ -0,0 +1,94 @@
+#include "disk_stats.h"
+#include "proc_parser.h"
+#include <sys/stat.h>
+#include <cstdio>
+
+namespace {
+    // /proc/diskstats counts in 512-byte sectors whatever the device's block size
+    const double SECTOR_BYTES = 512.0;
+
+    uint64_t delta(uint64_t now, uint64_t before) {
+        // Counters are unsigned long in the kernel and restart if the driver reloads
+        return now >= before ? now - before : 0;
+    }
+}
+
+bool DiskStats::is_whole_disk(const std::string& name) const {
+    // /sys/block lists whole disks only; partitions live under their disk.
+    // Names like "cciss/c0d0" appear there with '!' for '/'.
+    std::string sys_name = name;
+    for (auto& c : sys_name) {
+        if (c == '/') c = '!';
+    }
+    struct stat st;
+    return stat((ProcParser::get_sys_root() + "/block/" + sys_name).c_str(), &st) == 0;
+}
+
+std::vector<DiskDeviceStats> DiskStats::update(std::chrono::steady_clock::time_point when) {
+    std::vector<DiskDeviceStats> disks;
+
+    FILE* file = fopen((ProcParser::get_proc_root() + "/diskstats").c_str(), "r");
+    if (!file) return disks;
+
+    double seconds = generation ? std::chrono::duration<double>(when - last_update).count() : 0;
+    last_update = when;
+    generation++;
+
+    char line[512];
+    char name[64];
+    Counters now;
+    unsigned long long reads, sectors_read, ms_reading, writes, sectors_written, ms_writing, ms_doing_io;
+    while (fgets(line, sizeof(line), file)) {
+        // major minor name reads merged sectors ms writes merged sectors ms in_flight io_ms ...
+        if (sscanf(line, " %*u %*u %63s %llu %*u %llu %llu %llu %*u %llu %llu %*u %llu",
+                   name, &reads, &sectors_read, &ms_reading,
+                   &writes, &sectors_written, &ms_writing, &ms_doing_io) != 8) {
+            continue;
+        }
+        now.reads = reads;
+        now.sectors_read = sectors_read;
+        now.ms_reading = ms_reading;
+        now.writes = writes;
+        now.sectors_written = sectors_written;
+        now.ms_writing = ms_writing;
+        now.ms_doing_io = ms_doing_io;
+
+        auto found = devices.find(name);
+        bool known = found != devices.end();
+        Device& device = known ? found->second : devices[name];
+        if (!known) device.whole_disk = is_whole_disk(name);
+
+        Counters before = device.counters;
+        device.counters = now;
+        device.generation = generation;
+
+        if (!device.whole_disk || (now.reads == 0 && now.writes == 0)) continue;
+
+        DiskDeviceStats stats;
+        stats.name = name;
+        if (known && seconds > 0) {
+            uint64_t completed = delta(now.reads, before.reads) + delta(now.writes, before.writes);
+            uint64_t busy_ms = delta(now.ms_reading, before.ms_reading) + delta(now.ms_writing, before.ms_writing);
+
+            stats.read_bytes_per_sec = delta(now.sectors_read, before.sectors_read) * SECTOR_BYTES / seconds;
+            stats.write_bytes_per_sec = delta(now.sectors_written, before.sectors_written) * SECTOR_BYTES / seconds;
+            stats.read_iops = delta(now.reads, before.reads) / seconds;
+            stats.write_iops = delta(now.writes, before.writes) / seconds;
+            stats.await_ms = completed ? static_cast<double>(busy_ms) / completed : 0;
+            stats.utilization = delta(now.ms_doing_io, before.ms_doing_io) / (seconds * 10.0);
+            if (stats.utilization > 100.0) stats.utilization = 100.0;
+        }
+        disks.push_back(std::move(stats));
+    }
+    fclose(file);
+
+    // Devices gone from the file were detached
+    for (auto it = devices.begin(); it != devices.end(); ) {
+        if (it->second.generation != generation) {
+            it = devices.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return disks;
+}
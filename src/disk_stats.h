@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DiskDeviceStats {
+    std::string name;
+    double read_bytes_per_sec = 0;
+    double write_bytes_per_sec = 0;
+    double read_iops = 0;
+    double write_iops = 0;
+    double await_ms = 0;        // Mean time per completed request, queueing included
+    double utilization = 0;     // Percent of wall time with I/O in flight
+};
+
+// Whole-disk throughput, IOPS, await and utilization from /proc/diskstats
+// deltas. Partitions are left out (they would double-count their disk), as
+// are devices that have never done any I/O, such as unused loop devices.
+// Collector thread only.
+class DiskStats {
+public:
+    // Rates since the previous call; a device seen for the first time reports zeros
+    std::vector<DiskDeviceStats> update(std::chrono::steady_clock::time_point when);
+
+private:
+    struct Counters {
+        uint64_t reads = 0;
+        uint64_t sectors_read = 0;
+        uint64_t ms_reading = 0;
+        uint64_t writes = 0;
+        uint64_t sectors_written = 0;
+        uint64_t ms_writing = 0;
+        uint64_t ms_doing_io = 0;
+    };
+
+    struct Device {
+        bool whole_disk = false;
+        Counters counters;
+        uint64_t generation = 0;
+    };
+
+    bool is_whole_disk(const std::string& name) const;
+
+    uint64_t generation = 0;
+    std::chrono::steady_clock::time_point last_update;
+    std::unordered_map<std::string, Device> devices;
+};
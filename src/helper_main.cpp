@@ -0,0 +1,232 @@
+// taskmgr-helper: the privileged half of PrivilegedHelper.
+//
+// Started once per session through pkexec with a socketpair on stdin/stdout.
+// Reads one request per line ("<id> <op> <target> <value>") and answers each
+// with "<id> <status> <message>". Service operations go straight to systemd
+// over D-Bus and wait for the job result, so no process is spawned per request.
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <gio/gio.h>
+
+namespace {
+    const char* SYSTEMD_BUS_NAME = "org.freedesktop.systemd1";
+    const char* SYSTEMD_OBJECT_PATH = "/org/freedesktop/systemd1";
+    const char* SYSTEMD_MANAGER_IFACE = "org.freedesktop.systemd1.Manager";
+
+    // Longer than systemd's default start timeout, so a slow unit still reports
+    // its own result; only a JobRemoved that never comes runs into this
+    const guint JOB_TIMEOUT_SECONDS = 120;
+
+    GDBusConnection* bus = nullptr;
+    GMainContext* context = nullptr;
+
+    // The one job being waited on; JobRemoved for every other job is ignored
+    struct JobWait {
+        std::string path;       // Empty until the manager has replied
+        std::string result;
+        bool finished = false;
+    };
+
+    void on_job_removed(GDBusConnection*, const gchar*, const gchar*, const gchar*,
+                        const gchar*, GVariant* parameters, gpointer data) {
+        auto* wait = static_cast<JobWait*>(data);
+        guint32 id;
+        const gchar* job = nullptr;
+        const gchar* unit = nullptr;
+        const gchar* result = nullptr;
+        g_variant_get(parameters, "(u&o&s&s)", &id, &job, &unit, &result);
+        if (wait->path != job) return;
+        wait->result = result;
+        wait->finished = true;
+    }
+
+    gboolean on_job_timeout(gpointer data) {
+        *static_cast<bool*>(data) = true;
+        return G_SOURCE_REMOVE;
+    }
+
+    bool valid_unit_name(const std::string& name) {
+        if (name.empty() || name.size() > 255 || name[0] == '-') return false;
+        for (char c : name) {
+            if (!isalnum(static_cast<unsigned char>(c)) && !strchr(":-_.@\\", c)) return false;
+        }
+        return name.find('.') != std::string::npos;
+    }
+
+    int call_manager(const char* method, GVariant* args, const GVariantType* reply_type,
+                     GVariant** reply, std::string& message) {
+        GError* error = nullptr;
+        GVariant* result = g_dbus_connection_call_sync(bus, SYSTEMD_BUS_NAME, SYSTEMD_OBJECT_PATH,
+            SYSTEMD_MANAGER_IFACE, method, args, reply_type,
+            G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &error);
+        if (!result) {
+            message = error->message;
+            g_error_free(error);
+            return 1;
+        }
+        if (reply) {
+            *reply = result;
+        } else {
+            g_variant_unref(result);
+        }
+        return 0;
+    }
+
+    // StartUnit/StopUnit/RestartUnit only queue a job; wait for its JobRemoved
+    // so the caller gets the same answer systemctl would give
+    int run_unit_job(const char* method, const std::string& unit, std::string& message) {
+        // Subscribed before the call, since the job can finish before the reply
+        // is read; nothing is dispatched until the loop below, by which time
+        // the job's path is known
+        JobWait wait;
+        guint subscription = g_dbus_connection_signal_subscribe(bus, SYSTEMD_BUS_NAME,
+            SYSTEMD_MANAGER_IFACE, "JobRemoved", SYSTEMD_OBJECT_PATH, nullptr,
+            G_DBUS_SIGNAL_FLAGS_NONE, on_job_removed, &wait, nullptr);
+
+        GVariant* reply = nullptr;
+        int status = call_manager(method, g_variant_new("(ss)", unit.c_str(), "replace"),
+                                  G_VARIANT_TYPE("(o)"), &reply, message);
+        if (status != 0) {
+            g_dbus_connection_signal_unsubscribe(bus, subscription);
+            return status;
+        }
+
+        const gchar* job = nullptr;
+        g_variant_get(reply, "(&o)", &job);
+        wait.path = job;
+        g_variant_unref(reply);
+
+        bool timed_out = false;
+        GSource* timeout = g_timeout_source_new_seconds(JOB_TIMEOUT_SECONDS);
+        g_source_set_callback(timeout, on_job_timeout, &timed_out, nullptr);
+        g_source_attach(timeout, context);
+
+        while (!wait.finished && !timed_out) {
+            g_main_context_iteration(context, TRUE);
+        }
+        g_source_destroy(timeout);
+        g_source_unref(timeout);
+        g_dbus_connection_signal_unsubscribe(bus, subscription);
+
+        if (timed_out) {
+            message = "timed out waiting for job " + wait.path;
+            return ETIMEDOUT;
+        }
+        if (wait.result != "done") {
+            message = "job " + wait.result;
+            return 1;
+        }
+        return 0;
+    }
+
+    int set_unit_file_state(const std::string& unit, bool enable, std::string& message) {
+        const gchar* files[] = {unit.c_str(), nullptr};
+        int status = enable
+            ? call_manager("EnableUnitFiles", g_variant_new("(^asbb)", files, FALSE, FALSE),
+                           G_VARIANT_TYPE("(ba(sss))"), nullptr, message)
+            : call_manager("DisableUnitFiles", g_variant_new("(^asb)", files, FALSE),
+                           G_VARIANT_TYPE("(a(sss))"), nullptr, message);
+        if (status != 0) return status;
+        return call_manager("Reload", nullptr, nullptr, nullptr, message);
+    }
+
+    int handle_request(const std::string& op, const std::string& target, int value, std::string& message) {
+        if (op == "signal" || op == "renice") {
+            char* end = nullptr;
+            long pid = strtol(target.c_str(), &end, 10);
+            if (*end != '\0' || pid <= 1) {
+                message = "invalid pid";
+                return EINVAL;
+            }
+
+            int rc;
+            if (op == "signal") {
+                if (value != SIGTERM && value != SIGKILL && value != SIGSTOP && value != SIGCONT) {
+                    message = "signal not allowed";
+                    return EINVAL;
+                }
+                rc = kill(static_cast<pid_t>(pid), value);
+            } else {
+                if (value < -20 || value > 19) {
+                    message = "nice out of range";
+                    return EINVAL;
+                }
+                rc = setpriority(PRIO_PROCESS, static_cast<id_t>(pid), value);
+            }
+            if (rc != 0) {
+                message = strerror(errno);
+                return errno;
+            }
+            return 0;
+        }
+
+        if (!valid_unit_name(target)) {
+            message = "invalid unit name";
+            return EINVAL;
+        }
+        if (!bus) {
+            message = "system bus unavailable";
+            return 1;
+        }
+
+        if (op == "start") return run_unit_job("StartUnit", target, message);
+        if (op == "stop") return run_unit_job("StopUnit", target, message);
+        if (op == "restart") return run_unit_job("RestartUnit", target, message);
+        if (op == "enable") return set_unit_file_state(target, true, message);
+        if (op == "disable") return set_unit_file_state(target, false, message);
+        if (op == "enable-now") {
+            int status = set_unit_file_state(target, true, message);
+            return status != 0 ? status : run_unit_job("StartUnit", target, message);
+        }
+
+        message = "unknown operation";
+        return EINVAL;
+    }
+}
+
+int main() {
+    if (geteuid() != 0) {
+        std::cerr << "taskmgr-helper must be started through pkexec" << std::endl;
+        return 1;
+    }
+
+    // JobRemoved is dispatched on our own context while we wait for a job
+    context = g_main_context_new();
+    g_main_context_push_thread_default(context);
+
+    GError* error = nullptr;
+    bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &error);
+    if (bus) {
+        std::string message;
+        call_manager("Subscribe", nullptr, nullptr, nullptr, message);
+    } else {
+        std::cerr << "Failed to connect to system bus: " << error->message << std::endl;
+        g_error_free(error);
+    }
+
+    std::cout << "ready" << std::endl;
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream iss(line);
+        std::string id, op, target;
+        int value = 0;
+        iss >> id >> op >> target >> value;
+
+        std::string message;
+        int status = handle_request(op, target, value, message);
+        for (auto& c : message) {
+            if (c == '\n') c = ' ';
+        }
+        std::cout << id << ' ' << status << ' ' << message << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "inspector_window.h"
+#include <algorithm>
+
+namespace {
+    const char* const COLUMN_TITLES[ProcessInspector::SECTION_COUNT][2] = {
+        {"FD", "Target"},
+        {"Address", "Perms  Offset  Device  Inode  Path"},
+        {"Limit", "Soft / Hard"},
+        {"Variable", "Value"},
+        {"Argument", "Value"},
+        {"", "Value"},
+    };
+}
+
+void InspectorWindow::open(GtkWindow* parent, pid_t pid, const std::string& name) {
+    new InspectorWindow(parent, pid, name);
+}
+
+InspectorWindow::InspectorWindow(GtkWindow* parent, pid_t pid, const std::string& name) {
+    inspector.reset(new ProcessInspector(pid, [this](ProcessInspector::Batch&& batch) {
+        receive(std::move(batch));
+    }));
+
+    window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gchar* title = g_strdup_printf("%s (PID %d)", name.c_str(), pid);
+    gtk_window_set_title(GTK_WINDOW(window), title);
+    g_free(title);
+    gtk_window_set_transient_for(GTK_WINDOW(window), parent);
+    gtk_window_set_default_size(GTK_WINDOW(window), 800, 500);
+
+    GtkWidget* notebook = gtk_notebook_new();
+    for (int i = 0; i < ProcessInspector::SECTION_COUNT; i++) {
+        auto section = static_cast<ProcessInspector::Section>(i);
+        gtk_notebook_append_page(GTK_NOTEBOOK(notebook), create_page(section),
+                                 gtk_label_new(ProcessInspector::section_name(section)));
+    }
+    gtk_container_add(GTK_CONTAINER(window), notebook);
+
+    // Connected after the pages exist so appending them does not request anything
+    g_signal_connect(notebook, "switch-page", G_CALLBACK(on_switch_page), this);
+    g_signal_connect(window, "destroy", G_CALLBACK(on_destroy), this);
+    inspector->request(ProcessInspector::FDS);
+
+    gtk_widget_show_all(window);
+}
+
+InspectorWindow::~InspectorWindow() {
+    // Joins the worker, so receive() cannot queue another idle after this
+    inspector.reset();
+
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    if (idle_source) g_source_remove(idle_source);
+}
+
+GtkWidget* InspectorWindow::create_page(ProcessInspector::Section section) {
+    Page& page = pages[section];
+
+    GtkWidget* vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(vbox), 5);
+
+    page.status = GTK_LABEL(gtk_label_new("Loading..."));
+    gtk_widget_set_halign(GTK_WIDGET(page.status), GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(page.status), FALSE, FALSE, 0);
+
+    page.store = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_STRING);
+    GtkWidget* treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(page.store));
+    g_object_unref(page.store);
+
+    // Fixed-height rows let GTK skip measuring every appended row, which
+    // dominates the cost of filling a list with 100k entries
+    for (int i = 0; i < 2; i++) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
+            COLUMN_TITLES[section][i], renderer, "text", i, nullptr);
+        gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
+        gtk_tree_view_column_set_fixed_width(column, i == 0 ? 200 : 560);
+        gtk_tree_view_column_set_resizable(column, TRUE);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
+    }
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(treeview), TRUE);
+
+    GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_container_add(GTK_CONTAINER(scrolled), treeview);
+    gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
+
+    return vbox;
+}
+
+void InspectorWindow::receive(ProcessInspector::Batch&& batch) {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    pending.push_back(std::move(batch));
+    if (!idle_source) idle_source = g_idle_add(on_idle, this);
+}
+
+bool InspectorWindow::apply_pending() {
+    ProcessInspector::Batch* batch;
+    {
+        // deque::push_back keeps references to existing elements valid, so
+        // the front batch can be read outside the lock
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        if (pending.empty()) {
+            idle_source = 0;
+            return false;
+        }
+        batch = &pending.front();
+    }
+
+    Page& page = pages[batch->section];
+    size_t end = std::min(batch->rows.size(), pending_offset + ROWS_PER_IDLE);
+    for (size_t i = pending_offset; i < end; i++) {
+        gtk_list_store_insert_with_values(page.store, nullptr, -1,
+                                          0, batch->rows[i].first.c_str(),
+                                          1, batch->rows[i].second.c_str(), -1);
+    }
+    page.rows += end - pending_offset;
+    pending_offset = end;
+
+    bool finished = pending_offset == batch->rows.size();
+    gchar* status;
+    if (finished && batch->done && !batch->error.empty()) {
+        status = g_strdup_printf("Could not read: %s", batch->error.c_str());
+    } else if (finished && batch->done) {
+        status = g_strdup_printf("%zu entries", page.rows);
+    } else {
+        status = g_strdup_printf("Loading... %zu entries", page.rows);
+    }
+    gtk_label_set_text(page.status, status);
+    g_free(status);
+
+    if (finished) {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending.pop_front();
+        pending_offset = 0;
+    }
+    return true;
+}
+
+gboolean InspectorWindow::on_idle(gpointer data) {
+    auto* self = static_cast<InspectorWindow*>(data);
+    return self->apply_pending() ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+void InspectorWindow::on_switch_page(GtkNotebook*, GtkWidget*, guint page_num, gpointer data) {
+    auto* self = static_cast<InspectorWindow*>(data);
+    if (page_num < ProcessInspector::SECTION_COUNT) {
+        self->inspector->request(static_cast<ProcessInspector::Section>(page_num));
+    }
+}
+
+void InspectorWindow::on_destroy(GtkWidget*, gpointer data) {
+    delete static_cast<InspectorWindow*>(data);
+}
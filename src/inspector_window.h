@@ -0,0 +1,55 @@
+#pragma once
+
+#include <gtk/gtk.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "process_inspector.h"
+
+// Toplevel window showing one process's fds, maps, limits, environment,
+// command line and wait channel, one notebook page per section. A section is
+// only read once its page is shown; rows arrive from the inspector's worker
+// and are appended in bounded slices per idle callback so the UI keeps
+// painting while a large section streams in. Owns itself: open() returns
+// immediately and the object is deleted when the window is destroyed.
+class InspectorWindow {
+public:
+    static void open(GtkWindow* parent, pid_t pid, const std::string& name);
+
+    InspectorWindow(const InspectorWindow&) = delete;
+    InspectorWindow& operator=(const InspectorWindow&) = delete;
+
+private:
+    // Rows appended per idle callback; larger stalls frames, smaller makes
+    // big sections take needlessly long to fill
+    static const size_t ROWS_PER_IDLE = 2000;
+
+    struct Page {
+        GtkListStore* store = nullptr;
+        GtkLabel* status = nullptr;
+        size_t rows = 0;
+    };
+
+    InspectorWindow(GtkWindow* parent, pid_t pid, const std::string& name);
+    ~InspectorWindow();
+
+    GtkWidget* create_page(ProcessInspector::Section section);
+    void receive(ProcessInspector::Batch&& batch);    // Worker thread
+    bool apply_pending();                             // UI thread
+
+    static gboolean on_idle(gpointer data);
+    static void on_switch_page(GtkNotebook* notebook, GtkWidget* page, guint page_num, gpointer data);
+    static void on_destroy(GtkWidget* widget, gpointer data);
+
+    GtkWidget* window = nullptr;
+    Page pages[ProcessInspector::SECTION_COUNT];
+
+    // Worker -> UI hand-off; one idle source at a time drains it
+    std::mutex pending_mutex;
+    std::deque<ProcessInspector::Batch> pending;
+    size_t pending_offset = 0;   // Rows of pending.front() already applied
+    guint idle_source = 0;
+
+    std::unique_ptr<ProcessInspector> inspector;
+};
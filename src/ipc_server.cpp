@@ -1,9 +1,75 @@
 #include "ipc_server.h"
+#include "snapshot.h"
+#include "diagnostics.h"
+#include "trace_recorder.h"
+#include "debug.h"
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
 #include <cstring>
+#include <cstdlib>
 #include <iostream>
+#include <algorithm>
+#include <vector>
+
+namespace {
+    const size_t MAX_REQUEST_LINE = 4096;
+    // A subscriber that falls this far behind is disconnected rather than buffered forever
+    const size_t MAX_CLIENT_BACKLOG = 8 * 1024 * 1024;
+
+    // Minimal field lookup for our flat request objects: "key":"value" or "key":123
+    std::string json_field(const std::string& line, const char* key) {
+        std::string needle = std::string("\"") + key + "\"";
+        size_t pos = line.find(needle);
+        if (pos == std::string::npos) return "";
+        pos = line.find(':', pos + needle.size());
+        if (pos == std::string::npos) return "";
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos) return "";
+
+        if (line[pos] == '"') {
+            size_t end = line.find('"', pos + 1);
+            return end == std::string::npos ? "" : line.substr(pos + 1, end - pos - 1);
+        }
+        size_t end = line.find_first_of(",} \t", pos);
+        return line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    }
+
+    void append_snapshot_json(std::string& out, const Snapshot& snapshot) {
+        char header[256];
+        snprintf(header, sizeof(header),
+                 "{\"type\":\"snapshot\",\"seq\":%llu,\"cpu\":%.2f,\"mem_total\":%llu,\"mem_available\":%llu,\"processes\":[",
+                 static_cast<unsigned long long>(snapshot.sequence), snapshot.stats.total_cpu_usage,
+                 static_cast<unsigned long long>(snapshot.stats.total_memory),
+                 static_cast<unsigned long long>(snapshot.stats.available_memory));
+        out += header;
+        const std::vector<ProcessInfo>& processes = *snapshot.processes;
+        for (size_t i = 0; i < processes.size(); i++) {
+            if (i) out += ',';
+            append_process_json(out, processes[i]);
+        }
+        out += "]}\n";
+    }
+
+    void append_delta_json(std::string& out, const Snapshot& snapshot) {
+        out += "{\"type\":\"delta\",\"seq\":" + std::to_string(snapshot.sequence) + ",\"removed\":[";
+        const ProcessDelta& delta = snapshot.process_delta;
+        for (size_t i = 0; i < delta.removed.size(); i++) {
+            if (i) out += ',';
+            out += std::to_string(delta.removed[i]);
+        }
+        out += "],\"updated\":[";
+        for (size_t i = 0; i < delta.updated.size(); i++) {
+            if (i) out += ',';
+            append_process_json(out, (*snapshot.processes)[delta.updated[i]]);
+        }
+        out += "]}\n";
+    }
+}
 
 IpcServer& IpcServer::get_instance() {
     static IpcServer instance;
@@ -24,7 +90,7 @@ IpcServer::~IpcServer() {
 
 bool IpcServer::start_server() {
     // Create socket
-    socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    socket_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (socket_fd < 0) {
         perror("socket");
         return false;
@@ -45,23 +111,66 @@ bool IpcServer::start_server() {
     }
     
     // Listen for connections
-    if (listen(socket_fd, 1) < 0) {
+    if (listen(socket_fd, SOMAXCONN) < 0) {
         perror("listen");
         close(socket_fd);
         return false;
     }
-    
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    {
+        std::lock_guard<std::mutex> lock(latest_mutex);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    if (epoll_fd < 0 || wake_fd < 0) {
+        perror("epoll");
+        stop_server();
+        return false;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = socket_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_fd, &ev);
+    ev.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
     server_running = true;
+    server_thread = std::thread([this]() { serve_loop(); });
     return true;
 }
 
 void IpcServer::stop_server() {
+    if (server_running.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    if (server_thread.joinable()) {
+        server_thread.join();
+    }
+
+    for (auto& pair : clients) {
+        close(pair.first);
+    }
+    clients.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(latest_mutex);
+        if (wake_fd >= 0) {
+            close(wake_fd);
+            wake_fd = -1;
+        }
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
     if (socket_fd >= 0) {
         close(socket_fd);
         socket_fd = -1;
+        unlink(socket_path.c_str());
     }
-    unlink(socket_path.c_str());
-    server_running = false;
 }
 
 bool IpcServer::is_running() const {
@@ -70,4 +179,269 @@ bool IpcServer::is_running() const {
 
 std::string IpcServer::get_socket_path() const {
     return socket_path;
-}
\ No newline at end of file
+}
+
+void IpcServer::publish_snapshot(std::shared_ptr<const Snapshot> snapshot) {
+    // Under the lock so stop_server() cannot close wake_fd mid-write and hand
+    // the number to something else
+    std::lock_guard<std::mutex> lock(latest_mutex);
+    latest = std::move(snapshot);
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+std::shared_ptr<const Snapshot> IpcServer::get_latest() const {
+    std::lock_guard<std::mutex> lock(latest_mutex);
+    return latest;
+}
+
+void IpcServer::serve_loop() {
+    struct epoll_event events[64];
+
+    while (server_running) {
+        int count = epoll_wait(epoll_fd, events, 64, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == wake_fd) {
+                uint64_t value;
+                while (read(wake_fd, &value, sizeof(value)) > 0) {}
+                if (server_running) broadcast_latest();
+                continue;
+            }
+            if (fd == socket_fd) {
+                accept_clients();
+                continue;
+            }
+
+            auto it = clients.find(fd);
+            if (it == clients.end()) continue;
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_client(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                flush_client(it->second);
+            }
+            // flush_client may have dropped the client
+            it = clients.find(fd);
+            if (it != clients.end() && (events[i].events & EPOLLIN)) {
+                read_client(it->second);
+            }
+        }
+    }
+}
+
+void IpcServer::accept_clients() {
+    for (;;) {
+        int fd = accept4(socket_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            continue;
+        }
+
+        Client client;
+        client.fd = fd;
+        clients[fd] = client;
+    }
+}
+
+void IpcServer::read_client(Client& client) {
+    int fd = client.fd;
+    char buffer[4096];
+
+    for (;;) {
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        if (len < 0 && errno == EINTR) continue;
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (len < 0) {
+            close_client(fd);
+            return;
+        }
+        if (len == 0) {
+            // Half-closed: answer what was already sent, then drop the connection
+            client.closing = true;
+            break;
+        }
+        client.in_buffer.append(buffer, len);
+    }
+
+    size_t newline;
+    while ((newline = client.in_buffer.find('\n')) != std::string::npos) {
+        std::string line = client.in_buffer.substr(0, newline);
+        client.in_buffer.erase(0, newline + 1);
+        handle_request(client, line);
+    }
+
+    if (client.in_buffer.size() > MAX_REQUEST_LINE) {
+        close_client(fd);
+        return;
+    }
+    flush_client(client);
+}
+
+void IpcServer::handle_request(Client& client, const std::string& line) {
+    std::string cmd = json_field(line, "cmd");
+    std::shared_ptr<const Snapshot> snapshot = get_latest();
+
+    if (cmd == "unsubscribe") {
+        client.subscribed = false;
+        client.out_buffer += "{\"type\":\"ok\"}\n";
+        return;
+    }
+
+    if (cmd == "diagnostics") {
+        Diagnostics::append_json(client.out_buffer);
+        return;
+    }
+
+    if (cmd == "trace") {
+        std::string action = json_field(line, "action");
+        if (action == "start" || action == "stop") {
+            TraceRecorder::set_enabled(action == "start");
+            client.out_buffer += "{\"type\":\"ok\"}\n";
+        } else if (action == "dump") {
+            std::string seconds = json_field(line, "seconds");
+            std::string path = TraceRecorder::default_dump_path();
+            if (TraceRecorder::dump(path, seconds.empty() ? 10.0 : std::max(0.0, atof(seconds.c_str())))) {
+                client.out_buffer += "{\"type\":\"trace\",\"path\":";
+                append_json_string(client.out_buffer, path);
+                client.out_buffer += "}\n";
+            } else {
+                client.out_buffer += "{\"type\":\"error\",\"message\":\"trace dump failed\"}\n";
+            }
+        } else {
+            client.out_buffer += "{\"type\":\"error\",\"message\":\"unknown trace action\"}\n";
+        }
+        return;
+    }
+
+    if (!snapshot) {
+        client.out_buffer += "{\"type\":\"error\",\"message\":\"no snapshot yet\"}\n";
+        // Subscribers still get the first snapshot once it exists
+        if (cmd == "subscribe") client.subscribed = true;
+        return;
+    }
+
+    if (cmd == "snapshot") {
+        append_snapshot_json(client.out_buffer, *snapshot);
+    } else if (cmd == "subscribe") {
+        // Start from a full snapshot; deltas follow from the next tick on
+        client.subscribed = true;
+        append_snapshot_json(client.out_buffer, *snapshot);
+    } else if (cmd == "top") {
+        std::string n_field = json_field(line, "n");
+        size_t n = n_field.empty() ? 10 : static_cast<size_t>(std::max(0L, strtol(n_field.c_str(), nullptr, 10)));
+        bool by_mem = json_field(line, "sort") == "mem";
+
+        std::vector<const ProcessInfo*> procs;
+        procs.reserve(snapshot->processes->size());
+        for (const auto& proc : *snapshot->processes) procs.push_back(&proc);
+        n = std::min(n, procs.size());
+
+        std::partial_sort(procs.begin(), procs.begin() + n, procs.end(),
+            [by_mem](const ProcessInfo* a, const ProcessInfo* b) {
+                return by_mem ? a->memory_rss > b->memory_rss : a->cpu_usage > b->cpu_usage;
+            });
+
+        client.out_buffer += "{\"type\":\"top\",\"seq\":" + std::to_string(snapshot->sequence) +
+                             ",\"sort\":\"" + (by_mem ? "mem" : "cpu") + "\",\"processes\":[";
+        for (size_t i = 0; i < n; i++) {
+            if (i) client.out_buffer += ',';
+            append_process_json(client.out_buffer, *procs[i]);
+        }
+        client.out_buffer += "]}\n";
+    } else {
+        client.out_buffer += "{\"type\":\"error\",\"message\":\"unknown cmd\"}\n";
+    }
+}
+
+void IpcServer::broadcast_latest() {
+    std::shared_ptr<const Snapshot> snapshot = get_latest();
+    if (!snapshot || snapshot->sequence == last_broadcast_seq) return;
+
+    // A delta is only valid against the snapshot subscribers saw last
+    bool contiguous = !snapshot->process_delta.full && snapshot->sequence == last_broadcast_seq + 1;
+    last_broadcast_seq = snapshot->sequence;
+
+    std::string message;
+    std::vector<int> fds;
+    for (auto& pair : clients) {
+        if (!pair.second.subscribed) continue;
+        if (message.empty()) {
+            if (contiguous) {
+                append_delta_json(message, *snapshot);
+            } else {
+                append_snapshot_json(message, *snapshot);
+            }
+        }
+        pair.second.out_buffer += message;
+        fds.push_back(pair.first);
+    }
+
+    for (int fd : fds) {
+        auto it = clients.find(fd);
+        if (it != clients.end()) flush_client(it->second);
+    }
+}
+
+void IpcServer::flush_client(Client& client) {
+    int fd = client.fd;
+
+    while (!client.out_buffer.empty()) {
+        ssize_t len = send(fd, client.out_buffer.data(), client.out_buffer.size(), MSG_NOSIGNAL);
+        if (len < 0 && errno == EINTR) continue;
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (len < 0) {
+            close_client(fd);
+            return;
+        }
+        client.out_buffer.erase(0, len);
+    }
+
+    if (client.closing && client.out_buffer.empty()) {
+        close_client(fd);
+        return;
+    }
+
+    if (client.out_buffer.size() > MAX_CLIENT_BACKLOG) {
+        DEBUG_ACTION(std::cerr << "DEBUG: dropping slow IPC client " << fd << std::endl);
+        close_client(fd);
+        return;
+    }
+
+    // Only ask for EPOLLOUT while there is something left to send
+    bool want_write = !client.out_buffer.empty();
+    if (want_write != client.want_write || client.closing) {
+        struct epoll_event ev = {};
+        ev.events = (client.closing ? 0u : static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP)) |
+                    (want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+        client.want_write = want_write;
+    }
+}
+
+void IpcServer::close_client(int fd) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    clients.erase(fd);
+}
@@ -1,7 +1,24 @@
 #pragma once
 
 #include <string>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <cstdint>
 
+struct Snapshot;
+
+// Owns $XDG_RUNTIME_DIR/linux-taskmanager.sock. Besides claiming the single
+// instance, it serves JSON-lines requests from local clients on an epoll loop:
+//   {"cmd":"snapshot"}                     latest full snapshot
+//   {"cmd":"top","n":10,"sort":"cpu"}      top N processes by cpu or mem
+//   {"cmd":"subscribe"}                    full snapshot, then one delta per tick
+//   {"cmd":"unsubscribe"}
+//   {"cmd":"diagnostics"}                  refresh pipeline latency histograms
+//   {"cmd":"trace","action":"start"}       start/stop recording; "dump" writes the
+//                                          last "seconds" (10) as a Chrome trace
 class IpcServer {
 public:
     static IpcServer& get_instance();
@@ -12,6 +29,9 @@ public:
 
     std::string get_socket_path() const;
 
+    // Called by the collector after each tick; wakes the server to stream deltas
+    void publish_snapshot(std::shared_ptr<const Snapshot> snapshot);
+
     IpcServer(const IpcServer&) = delete;
     IpcServer& operator=(const IpcServer&) = delete;
 
@@ -19,7 +39,34 @@ private:
     IpcServer();
     ~IpcServer();
 
+    struct Client {
+        int fd = -1;
+        std::string in_buffer;
+        std::string out_buffer;
+        bool subscribed = false;
+        bool want_write = false;
+        bool closing = false;   // Peer shut down its write side; close once replies are sent
+    };
+
+    void serve_loop();
+    void accept_clients();
+    void read_client(Client& client);
+    void handle_request(Client& client, const std::string& line);
+    void flush_client(Client& client);
+    void close_client(int fd);
+    void broadcast_latest();
+    std::shared_ptr<const Snapshot> get_latest() const;
+
     int socket_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1;                   // Guarded by latest_mutex; the collector writes it
     std::string socket_path;
-    bool server_running = false;
-};
\ No newline at end of file
+    std::atomic<bool> server_running{false};   // Cleared by stop_server, polled by the server thread
+    std::thread server_thread;
+
+    std::map<int, Client> clients;      // Server thread only
+    uint64_t last_broadcast_seq = 0;    // Server thread only
+
+    mutable std::mutex latest_mutex;    // Also guards wake_fd
+    std::shared_ptr<const Snapshot> latest;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Fixed-size log-linear histogram of nanosecond latencies, HdrHistogram-style:
+// every power of two is split into SUB_BUCKETS linear buckets, so a reported
+// percentile is within 1/SUB_BUCKETS of the true value. record() is a handful
+// of relaxed atomics and never allocates, so it is safe on any thread.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int MAGNITUDES = 40;  // Up to 2^43 ns, about two hours
+    static const int BUCKETS = MAGNITUDES * SUB_BUCKETS;
+
+    LatencyHistogram() { reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t ns) {
+        buckets[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(ns, std::memory_order_relaxed);
+
+        uint64_t seen = largest.load(std::memory_order_relaxed);
+        while (ns > seen && !largest.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    }
+
+    void reset() {
+        for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        largest.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return largest.load(std::memory_order_relaxed); }
+
+    double mean() const {
+        uint64_t n = count();
+        return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+    }
+
+    // Value at quantile q in [0, 1]; readers may race with writers, which
+    // only skews the answer by the samples recorded meanwhile
+    uint64_t percentile(double q) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+
+        uint64_t rank = static_cast<uint64_t>(q * (n - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t value = bucket_upper(i);
+                return value < max() ? value : max();
+            }
+        }
+        return max();
+    }
+
+private:
+    static int bucket_index(uint64_t value) {
+        if (value < static_cast<uint64_t>(SUB_BUCKETS)) return static_cast<int>(value);
+
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - SUB_BITS;
+        int index = (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) - SUB_BUCKETS);
+        return index < BUCKETS ? index : BUCKETS - 1;
+    }
+
+    static uint64_t bucket_upper(int index) {
+        if (index < SUB_BUCKETS) return index;
+
+        int shift = index / SUB_BUCKETS - 1;
+        uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower + (1ULL << shift) - 1;
+    }
+
+    std::atomic<uint32_t> buckets[BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> largest;
+};
@@ -0,0 +1,203 @@
+#include "link_stats.h"
+#include "proc_parser.h"
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+LinkStats::LinkStats() : buffer(65536) {
+    netlink_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (netlink_fd < 0) perror("socket(NETLINK_ROUTE)");
+}
+
+LinkStats::~LinkStats() {
+    if (netlink_fd >= 0) close(netlink_fd);
+}
+
+uint64_t LinkStats::counter_delta(uint64_t now, uint64_t before) {
+    if (now >= before) return now - before;
+    // Some drivers still keep 32-bit counters behind the 64-bit fields. Only
+    // a counter that was in its top quarter can have wrapped within one tick;
+    // anything else going backwards was reset (driver reload, counters
+    // cleared) and starts over from here, rather than showing as a 4 GiB spike.
+    if (before <= UINT32_MAX && before >= (3ULL << 30) && now < (1ULL << 30)) {
+        return now + (1ULL << 32) - before;
+    }
+    return 0;
+}
+
+uint64_t LinkStats::read_speed(const std::string& name) const {
+    std::ifstream file(ProcParser::get_sys_root() + "/class/net/" + name + "/speed");
+    long long speed = 0;
+    // Virtual and down links report -1 or fail the read with EINVAL
+    if (!(file >> speed) || speed <= 0) return 0;
+    return static_cast<uint64_t>(speed);
+}
+
+std::vector<InterfaceStats> LinkStats::update(std::chrono::steady_clock::time_point when) {
+    std::vector<InterfaceStats> interfaces;
+    if (netlink_fd < 0) return interfaces;
+    generation++;
+
+    struct {
+        struct nlmsghdr header;
+        struct ifinfomsg link;
+    } message;
+    memset(&message, 0, sizeof(message));
+    message.header.nlmsg_len = sizeof(message);
+    message.header.nlmsg_type = RTM_GETLINK;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.header.nlmsg_seq = ++sequence;
+    message.link.ifi_family = AF_UNSPEC;
+
+    struct sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    if (sendto(netlink_fd, &message, sizeof(message), 0,
+               reinterpret_cast<struct sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        perror("RTM_GETLINK sendto");
+        return interfaces;
+    }
+
+    // The dump must be read to NLMSG_DONE, or the socket refuses the next one
+    bool done = false;
+    bool complete = true;
+    while (!done) {
+        ssize_t received = recv(netlink_fd, buffer.data(), buffer.size(), 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                // Some replies were dropped; the dump itself goes on
+                complete = false;
+                continue;
+            }
+            perror("RTM_GETLINK recv");
+            complete = false;
+            break;
+        }
+
+        int remaining = static_cast<int>(received);
+        for (auto* header = reinterpret_cast<struct nlmsghdr*>(buffer.data());
+             NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+            // Left over from a dump that was cut short
+            if (header->nlmsg_seq != sequence) continue;
+            if (header->nlmsg_type == NLMSG_DONE) {
+                auto* status = static_cast<int*>(NLMSG_DATA(header));
+                if (header->nlmsg_len >= NLMSG_LENGTH(sizeof(int)) && *status < 0) {
+                    fprintf(stderr, "RTM_GETLINK: %s\n", strerror(-*status));
+                    complete = false;
+                }
+                done = true;
+                break;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                complete = false;
+                auto* error = static_cast<struct nlmsgerr*>(NLMSG_DATA(header));
+                fprintf(stderr, "RTM_GETLINK: %s\n", strerror(-error->error));
+                done = true;
+                break;
+            }
+            if (header->nlmsg_type != RTM_NEWLINK) continue;
+
+            auto* link = static_cast<struct ifinfomsg*>(NLMSG_DATA(header));
+            InterfaceStats stats;
+            stats.index = link->ifi_index;
+            stats.loopback = (link->ifi_flags & IFF_LOOPBACK) != 0;
+            stats.up = (link->ifi_flags & IFF_UP) != 0;
+
+            struct rtnl_link_stats64 counters;
+            memset(&counters, 0, sizeof(counters));
+            bool have_stats64 = false;
+            uint8_t operstate = 0;
+
+            int attr_len = static_cast<int>(IFLA_PAYLOAD(header));
+            for (auto* attr = IFLA_RTA(link); RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+                size_t len = RTA_PAYLOAD(attr);
+                switch (attr->rta_type) {
+                case IFLA_IFNAME:
+                    stats.name.assign(static_cast<const char*>(RTA_DATA(attr)),
+                                      strnlen(static_cast<const char*>(RTA_DATA(attr)), len));
+                    break;
+                case IFLA_STATS64:
+                    memcpy(&counters, RTA_DATA(attr), len < sizeof(counters) ? len : sizeof(counters));
+                    have_stats64 = true;
+                    break;
+                case IFLA_STATS:
+                    if (!have_stats64) {
+                        struct rtnl_link_stats narrow;
+                        memset(&narrow, 0, sizeof(narrow));
+                        memcpy(&narrow, RTA_DATA(attr), len < sizeof(narrow) ? len : sizeof(narrow));
+                        counters.rx_bytes = narrow.rx_bytes;
+                        counters.tx_bytes = narrow.tx_bytes;
+                        counters.rx_packets = narrow.rx_packets;
+                        counters.tx_packets = narrow.tx_packets;
+                        counters.rx_errors = narrow.rx_errors;
+                        counters.tx_errors = narrow.tx_errors;
+                        counters.rx_dropped = narrow.rx_dropped;
+                        counters.tx_dropped = narrow.tx_dropped;
+                    }
+                    break;
+                case IFLA_OPERSTATE:
+                    if (len >= 1) operstate = *static_cast<const uint8_t*>(RTA_DATA(attr));
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            stats.rx_packets = counters.rx_packets;
+            stats.tx_packets = counters.tx_packets;
+            stats.rx_errors = counters.rx_errors;
+            stats.tx_errors = counters.tx_errors;
+            stats.rx_dropped = counters.rx_dropped;
+            stats.tx_dropped = counters.tx_dropped;
+
+            Counters now_counters;
+            now_counters.rx_bytes = counters.rx_bytes;
+            now_counters.tx_bytes = counters.tx_bytes;
+            now_counters.rx_packets = counters.rx_packets;
+            now_counters.tx_packets = counters.tx_packets;
+
+            auto found = previous.find(stats.index);
+            bool known = found != previous.end();
+            Previous& entry = known ? found->second : previous[stats.index];
+
+            double seconds = std::chrono::duration<double>(when - entry.when).count();
+            if (known && seconds > 0) {
+                const Counters& before = entry.counters;
+                stats.rx_bytes_per_sec = counter_delta(now_counters.rx_bytes, before.rx_bytes) / seconds;
+                stats.tx_bytes_per_sec = counter_delta(now_counters.tx_bytes, before.tx_bytes) / seconds;
+                stats.rx_packets_per_sec = counter_delta(now_counters.rx_packets, before.rx_packets) / seconds;
+                stats.tx_packets_per_sec = counter_delta(now_counters.tx_packets, before.tx_packets) / seconds;
+            }
+            // Speed is renegotiated when the link goes down and up again
+            if (!known || entry.operstate != operstate) {
+                entry.operstate = operstate;
+                entry.speed_mbps = read_speed(stats.name);
+            }
+
+            entry.counters = now_counters;
+            entry.when = when;
+            entry.generation = generation;
+            stats.speed_mbps = entry.speed_mbps;
+            interfaces.push_back(std::move(stats));
+        }
+    }
+
+    // Interfaces missing from a complete dump were removed
+    for (auto it = previous.begin(); complete && it != previous.end(); ) {
+        if (it->second.generation != generation) {
+            it = previous.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return interfaces;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct InterfaceStats {
+    int index = 0;
+    std::string name;
+    bool loopback = false;
+    bool up = false;
+    uint64_t speed_mbps = 0;    // Negotiated link speed; 0 if unknown (virtual links)
+
+    // Totals since the interface came up
+    uint64_t rx_packets = 0;
+    uint64_t tx_packets = 0;
+    uint64_t rx_errors = 0;
+    uint64_t tx_errors = 0;
+    uint64_t rx_dropped = 0;
+    uint64_t tx_dropped = 0;
+
+    // Rates since the previous update; 0 for an interface seen for the first time
+    double rx_bytes_per_sec = 0;
+    double tx_bytes_per_sec = 0;
+    double rx_packets_per_sec = 0;
+    double tx_packets_per_sec = 0;
+};
+
+// Per-interface counters from a single RTM_GETLINK dump over rtnetlink,
+// read as binary IFLA_STATS64 (IFLA_STATS on kernels without it) instead of
+// text-parsing /proc/net/dev. Interfaces are tracked by ifindex, so one that
+// disappears and another that takes its name are not mixed up. Collector
+// thread only.
+class LinkStats {
+public:
+    LinkStats();
+    ~LinkStats();
+
+    LinkStats(const LinkStats&) = delete;
+    LinkStats& operator=(const LinkStats&) = delete;
+
+    std::vector<InterfaceStats> update(std::chrono::steady_clock::time_point when);
+
+private:
+    struct Counters {
+        uint64_t rx_bytes = 0;
+        uint64_t tx_bytes = 0;
+        uint64_t rx_packets = 0;
+        uint64_t tx_packets = 0;
+    };
+
+    struct Previous {
+        Counters counters;
+        std::chrono::steady_clock::time_point when;
+        uint8_t operstate = 0;
+        uint64_t speed_mbps = 0;
+        uint64_t generation = 0;
+    };
+
+    static uint64_t counter_delta(uint64_t now, uint64_t before);
+    uint64_t read_speed(const std::string& name) const;
+
+    int netlink_fd = -1;
+    uint32_t sequence = 0;   // nlmsg_seq of the current dump
+    uint64_t generation = 0;
+    std::unordered_map<int, Previous> previous;   // By ifindex
+    std::vector<char> buffer;
+};
@@ -1,5 +1,7 @@
 #include "task_manager.h"
 #include "ipc_server.h"
+#include "shm_publisher.h"
+#include "batch_mode.h"
 #include <iostream>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -36,7 +38,12 @@ void create_pid_file(const std::string& socket_path) {
     pf.close();
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Headless mode runs before anything GUI- or instance-related is set up
+    if (BatchMode::requested(argc, argv)) {
+        return BatchMode::run(argc, argv);
+    }
+
     // Setup IPC server for single instance
     IpcServer& ipc = IpcServer::get_instance();
     std::string socket_path = ipc.get_socket_path();
@@ -54,6 +61,11 @@ int main() {
 
     create_pid_file(socket_path);
 
+    // Zero-copy snapshot for local agents; the GUI works fine without it
+    if (!ShmPublisher::get_instance().open_region()) {
+        std::cerr << "Shared memory snapshot unavailable" << std::endl;
+    }
+
     try {
         TaskManager tm;
         tm.run();
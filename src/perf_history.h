@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// Rolling samples behind the Performance tab graphs
+struct PerformanceData {
+    std::vector<double> cpu_history;
+    // Stacked memory chart: percent of RAM + swap per layer, bottom to top
+    enum MemLayer { MEM_ANON, MEM_SHMEM, MEM_FILE, MEM_SLAB, MEM_PAGE_TABLES, MEM_SWAP, MEM_LAYERS };
+    std::vector<double> mem_layer_history[MEM_LAYERS];
+    double mem_ram_share = 100.0;   // Where RAM ends and swap begins on that chart
+    std::vector<double> net_history;
+    std::vector<double> gpu_history;
+    double current_cpu = 0;
+    double current_mem = 0;
+    double current_net = 0;
+    double current_gpu = 0;
+    const size_t max_history = 60;
+
+    // Appends a sample, dropping the oldest once the history is full
+    void push_sample(std::vector<double>& history, double value) const {
+        if (history.size() >= max_history) {
+            history.erase(history.begin());
+        }
+        history.push_back(value);
+    }
+};
@@ -0,0 +1,197 @@
+#include "privileged_helper.h"
+#include "debug.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <future>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#ifndef TASKMGR_HELPER_PATH
+#define TASKMGR_HELPER_PATH "/usr/local/libexec/taskmgr-helper"
+#endif
+
+PrivilegedHelper& PrivilegedHelper::get_instance() {
+    static PrivilegedHelper instance;
+    return instance;
+}
+
+PrivilegedHelper::PrivilegedHelper() {
+    worker = std::thread([this]() { worker_loop(); });
+}
+
+PrivilegedHelper::~PrivilegedHelper() {
+    stop_helper();
+}
+
+void PrivilegedHelper::stop_helper() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    queue_cv.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    close_helper();
+}
+
+void PrivilegedHelper::submit(const HelperRequest& request, Callback done) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stopping) {
+            if (done) done({-1, "helper stopped"});
+            return;
+        }
+        queue.push_back({next_id++, request, std::move(done)});
+    }
+    queue_cv.notify_one();
+}
+
+HelperResult PrivilegedHelper::call(const HelperRequest& request) {
+    auto promise = std::make_shared<std::promise<HelperResult>>();
+    std::future<HelperResult> future = promise->get_future();
+    submit(request, [promise](const HelperResult& result) { promise->set_value(result); });
+    return future.get();
+}
+
+std::string PrivilegedHelper::get_helper_path() {
+    if (access(TASKMGR_HELPER_PATH, X_OK) == 0) {
+        return TASKMGR_HELPER_PATH;
+    }
+
+    // Not installed; use the copy built next to our own executable
+    char exe_path[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
+    if (len == -1) return TASKMGR_HELPER_PATH;
+    exe_path[len] = '\0';
+
+    std::string path(exe_path);
+    return path.substr(0, path.find_last_of('/') + 1) + "taskmgr-helper";
+}
+
+bool PrivilegedHelper::spawn_helper() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        perror("socketpair");
+        return false;
+    }
+
+    std::string helper_path = get_helper_path();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        // pkexec keeps stdin/stdout, so the helper talks to us through them
+        dup2(fds[1], STDIN_FILENO);
+        dup2(fds[1], STDOUT_FILENO);
+        execlp("pkexec", "pkexec", helper_path.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(fds[1]);
+    helper_fd = fds[0];
+    helper_pid = pid;
+    read_buffer.clear();
+
+    // The helper greets us once it is running as root; EOF means auth was cancelled
+    std::string greeting;
+    if (!read_line(greeting) || greeting != "ready") {
+        std::cerr << "Privileged helper did not start" << std::endl;
+        close_helper();
+        return false;
+    }
+    return true;
+}
+
+void PrivilegedHelper::close_helper() {
+    if (helper_fd >= 0) {
+        close(helper_fd);
+        helper_fd = -1;
+    }
+    if (helper_pid > 0) {
+        waitpid(helper_pid, nullptr, 0);
+        helper_pid = -1;
+    }
+}
+
+bool PrivilegedHelper::read_line(std::string& line) {
+    for (;;) {
+        size_t newline = read_buffer.find('\n');
+        if (newline != std::string::npos) {
+            line = read_buffer.substr(0, newline);
+            read_buffer.erase(0, newline + 1);
+            return true;
+        }
+
+        char buffer[512];
+        ssize_t len = read(helper_fd, buffer, sizeof(buffer));
+        if (len < 0 && errno == EINTR) continue;
+        if (len <= 0) return false;
+        read_buffer.append(buffer, len);
+    }
+}
+
+void PrivilegedHelper::worker_loop() {
+    for (;;) {
+        std::deque<Pending> batch;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            batch.swap(queue);
+        }
+
+        if (helper_fd < 0 && !spawn_helper()) {
+            for (auto& pending : batch) {
+                if (pending.done) pending.done({-1, "privileged helper unavailable"});
+            }
+            continue;
+        }
+
+        // Pipeline the whole batch, then collect replies in order
+        std::ostringstream out;
+        for (const auto& pending : batch) {
+            out << pending.id << ' ' << pending.request.op << ' '
+                << pending.request.target << ' ' << pending.request.value << '\n';
+        }
+        std::string data = out.str();
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t len = send(helper_fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (len < 0 && errno == EINTR) continue;
+            if (len <= 0) break;
+            written += len;
+        }
+
+        for (auto& pending : batch) {
+            HelperResult result = {-1, "privileged helper exited"};
+            std::string line;
+            if (written == data.size() && read_line(line)) {
+                // Reply: "<id> <status> <message>"
+                std::istringstream iss(line);
+                uint64_t id = 0;
+                iss >> id >> result.status;
+                std::getline(iss, result.message);
+                if (!result.message.empty() && result.message[0] == ' ') {
+                    result.message.erase(0, 1);
+                }
+                DEBUG_ACTION(std::cerr << "DEBUG: helper reply " << id << " status=" << result.status << std::endl);
+            } else {
+                close_helper();
+            }
+            if (pending.done) pending.done(result);
+        }
+    }
+}
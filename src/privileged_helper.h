@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include <cstdint>
+#include <sys/types.h>
+
+// One request to the privileged helper. Ops:
+//   start, stop, restart, enable, disable, enable-now   target = unit name
+//   signal                                              target = PID, value = signal
+//   renice                                              target = PID, value = nice
+struct HelperRequest {
+    std::string op;
+    std::string target;
+    int value;
+};
+
+struct HelperResult {
+    int status;           // 0 on success, errno or job failure otherwise, -1 if the helper is unavailable
+    std::string message;
+};
+
+// Client side of taskmgr-helper. The helper is started once per session via
+// pkexec on the first request and stays connected over a socketpair, so
+// queued requests share one authentication and are pipelined on one stream.
+class PrivilegedHelper {
+public:
+    typedef std::function<void(const HelperResult&)> Callback;
+
+    static PrivilegedHelper& get_instance();
+
+    // Queues a request; done runs on the helper's worker thread when it completes
+    void submit(const HelperRequest& request, Callback done);
+    // Blocking round-trip, for callers that are not on the UI thread
+    HelperResult call(const HelperRequest& request);
+
+    void stop_helper();
+
+    PrivilegedHelper(const PrivilegedHelper&) = delete;
+    PrivilegedHelper& operator=(const PrivilegedHelper&) = delete;
+
+private:
+    PrivilegedHelper();
+    ~PrivilegedHelper();
+
+    struct Pending {
+        uint64_t id;
+        HelperRequest request;
+        Callback done;
+    };
+
+    void worker_loop();
+    bool spawn_helper();
+    void close_helper();
+    bool read_line(std::string& line);
+    static std::string get_helper_path();
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Pending> queue;
+    std::thread worker;
+    bool stopping = false;
+    uint64_t next_id = 1;
+
+    // Worker thread only
+    int helper_fd = -1;
+    pid_t helper_pid = -1;
+    std::string read_buffer;
+};
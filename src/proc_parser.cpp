@@ -1,4 +1,6 @@
 #include "proc_parser.h"
+#include "diagnostics.h"
+#include "proc_table.h"
 #include <fstream>
 #include <sstream>
 #include <dirent.h>
@@ -7,14 +9,42 @@
 #include <csignal>
 #include <unistd.h>
 #include <cstring>
+#include <cstdlib>
 #include <algorithm>
 #include <sys/sysinfo.h>
 
 std::map<pid_t, ProcessInfo> ProcParser::last_processes;
 unsigned long long ProcParser::last_system_ticks = 0;
 
+static std::string root_from_env(const char* name, const char* fallback) {
+    const char* value = getenv(name);
+    return (value && *value) ? value : fallback;
+}
+
+std::string ProcParser::proc_root = root_from_env("TASKMGR_PROC_ROOT", "/proc");
+std::string ProcParser::sys_root = root_from_env("TASKMGR_SYS_ROOT", "/sys");
+
+const std::string& ProcParser::get_proc_root() {
+    return proc_root;
+}
+
+const std::string& ProcParser::get_sys_root() {
+    return sys_root;
+}
+
+void ProcParser::set_proc_root(const std::string& root) {
+    proc_root = root;
+    // CPU deltas against another tree would be meaningless
+    last_processes.clear();
+    last_system_ticks = 0;
+}
+
+void ProcParser::set_sys_root(const std::string& root) {
+    sys_root = root;
+}
+
 unsigned long long get_total_ticks() {
-    std::ifstream stat_file("/proc/stat");
+    std::ifstream stat_file(ProcParser::get_proc_root() + "/stat");
     std::string line;
     if (!std::getline(stat_file, line)) return 0;
 
@@ -26,12 +56,13 @@ unsigned long long get_total_ticks() {
 }
 
 std::vector<ProcessInfo> ProcParser::get_all_processes() {
+    Diagnostics::ScopedTimer timer(Diagnostics::SCAN);
     std::vector<ProcessInfo> current_procs;
     unsigned long long current_system_ticks = get_total_ticks();
     unsigned long long system_delta = current_system_ticks - last_system_ticks;
     int num_cores = get_nprocs(); // Get number of CPU cores
 
-    DIR* dir = opendir("/proc");
+    DIR* dir = opendir(proc_root.c_str());
     if (!dir) return current_procs;
 
     struct dirent* entry;
@@ -39,7 +70,9 @@ std::vector<ProcessInfo> ProcParser::get_all_processes() {
         if (entry->d_type == DT_DIR && std::all_of(entry->d_name,
             entry->d_name + strlen(entry->d_name), ::isdigit)) {
             try {
+                uint64_t parse_started = Diagnostics::now_ns();
                 current_procs.push_back(parse_process(std::atoi(entry->d_name)));
+                Diagnostics::record(Diagnostics::PARSE, Diagnostics::now_ns() - parse_started);
             } catch (...) { continue; }
         }
     }
@@ -91,10 +124,17 @@ ProcessInfo ProcParser::parse_process(pid_t pid) {
     info.memory_rss = 0;
     info.memory_vms = 0;
     info.thread_count = 0;
+    info.socket_count = 0;
+    info.net_send_rate = 0;
+    info.net_recv_rate = 0;
+    info.io_read_bytes = 0;
+    info.io_write_bytes = 0;
     info.user = "unknown";
+    info.uid = static_cast<uid_t>(-1);
 
     // Read /proc/[pid]/stat
-    std::string stat_path = "/proc/" + std::to_string(pid) + "/stat";
+    const std::string pid_dir = proc_root + "/" + std::to_string(pid);
+    std::string stat_path = pid_dir + "/stat";
     std::ifstream stat_file(stat_path);
     if (!stat_file) throw std::runtime_error("Cannot read stat");
 
@@ -125,12 +165,17 @@ ProcessInfo ProcParser::parse_process(pid_t pid) {
     }
     iss >> utime >> stime;
 
+    // Fields 16-19: cutime, cstime, priority, nice
+    long cutime = 0, cstime = 0, priority = 0, nice = 0;
+    iss >> cutime >> cstime >> priority >> nice;
+
     info.ppid = ppid;
+    info.nice = static_cast<int>(nice);
     info.state = state;
     info.cpu_time = utime + stime;  // Total jiffies
 
     // Read /proc/[pid]/status for memory and threads
-    std::string status_path = "/proc/" + std::to_string(pid) + "/status";
+    std::string status_path = pid_dir + "/status";
     std::ifstream status_file(status_path);
     if (status_file) {
         std::string key, line_status;
@@ -150,6 +195,7 @@ ProcessInfo ProcParser::parse_process(pid_t pid) {
             } else if (key == "Threads:") {
                 info.thread_count = static_cast<int>(value);
             } else if (key == "Uid:") {
+                info.uid = static_cast<uid_t>(value);
                 struct passwd* pwd = getpwuid(static_cast<uid_t>(value));
                 if (pwd) {
                     info.user = pwd->pw_name;
@@ -158,9 +204,20 @@ ProcessInfo ProcParser::parse_process(pid_t pid) {
         }
     }
 
+    // Read /proc/[pid]/io for storage I/O (only readable for our own processes unless root)
+    std::ifstream io_file(pid_dir + "/io");
+    if (io_file) {
+        std::string key;
+        uint64_t value;
+        while (io_file >> key >> value) {
+            if (key == "read_bytes:") info.io_read_bytes = value;
+            else if (key == "write_bytes:") info.io_write_bytes = value;
+        }
+    }
+
     // Read /proc/[pid]/exe for executable path
     char exe_path[PATH_MAX];
-    std::string exe_link = "/proc/" + std::to_string(pid) + "/exe";
+    std::string exe_link = pid_dir + "/exe";
     ssize_t len = readlink(exe_link.c_str(), exe_path, sizeof(exe_path) - 1);
     if (len != -1) {
         exe_path[len] = '\0';
@@ -168,7 +225,7 @@ ProcessInfo ProcParser::parse_process(pid_t pid) {
     }
 
     // Read /proc/[pid]/cgroup for cgroup
-    std::string cgroup_path = "/proc/" + std::to_string(pid) + "/cgroup";
+    std::string cgroup_path = pid_dir + "/cgroup";
     info.cgroup = read_file(cgroup_path);
 
     // These will be filled in by the caller with proper CPU calculation
@@ -186,25 +243,37 @@ SystemStats ProcParser::get_system_stats() {
     SystemStats stats = {};
 
     // Read /proc/meminfo
-    std::ifstream meminfo("/proc/meminfo");
-    std::string line;
-    while (std::getline(meminfo, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        uint64_t value;
-        iss >> key >> value;
-
-        if (key == "MemTotal:") stats.total_memory = value * 1024;
-        else if (key == "MemAvailable:") stats.available_memory = value * 1024;
-        else if (key == "Cached:") stats.cached_memory = value * 1024;
+    enum { MEM_TOTAL, MEM_FREE, MEM_AVAILABLE, BUFFERS, CACHED, SHMEM, ANON_PAGES,
+           SLAB, PAGE_TABLES, SWAP_TOTAL, SWAP_FREE };
+    static thread_local ProcTable meminfo("meminfo", {
+        "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "Shmem", "AnonPages",
+        "Slab", "PageTables", "SwapTotal", "SwapFree"});
+    static thread_local std::vector<uint64_t> kb;
+    if (meminfo.read(kb)) {
+        stats.total_memory = kb[MEM_TOTAL] * 1024;
+        stats.available_memory = kb[MEM_AVAILABLE] * 1024;
+        stats.cached_memory = kb[CACHED] * 1024;
+
+        MemoryComposition& memory = stats.memory;
+        memory.free = kb[MEM_FREE] * 1024;
+        memory.anon = kb[ANON_PAGES] * 1024;
+        memory.shmem = kb[SHMEM] * 1024;
+        // Cached counts shmem too, but shmem can't be dropped like file pages
+        uint64_t file_kb = kb[BUFFERS] + kb[CACHED];
+        memory.file = (file_kb > kb[SHMEM] ? file_kb - kb[SHMEM] : 0) * 1024;
+        memory.slab = kb[SLAB] * 1024;
+        memory.page_tables = kb[PAGE_TABLES] * 1024;
+        memory.swap_total = kb[SWAP_TOTAL] * 1024;
+        memory.swap_used = (kb[SWAP_TOTAL] > kb[SWAP_FREE] ? kb[SWAP_TOTAL] - kb[SWAP_FREE] : 0) * 1024;
     }
 
     // Read /proc/uptime
-    std::ifstream uptime("/proc/uptime");
+    std::ifstream uptime(proc_root + "/uptime");
     uptime >> stats.uptime;
 
     // Calculate total CPU usage from /proc/stat
-    std::ifstream stat("/proc/stat");
+    std::ifstream stat(proc_root + "/stat");
+    std::string line;
     std::getline(stat, line);  // Read first line (cpu totals)
 
     // Parse: cpu  user nice system idle iowait irq softirq
@@ -251,7 +320,7 @@ std::string ProcParser::read_file(const std::string& path) {
 
 std::string ProcParser::get_exe_name(pid_t pid) {
     char exe_path[PATH_MAX];
-    std::string link = "/proc/" + std::to_string(pid) + "/exe";
+    std::string link = proc_root + "/" + std::to_string(pid) + "/exe";
     ssize_t len = readlink(link.c_str(), exe_path, sizeof(exe_path) - 1);
     if (len != -1) {
         exe_path[len] = '\0';
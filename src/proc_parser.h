@@ -4,6 +4,7 @@
 #include <vector>
 #include <cstdint>
 #include <map>
+#include <sys/types.h>
 
 struct ProcessInfo {
     pid_t pid;
@@ -11,24 +12,44 @@ struct ProcessInfo {
     std::string name;
     std::string exe_path;
     std::string user;
+    uid_t uid;                // Real uid; (uid_t)-1 if status could not be read
     double cpu_usage;
     double memory_usage;
     uint64_t memory_rss;
     uint64_t memory_vms;
     int64_t cpu_time;
+    uint64_t io_read_bytes;   // Storage I/O from /proc/[pid]/io; 0 if not readable
+    uint64_t io_write_bytes;
     int thread_count;
+    int socket_count;         // Filled in by SocketIndex; 0 if the fd table is not readable
+    double net_send_rate;     // TCP bytes/sec, filled in by TcpThroughput
+    double net_recv_rate;
     std::string state;
     int nice;
     bool is_elevated;
     std::string cgroup;
 };
 
+// Where RAM goes, in bytes, from /proc/meminfo. What the kernel uses outside
+// these (kernel stacks, driver allocations) is total - free - the rest.
+struct MemoryComposition {
+    uint64_t free;
+    uint64_t anon;          // AnonPages
+    uint64_t file;          // Buffers + Cached - Shmem
+    uint64_t shmem;         // tmpfs and shared anonymous mappings
+    uint64_t slab;
+    uint64_t page_tables;
+    uint64_t swap_total;
+    uint64_t swap_used;
+};
+
 struct SystemStats {
     double total_cpu_usage;
     uint64_t total_memory;
     uint64_t available_memory;
     uint64_t cached_memory;
     double uptime;
+    MemoryComposition memory;
 };
 
 class ProcParser {
@@ -43,6 +64,14 @@ public:
     static bool resume_process(pid_t pid);
     static bool set_priority(pid_t pid, int priority);
 
+    // Where procfs and sysfs are read from. Default to /proc and /sys, or to
+    // $TASKMGR_PROC_ROOT / $TASKMGR_SYS_ROOT, so scans can run against a
+    // generated fixture tree instead of the live system.
+    static const std::string& get_proc_root();
+    static const std::string& get_sys_root();
+    static void set_proc_root(const std::string& root);
+    static void set_sys_root(const std::string& root);
+
 private:
     static ProcessInfo parse_process(pid_t pid);
     static std::string read_file(const std::string& path);
@@ -51,4 +80,6 @@ private:
     static std::string get_user_name(uid_t uid);
     static unsigned long long last_system_ticks;
     static std::map<pid_t, ProcessInfo> last_processes;
+    static std::string proc_root;
+    static std::string sys_root;
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "proc_table.h"
+#include "proc_parser.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+ProcTable::ProcTable(const std::string& name, const std::vector<std::string>& keys)
+    : name(name), buffer(8192) {
+    for (size_t i = 0; i < keys.size(); i++) {
+        slots[keys[i]] = static_cast<int>(i);
+    }
+}
+
+bool ProcTable::read(std::vector<uint64_t>& values) {
+    values.assign(slots.size(), 0);
+
+    int fd = open((ProcParser::get_proc_root() + "/" + name).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    // procfs generates the text per read, so take it all before parsing
+    size_t used = 0;
+    while (true) {
+        if (used == buffer.size()) buffer.resize(buffer.size() * 2);
+        ssize_t n = ::read(fd, buffer.data() + used, buffer.size() - used);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        used += static_cast<size_t>(n);
+    }
+    close(fd);
+
+    const char* p = buffer.data();
+    const char* end = p + used;
+    size_t line = 0;
+    while (p < end) {
+        // "Key:   123 kB" in meminfo, "key 123" in vmstat
+        const char* key = p;
+        while (p < end && *p != ':' && *p != ' ' && *p != '\n') p++;
+        size_t key_len = static_cast<size_t>(p - key);
+        while (p < end && (*p == ':' || *p == ' ')) p++;
+        uint64_t value = 0;
+        while (p < end && *p >= '0' && *p <= '9') value = value * 10 + static_cast<uint64_t>(*p++ - '0');
+        while (p < end && *p != '\n') p++;
+        if (p < end) p++;
+
+        if (line >= layout.size() || layout[line].key.size() != key_len ||
+            memcmp(layout[line].key.data(), key, key_len) != 0) {
+            layout.resize(line);
+            Line learned;
+            learned.key.assign(key, key_len);
+            auto it = slots.find(learned.key);
+            learned.slot = it == slots.end() ? -1 : it->second;
+            layout.push_back(std::move(learned));
+        }
+        if (layout[line].slot >= 0) values[layout[line].slot] = value;
+        line++;
+    }
+    // A shorter file than last time; drop the stale tail
+    if (layout.size() > line) layout.resize(line);
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Single-pass reader for "key value" procfs files such as meminfo and vmstat.
+// The file's line layout is learned on the first read and kept, so each line
+// after that costs one compare against the key seen there last time, however
+// many fields are wanted. A kernel that adds or reorders lines just causes a
+// relearn from the first line that differs. Not thread-safe; give each
+// reading thread its own.
+class ProcTable {
+public:
+    // name is relative to the proc root, e.g. "meminfo"
+    ProcTable(const std::string& name, const std::vector<std::string>& keys);
+
+    // values[i] receives keys[i]'s number as printed (kB for meminfo), or 0
+    // when the file has no such line. False if the file can't be read.
+    bool read(std::vector<uint64_t>& values);
+
+private:
+    struct Line {
+        std::string key;
+        int slot;   // Index into the wanted keys, -1 if not wanted
+    };
+
+    std::string name;
+    std::unordered_map<std::string, int> slots;
+    std::vector<Line> layout;
+    std::vector<char> buffer;
+};
@@ -0,0 +1,122 @@
+#include "process_history.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const double IO_STEPS_PER_OCTAVE = 1024.0;
+
+    uint16_t encode_cpu(double percent) {
+        double centi = std::round(percent * 100.0);
+        return static_cast<uint16_t>(std::min(std::max(centi, 0.0), 65535.0));
+    }
+
+    uint16_t encode_io(double bytes_per_sec) {
+        double code = std::round(std::log2(1.0 + std::max(bytes_per_sec, 0.0)) * IO_STEPS_PER_OCTAVE);
+        return static_cast<uint16_t>(std::min(code, 65535.0));
+    }
+
+    float decode_io(uint16_t code) {
+        return static_cast<float>(std::exp2(code / IO_STEPS_PER_OCTAVE) - 1.0);
+    }
+}
+
+ProcessHistory::ProcessHistory(size_t budget_bytes) : pinned(0), pool(budget_bytes / sizeof(Ring)) {
+}
+
+ProcessHistory::Ring* ProcessHistory::take_ring(pid_t pid) {
+    Ring* ring = pool.allocate();
+    if (ring || pid != pinned.load(std::memory_order_relaxed)) return ring;
+
+    // Over budget, but the selected process must have history: take the ring
+    // of some other process, which loses its history instead
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->first == pid) continue;
+        ring = it->second.ring;
+        entries.erase(it);
+        return ring;
+    }
+    return nullptr;
+}
+
+void ProcessHistory::record(const std::vector<ProcessInfo>& processes,
+                            std::chrono::steady_clock::time_point when) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    double seconds = generation ? std::chrono::duration<double>(when - last_record).count() : 0;
+    last_record = when;
+    generation++;
+
+    for (const auto& proc : processes) {
+        uint64_t io_bytes = proc.io_read_bytes + proc.io_write_bytes;
+
+        auto it = entries.find(proc.pid);
+        if (it == entries.end()) {
+            Ring* ring = take_ring(proc.pid);
+            // Pool exhausted: this PID stays untracked until a ring frees up
+            if (!ring) continue;
+            it = entries.emplace(proc.pid, Entry()).first;
+            it->second.ring = ring;
+            ring->count = 0;
+            it->second.io_bytes = io_bytes;
+        } else if (proc.cpu_time < it->second.cpu_time) {
+            // CPU time never goes backwards for one process, so the PID was reused
+            it->second.ring->count = 0;
+            it->second.io_bytes = io_bytes;
+        }
+        Entry& entry = it->second;
+
+        StoredSample& sample = entry.ring->samples[entry.ring->head];
+        sample.cpu = encode_cpu(proc.cpu_usage);
+        sample.rss_kb = static_cast<uint32_t>(proc.memory_rss / 1024);
+        sample.io_rate = encode_io((seconds > 0 && io_bytes >= entry.io_bytes)
+            ? (io_bytes - entry.io_bytes) / seconds : 0.0);
+
+        entry.ring->head = (entry.ring->head + 1) % SAMPLES;
+        if (entry.ring->count < SAMPLES) entry.ring->count++;
+
+        entry.cpu_time = proc.cpu_time;
+        entry.io_bytes = io_bytes;
+        entry.generation = generation;
+    }
+
+    // Processes not seen this round have exited; recycle their rings
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (it->second.generation != generation) {
+            pool.release(it->second.ring);
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<ProcessSample> ProcessHistory::get(pid_t pid) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<ProcessSample> samples;
+
+    auto it = entries.find(pid);
+    if (it == entries.end()) return samples;
+
+    const Ring* ring = it->second.ring;
+    samples.reserve(ring->count);
+    uint32_t start = (ring->head + SAMPLES - ring->count) % SAMPLES;
+    for (uint32_t i = 0; i < ring->count; i++) {
+        const StoredSample& stored = ring->samples[(start + i) % SAMPLES];
+        ProcessSample sample;
+        sample.cpu = stored.cpu / 100.0f;
+        sample.io_rate = decode_io(stored.io_rate);
+        sample.rss_kb = stored.rss_kb;
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+size_t ProcessHistory::tracked() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t ProcessHistory::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pool.capacity_bytes();
+}
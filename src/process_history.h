@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "proc_parser.h"
+#include "slab_pool.h"
+
+struct ProcessSample {
+    float cpu = 0;       // Percent of total CPU
+    float io_rate = 0;   // Bytes/sec read + written
+    uint32_t rss_kb = 0;
+};
+
+// Recent CPU/RSS/IO samples for every process, so a spike is still visible
+// after the fact. Each PID gets a fixed ring from a slab pool that grows with
+// the process count; rings go back to the pool when the process exits.
+// Samples are stored in fixed point (8 bytes), so the default budget covers
+// about 100k processes. Past the budget, PIDs get no history, except the
+// pinned one (the UI's selection), which takes a ring from another process.
+// record() runs on the collector thread, get() and pin() on the UI thread.
+class ProcessHistory {
+public:
+    static const size_t SAMPLES = 120;  // One minute at the default period
+    static const size_t DEFAULT_BUDGET_BYTES = 96 * 1024 * 1024;
+
+    explicit ProcessHistory(size_t budget_bytes = DEFAULT_BUDGET_BYTES);
+
+    ProcessHistory(const ProcessHistory&) = delete;
+    ProcessHistory& operator=(const ProcessHistory&) = delete;
+
+    void record(const std::vector<ProcessInfo>& processes, std::chrono::steady_clock::time_point when);
+
+    // Oldest first; empty if the PID is unknown or untracked
+    std::vector<ProcessSample> get(pid_t pid) const;
+
+    // This PID always gets a ring from the next record() on; 0 for none
+    void pin(pid_t pid) { pinned = pid; }
+
+    size_t tracked() const;
+    size_t memory_bytes() const;
+
+private:
+    // CPU in hundredths of a percent, I/O rate as log2(1 + bytes/s) in 1/1024
+    // steps (0.07% resolution up to petabytes/s), RSS as is
+    struct StoredSample {
+        uint16_t cpu = 0;
+        uint16_t io_rate = 0;
+        uint32_t rss_kb = 0;
+    };
+
+    struct Ring {
+        StoredSample samples[SAMPLES];
+        uint32_t head = 0;
+        uint32_t count = 0;
+    };
+
+    struct Entry {
+        Ring* ring = nullptr;
+        int64_t cpu_time = 0;
+        uint64_t io_bytes = 0;
+        uint64_t generation = 0;
+    };
+
+    Ring* take_ring(pid_t pid);
+
+    std::atomic<pid_t> pinned;
+    mutable std::mutex mutex;
+    SlabPool<Ring> pool;
+    std::unordered_map<pid_t, Entry> entries;
+    uint64_t generation = 0;
+    std::chrono::steady_clock::time_point last_record;
+};
@@ -0,0 +1,201 @@
+#include "process_inspector.h"
+#include "proc_parser.h"
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <dirent.h>
+#include <unistd.h>
+
+namespace {
+    std::string trim(const std::string& s) {
+        size_t start = s.find_first_not_of(' ');
+        if (start == std::string::npos) return "";
+        return s.substr(start, s.find_last_not_of(' ') - start + 1);
+    }
+
+    // /proc/[pid]/limits is a fixed-width table: name, soft, hard, units
+    std::pair<std::string, std::string> parse_limit(const std::string& line) {
+        std::string name = trim(line.substr(0, 26));
+        std::string soft = line.size() > 26 ? trim(line.substr(26, 21)) : "";
+        std::string hard = line.size() > 47 ? trim(line.substr(47, 21)) : "";
+        std::string units = line.size() > 68 ? trim(line.substr(68)) : "";
+
+        std::string value = soft + " / " + hard;
+        if (!units.empty()) value += " " + units;
+        return {name, value};
+    }
+}
+
+ProcessInspector::ProcessInspector(pid_t pid, Sink sink)
+    : pid(pid),
+      pid_dir(ProcParser::get_proc_root() + "/" + std::to_string(pid)),
+      sink(std::move(sink)),
+      cancelled(false) {
+    worker = std::thread([this]() { worker_loop(); });
+}
+
+ProcessInspector::~ProcessInspector() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        cancelled = true;
+    }
+    queue_cv.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void ProcessInspector::request(Section section) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (requested[section]) return;
+        requested[section] = true;
+        queue.push_back(section);
+    }
+    queue_cv.notify_one();
+}
+
+const char* ProcessInspector::section_name(Section section) {
+    switch (section) {
+    case FDS:     return "File Descriptors";
+    case MAPS:    return "Memory Maps";
+    case LIMITS:  return "Limits";
+    case ENVIRON: return "Environment";
+    case CMDLINE: return "Command Line";
+    case WCHAN:   return "Wait Channel";
+    default:      return "";
+    }
+}
+
+void ProcessInspector::worker_loop() {
+    while (true) {
+        Section section;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this]() { return cancelled || !queue.empty(); });
+            if (cancelled) return;
+            section = queue.front();
+            queue.pop_front();
+        }
+        read_section(section);
+    }
+}
+
+void ProcessInspector::read_section(Section section) {
+    Batch batch;
+    batch.section = section;
+    batch.done = false;
+    batch.rows.reserve(BATCH_ROWS);
+
+    switch (section) {
+    case FDS:     read_fds(batch); break;
+    case MAPS:
+    case LIMITS:  read_lines(section, batch); break;
+    case ENVIRON:
+    case CMDLINE: read_nul_separated(section, batch); break;
+    case WCHAN:   read_wchan(batch); break;
+    default:      break;
+    }
+
+    batch.done = true;
+    flush(batch, true);
+}
+
+bool ProcessInspector::flush(Batch& batch, bool force) {
+    if (cancelled) return false;
+    if (!force && batch.rows.size() < BATCH_ROWS) return true;
+
+    Batch full;
+    full.section = batch.section;
+    full.done = batch.done;
+    full.error = batch.error;
+    full.rows.swap(batch.rows);
+    batch.rows.reserve(BATCH_ROWS);
+
+    sink(std::move(full));
+    return !cancelled;
+}
+
+void ProcessInspector::read_fds(Batch& batch) {
+    DIR* dir = opendir((pid_dir + "/fd").c_str());
+    if (!dir) {
+        batch.error = strerror(errno);
+        return;
+    }
+
+    char target[PATH_MAX];
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+
+        // The fd may close between readdir and readlink
+        ssize_t len = readlinkat(dirfd(dir), entry->d_name, target, sizeof(target) - 1);
+        if (len < 0) continue;
+        target[len] = '\0';
+
+        batch.rows.emplace_back(entry->d_name, target);
+        if (!flush(batch)) break;
+    }
+    closedir(dir);
+}
+
+void ProcessInspector::read_lines(Section section, Batch& batch) {
+    std::ifstream file(pid_dir + (section == MAPS ? "/maps" : "/limits"));
+    if (!file) {
+        batch.error = strerror(errno);
+        return;
+    }
+
+    std::string line;
+    if (section == LIMITS) std::getline(file, line);  // Column headings
+
+    while (std::getline(file, line)) {
+        if (section == LIMITS) {
+            batch.rows.push_back(parse_limit(line));
+        } else {
+            // "start-end perms offset dev inode [path]", keyed by the range
+            size_t space = line.find(' ');
+            if (space == std::string::npos) continue;
+            batch.rows.emplace_back(line.substr(0, space), line.substr(space + 1));
+        }
+        if (!flush(batch)) break;
+    }
+}
+
+void ProcessInspector::read_nul_separated(Section section, Batch& batch) {
+    std::ifstream file(pid_dir + (section == ENVIRON ? "/environ" : "/cmdline"));
+    if (!file) {
+        batch.error = strerror(errno);
+        return;
+    }
+
+    std::string item;
+    int index = 0;
+    while (std::getline(file, item, '\0')) {
+        if (section == ENVIRON) {
+            size_t equals = item.find('=');
+            if (equals == std::string::npos) {
+                batch.rows.emplace_back(item, "");
+            } else {
+                batch.rows.emplace_back(item.substr(0, equals), item.substr(equals + 1));
+            }
+        } else {
+            batch.rows.emplace_back("argv[" + std::to_string(index++) + "]", item);
+        }
+        if (!flush(batch)) break;
+    }
+}
+
+void ProcessInspector::read_wchan(Batch& batch) {
+    std::ifstream file(pid_dir + "/wchan");
+    if (!file) {
+        batch.error = strerror(errno);
+        return;
+    }
+
+    std::string wchan((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    // The kernel reports "0" while the process is running or runnable
+    batch.rows.emplace_back("wchan", wchan.empty() || wchan == "0" ? "(running)" : wchan);
+}
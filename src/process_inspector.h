@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <functional>
+#include <condition_variable>
+#include <sys/types.h>
+
+// Reads the per-process detail files a scan never touches. Each section is
+// read on the inspector's own worker thread only once it is requested, and
+// is handed back in batches as it is read, so a process with 100k fds or a
+// huge maps file fills in progressively instead of stalling anyone.
+class ProcessInspector {
+public:
+    enum Section {
+        FDS,
+        MAPS,
+        LIMITS,
+        ENVIRON,
+        CMDLINE,
+        WCHAN,
+        SECTION_COUNT
+    };
+
+    struct Batch {
+        Section section;
+        std::vector<std::pair<std::string, std::string>> rows;
+        bool done;            // Last batch of the section
+        std::string error;    // Set on the last batch if the section could not be read
+    };
+
+    // Runs on the worker thread, never after the destructor returns
+    typedef std::function<void(Batch&&)> Sink;
+
+    static const size_t BATCH_ROWS = 512;
+
+    ProcessInspector(pid_t pid, Sink sink);
+    ~ProcessInspector();
+
+    ProcessInspector(const ProcessInspector&) = delete;
+    ProcessInspector& operator=(const ProcessInspector&) = delete;
+
+    // Queues a section for reading; repeated requests are ignored
+    void request(Section section);
+
+    static const char* section_name(Section section);
+
+private:
+    void worker_loop();
+    void read_section(Section section);
+    void read_fds(Batch& batch);
+    void read_lines(Section section, Batch& batch);
+    void read_nul_separated(Section section, Batch& batch);
+    void read_wchan(Batch& batch);
+    // Sends the batch if it is full (or force is set); false once cancelled
+    bool flush(Batch& batch, bool force = false);
+
+    pid_t pid;
+    std::string pid_dir;
+    Sink sink;
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<Section> queue;
+    bool requested[SECTION_COUNT] = {};
+    std::atomic<bool> cancelled;
+    std::thread worker;
+};
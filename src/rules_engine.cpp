@@ -0,0 +1,287 @@
+#include "rules_engine.h"
+#include "snapshot.h"
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    const char* const METRIC_NAMES[] = {"cpu", "mem", "rss", "threads", "mem_available"};
+
+    // "90", "90%", "4G", "512M"; binary multiples for the byte suffixes
+    bool parse_value(const std::string& text, double& value) {
+        char* end = nullptr;
+        value = strtod(text.c_str(), &end);
+        if (end == text.c_str()) return false;
+        switch (*end) {
+        case 'K': case 'k': value *= 1024.0; end++; break;
+        case 'M': case 'm': value *= 1024.0 * 1024.0; end++; break;
+        case 'G': case 'g': value *= 1024.0 * 1024.0 * 1024.0; end++; break;
+        case '%': end++; break;
+        default: break;
+        }
+        return *end == '\0';
+    }
+
+    // "30s", "2m", or plain seconds
+    bool parse_window(const std::string& text, std::chrono::seconds& window) {
+        char* end = nullptr;
+        long amount = strtol(text.c_str(), &end, 10);
+        if (end == text.c_str() || amount < 0) return false;
+        if (*end == 'm') {
+            amount *= 60;
+            end++;
+        } else if (*end == 's') {
+            end++;
+        }
+        window = std::chrono::seconds(amount);
+        return *end == '\0';
+    }
+}
+
+RulesEngine::RulesEngine() : dry_run(false) {
+}
+
+std::string RulesEngine::default_path() {
+    const char* path = getenv("TASKMGR_RULES");
+    if (path && *path) return path;
+
+    const char* config = getenv("XDG_CONFIG_HOME");
+    if (config && *config) return std::string(config) + "/linux-taskmanager/rules";
+    const char* home = getenv("HOME");
+    return std::string(home ? home : "") + "/.config/linux-taskmanager/rules";
+}
+
+bool RulesEngine::parse_rule(const std::string& line, Rule& rule) const {
+    std::istringstream tokens(line);
+    std::string word, metric, op, value;
+    if (!(tokens >> word) || word != "rule") return false;
+    if (!(tokens >> rule.name >> word) || word != "when") return false;
+    if (!(tokens >> metric >> op >> value)) return false;
+
+    bool known = false;
+    for (int i = 0; i <= MEM_AVAILABLE; i++) {
+        if (metric == METRIC_NAMES[i]) {
+            rule.metric = static_cast<Metric>(i);
+            known = true;
+        }
+    }
+    if (!known || (op != ">" && op != "<") || !parse_value(value, rule.threshold)) return false;
+    rule.greater = op == ">";
+
+    while (tokens >> word && word != "do") {
+        std::string arg;
+        if (!(tokens >> arg)) return false;
+        if (word == "for") {
+            if (!parse_window(arg, rule.window)) return false;
+        } else if (word == "user") {
+            rule.user = arg;
+        } else if (word == "process") {
+            rule.process = arg;
+        } else {
+            return false;
+        }
+    }
+    if (word != "do" || !(tokens >> word)) return false;
+
+    if (word == "renice") {
+        rule.action = RENICE;
+        if (!(tokens >> rule.nice) || rule.nice < -20 || rule.nice > 19) return false;
+    } else if (word == "suspend") {
+        rule.action = SUSPEND;
+    } else if (word == "notify") {
+        rule.action = NOTIFY;
+    } else {
+        return false;
+    }
+    return !(tokens >> word);
+}
+
+bool RulesEngine::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    rules.clear();
+    std::string line;
+    int number = 0;
+    while (std::getline(file, line)) {
+        number++;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        Rule rule;
+        if (!parse_rule(line, rule)) {
+            std::cerr << path << ":" << number << ": bad rule, skipped: " << line << std::endl;
+            continue;
+        }
+        rules.push_back(std::move(rule));
+    }
+    return true;
+}
+
+bool RulesEngine::matches_filters(const Rule& rule, const ProcessInfo& proc) {
+    if (!rule.user.empty() && proc.user != rule.user) return false;
+    return rule.process.empty() || strcasestr(proc.name.c_str(), rule.process.c_str()) != nullptr;
+}
+
+double RulesEngine::metric_value(Metric metric, const ProcessInfo& proc) {
+    switch (metric) {
+    case CPU:     return proc.cpu_usage;
+    case MEM:     return proc.memory_usage;
+    case RSS:     return static_cast<double>(proc.memory_rss);
+    case THREADS: return proc.thread_count;
+    default:      return 0;
+    }
+}
+
+void RulesEngine::update_process(Rule& rule, const ProcessInfo& proc,
+                                 std::chrono::steady_clock::time_point now) {
+    double value = metric_value(rule.metric, proc);
+    bool holds = matches_filters(rule, proc) &&
+                 (rule.greater ? value > rule.threshold : value < rule.threshold);
+
+    auto it = rule.pending.find(proc.pid);
+    if (!holds) {
+        // Dropping out of the window re-arms the rule for this PID
+        if (it != rule.pending.end()) rule.pending.erase(it);
+        return;
+    }
+    if (it == rule.pending.end()) {
+        Rule::Episode episode;
+        episode.since = now;
+        it = rule.pending.insert(std::make_pair(proc.pid, episode)).first;
+    }
+    it->second.process = proc.name;
+    it->second.value = value;
+}
+
+void RulesEngine::fire(Rule& rule, pid_t pid, const std::string& process, double value) {
+    RuleEvent event;
+    event.when = std::chrono::system_clock::now();
+    event.rule = rule.name;
+    event.pid = pid;
+    event.process = process;
+    event.dry_run = dry_run;
+
+    // Sizes read better in MB
+    double shown = value, limit = rule.threshold;
+    const char* unit = rule.metric == CPU || rule.metric == MEM || rule.metric == MEM_AVAILABLE ? "%" : "";
+    if (rule.metric == RSS) {
+        shown /= 1024.0 * 1024.0;
+        limit /= 1024.0 * 1024.0;
+        unit = " MB";
+    }
+    char detail[160];
+    snprintf(detail, sizeof(detail), "%s %.1f%s %c %.1f%s for %llds", METRIC_NAMES[rule.metric],
+             shown, unit, rule.greater ? '>' : '<', limit, unit,
+             static_cast<long long>(rule.window.count()));
+    event.detail = detail;
+
+    switch (rule.action) {
+    case RENICE:
+        event.action = "renice " + std::to_string(rule.nice);
+        break;
+    case SUSPEND:
+        event.action = "suspend";
+        break;
+    case NOTIFY:
+        event.action = "notify";
+        break;
+    }
+
+    // Never act on init or on ourselves, whatever the rules say
+    if (rule.action != NOTIFY && (pid <= 1 || pid == getpid())) {
+        event.ok = false;
+        event.detail += " (protected process)";
+    } else if (rule.action != NOTIFY && !event.dry_run) {
+        bool done = rule.action == RENICE ? ProcParser::set_priority(pid, rule.nice)
+                                          : ProcParser::suspend_process(pid);
+        if (!done) {
+            event.ok = false;
+            event.detail += std::string(" (") + strerror(errno) + ")";
+        }
+    }
+
+    std::cerr << "rules: " << event.rule << ": " << event.action << " " << event.process
+              << " (" << event.pid << "): " << event.detail
+              << (event.dry_run ? " [dry run]" : event.ok ? "" : " [failed]") << std::endl;
+
+    std::lock_guard<std::mutex> lock(log_mutex);
+    log.push_back(std::move(event));
+    if (log.size() > MAX_LOG) log.pop_front();
+    log_generation++;
+}
+
+size_t RulesEngine::evaluate(const Snapshot& snapshot) {
+    const ProcessDelta& delta = snapshot.process_delta;
+    auto now = snapshot.taken;
+    size_t fired = 0;
+
+    for (Rule& rule : rules) {
+        if (rule.metric == MEM_AVAILABLE) {
+            if (!snapshot.stats.total_memory) continue;
+            double value = snapshot.stats.available_memory * 100.0 / snapshot.stats.total_memory;
+            if (!(rule.greater ? value > rule.threshold : value < rule.threshold)) {
+                rule.system_active = false;
+                continue;
+            }
+            if (!rule.system_active) {
+                rule.system_active = true;
+                rule.system_episode.since = now;
+                rule.system_episode.fired = false;
+            }
+            if (rule.system_episode.fired || now - rule.system_episode.since < rule.window) continue;
+
+            // Rare enough that a full pass for the biggest process is fine
+            const ProcessInfo* top = nullptr;
+            for (const auto& proc : *snapshot.processes) {
+                if (proc.pid <= 1 || proc.pid == getpid() || !matches_filters(rule, proc)) continue;
+                if (!top || proc.memory_rss > top->memory_rss) top = &proc;
+            }
+            rule.system_episode.fired = true;
+            if (top) {
+                fire(rule, top->pid, top->name, value);
+                fired++;
+            }
+            continue;
+        }
+
+        if (delta.full) {
+            // Everything is re-evaluated; windows already running keep their start
+            std::unordered_map<pid_t, Rule::Episode> previous;
+            previous.swap(rule.pending);
+            for (const auto& proc : *snapshot.processes) {
+                auto it = previous.find(proc.pid);
+                if (it != previous.end()) rule.pending.insert(*it);
+                update_process(rule, proc, now);
+            }
+        } else {
+            for (pid_t pid : delta.removed) rule.pending.erase(pid);
+            for (size_t index : delta.updated) update_process(rule, (*snapshot.processes)[index], now);
+        }
+
+        // Unchanged rows still age, so windows are checked for every pending PID
+        for (auto& pair : rule.pending) {
+            Rule::Episode& episode = pair.second;
+            if (episode.fired || now - episode.since < rule.window) continue;
+            episode.fired = true;
+            fire(rule, pair.first, episode.process, episode.value);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+std::vector<RuleEvent> RulesEngine::get_log() const {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    return std::vector<RuleEvent>(log.begin(), log.end());
+}
+
+uint64_t RulesEngine::get_log_generation() const {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    return log_generation;
+}
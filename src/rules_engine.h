@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "proc_parser.h"
+
+struct Snapshot;
+
+// One line of the action log
+struct RuleEvent {
+    std::chrono::system_clock::time_point when;
+    std::string rule;
+    pid_t pid = 0;
+    std::string process;
+    std::string action;     // "renice 10", "suspend", "notify"
+    bool dry_run = false;
+    bool ok = true;         // False if the action itself failed (EPERM and such)
+    std::string detail;     // What held, e.g. "cpu 97.0 > 90 for 30s"
+};
+
+// Threshold rules checked against every collected snapshot, one per line:
+//
+//   rule <name> when <metric> <op> <value> [for <N>s] [user <name>] [process <text>] do <action>
+//
+// Per-process metrics are cpu (%), mem (%), rss (bytes, K/M/G suffixes) and
+// threads; a rule fires for each matching process once the condition has held
+// for the whole window, and re-arms when it stops holding. mem_available (% of
+// RAM) is system-wide and acts on the top RSS consumer among the processes the
+// user/process filters allow. Actions: renice <n>, suspend, notify.
+//
+// Only processes in the snapshot's delta are re-evaluated; those already over
+// a threshold are kept in a per-rule pending set so their window can expire
+// without the row changing. Collector thread, except the log and dry-run flag.
+class RulesEngine {
+public:
+    RulesEngine();
+
+    // Replaces the rule set; bad lines are reported on stderr and skipped.
+    // False if the file can't be opened.
+    bool load(const std::string& path);
+    size_t rule_count() const { return rules.size(); }
+
+    // $TASKMGR_RULES, else $XDG_CONFIG_HOME (or ~/.config)/linux-taskmanager/rules
+    static std::string default_path();
+
+    // Actions are logged but not carried out
+    void set_dry_run(bool enabled) { dry_run = enabled; }
+    bool get_dry_run() const { return dry_run; }
+
+    // Folds the snapshot in and carries out whatever fired. Returns the number
+    // of new log entries.
+    size_t evaluate(const Snapshot& snapshot);
+
+    // Newest last, at most MAX_LOG entries
+    std::vector<RuleEvent> get_log() const;
+    uint64_t get_log_generation() const;
+
+private:
+    enum Metric { CPU, MEM, RSS, THREADS, MEM_AVAILABLE };
+    enum Action { RENICE, SUSPEND, NOTIFY };
+
+    struct Rule {
+        std::string name;
+        Metric metric = CPU;
+        bool greater = true;
+        double threshold = 0;
+        std::chrono::seconds window{0};
+        std::string user;
+        std::string process;
+        Action action = NOTIFY;
+        int nice = 0;
+
+        // Per-process rules: when each over-threshold PID first crossed, and
+        // whether it already fired in this episode
+        struct Episode {
+            std::chrono::steady_clock::time_point since;
+            bool fired = false;
+            std::string process;    // As of the last update, for the log
+            double value = 0;
+        };
+        std::unordered_map<pid_t, Episode> pending;
+        // mem_available rules
+        bool system_active = false;
+        Episode system_episode;
+    };
+
+    static const size_t MAX_LOG = 500;
+
+    bool parse_rule(const std::string& line, Rule& rule) const;
+    static bool matches_filters(const Rule& rule, const ProcessInfo& proc);
+    static double metric_value(Metric metric, const ProcessInfo& proc);
+    void update_process(Rule& rule, const ProcessInfo& proc, std::chrono::steady_clock::time_point now);
+    void fire(Rule& rule, pid_t pid, const std::string& process, double value);
+
+    std::vector<Rule> rules;
+    std::atomic<bool> dry_run;
+
+    mutable std::mutex log_mutex;
+    std::deque<RuleEvent> log;
+    uint64_t log_generation = 0;
+};
@@ -0,0 +1,151 @@
+#include "shm_publisher.h"
+#include "snapshot.h"
+#include "taskmgr_shm.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+    const uint64_t INITIAL_CAPACITY = 4096;
+
+    void copy_name(char* dest, const std::string& src) {
+        size_t len = std::min(src.size(), static_cast<size_t>(TASKMGR_SHM_NAME_LEN - 1));
+        memcpy(dest, src.data(), len);
+        memset(dest + len, 0, TASKMGR_SHM_NAME_LEN - len);
+    }
+}
+
+ShmPublisher& ShmPublisher::get_instance() {
+    static ShmPublisher instance;
+    return instance;
+}
+
+ShmPublisher::ShmPublisher() {
+    char name[64];
+    snprintf(name, sizeof(name), TASKMGR_SHM_NAME_FMT, static_cast<unsigned>(getuid()));
+    shm_name = name;
+}
+
+ShmPublisher::~ShmPublisher() {
+    close_region();
+}
+
+std::string ShmPublisher::get_name() const {
+    return shm_name;
+}
+
+bool ShmPublisher::open_region() {
+    if (shm_fd >= 0) return true;
+
+    // The name is predictable, so never adopt an existing object: drop a stale
+    // one of ours (from a crash) and create afresh. One we cannot unlink
+    // belongs to someone else and makes O_EXCL fail.
+    shm_unlink(shm_name.c_str());
+    shm_fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (shm_fd < 0) {
+        perror("shm_open");
+        return false;
+    }
+
+    if (!map_capacity(INITIAL_CAPACITY)) {
+        close_region();
+        return false;
+    }
+    return true;
+}
+
+void ShmPublisher::close_region() {
+    if (header) {
+        munmap(header, mapped_size);
+        header = nullptr;
+        mapped_size = 0;
+    }
+    if (shm_fd >= 0) {
+        close(shm_fd);
+        shm_fd = -1;
+        shm_unlink(shm_name.c_str());
+    }
+}
+
+bool ShmPublisher::map_capacity(uint64_t capacity) {
+    size_t size = taskmgr_shm_size(capacity);
+    if (ftruncate(shm_fd, static_cast<off_t>(size)) < 0) {
+        perror("ftruncate");
+        return false;
+    }
+
+    void* region = header ? mremap(header, mapped_size, size, MREMAP_MAYMOVE)
+                          : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    if (region == MAP_FAILED) {
+        // A failed mremap leaves the old mapping in place; keep publishing into it
+        perror("mmap");
+        return false;
+    }
+
+    bool fresh = (header == nullptr);
+    header = static_cast<taskmgr_shm_header*>(region);
+    mapped_size = size;
+
+    if (fresh) {
+        memset(header, 0, sizeof(*header));
+        header->magic = TASKMGR_SHM_MAGIC;
+        header->version = TASKMGR_SHM_VERSION;
+    }
+    header->capacity = capacity;
+    return true;
+}
+
+void ShmPublisher::publish(const Snapshot& snapshot) {
+    if (!header) return;
+
+    uint64_t seq = __atomic_load_n(&header->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->seq, seq + 1, __ATOMIC_RELAXED);   // odd: write in progress
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    const std::vector<ProcessInfo>& processes = *snapshot.processes;
+    uint64_t count = processes.size();
+    if (count > header->capacity) {
+        uint64_t capacity = header->capacity;
+        while (capacity < count) capacity *= 2;
+        // Readers notice the larger capacity after the seqlock retries and re-map
+        if (!map_capacity(capacity)) {
+            count = header->capacity;
+        }
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    header->snapshot_seq = snapshot.sequence;
+    header->timestamp_ns = static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    header->total_cpu_usage = snapshot.stats.total_cpu_usage;
+    header->total_memory = snapshot.stats.total_memory;
+    header->available_memory = snapshot.stats.available_memory;
+    header->cached_memory = snapshot.stats.cached_memory;
+    header->uptime = snapshot.stats.uptime;
+    header->process_count = count;
+
+    taskmgr_shm_process* records = taskmgr_shm_processes(header);
+    for (uint64_t i = 0; i < count; i++) {
+        const ProcessInfo& proc = processes[i];
+        taskmgr_shm_process& rec = records[i];
+        rec.pid = proc.pid;
+        rec.ppid = proc.ppid;
+        rec.cpu_usage = proc.cpu_usage;
+        rec.memory_usage = proc.memory_usage;
+        rec.memory_rss = proc.memory_rss;
+        rec.memory_vms = proc.memory_vms;
+        rec.thread_count = proc.thread_count;
+        rec.nice = proc.nice;
+        rec.state = proc.state.empty() ? '?' : proc.state[0];
+        memset(rec.reserved, 0, sizeof(rec.reserved));
+        copy_name(rec.name, proc.name);
+        copy_name(rec.user, proc.user);
+    }
+
+    __atomic_store_n(&header->seq, seq + 2, __ATOMIC_RELEASE);   // even: consistent again
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+struct Snapshot;
+struct taskmgr_shm_header;
+
+// Publishes each collector snapshot into a shared memory object (layout in
+// taskmgr_shm.h) guarded by a seqlock, so local agents can poll it at high
+// frequency without a socket round-trip. Only the collector thread writes.
+class ShmPublisher {
+public:
+    static ShmPublisher& get_instance();
+
+    bool open_region();
+    void close_region();
+    void publish(const Snapshot& snapshot);
+
+    std::string get_name() const;
+
+    ShmPublisher(const ShmPublisher&) = delete;
+    ShmPublisher& operator=(const ShmPublisher&) = delete;
+
+private:
+    ShmPublisher();
+    ~ShmPublisher();
+
+    bool map_capacity(uint64_t capacity);
+
+    std::string shm_name;
+    int shm_fd = -1;
+    taskmgr_shm_header* header = nullptr;
+    size_t mapped_size = 0;
+};
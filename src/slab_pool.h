@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Fixed-capacity pool of T carved from blocks of BLOCK_SIZE objects. Released
+// objects go on a free list and are handed out again before any new block is
+// allocated, so steady-state churn never touches the heap and total memory is
+// bounded by max_objects. Not thread-safe; callers serialize access.
+template <typename T, size_t BLOCK_SIZE = 64>
+class SlabPool {
+public:
+    explicit SlabPool(size_t max_objects) : max_objects(max_objects), allocated(0) {}
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    // nullptr once max_objects are in use
+    T* allocate() {
+        if (free_list.empty()) {
+            if (allocated >= max_objects) return nullptr;
+            grow();
+        }
+        T* object = free_list.back();
+        free_list.pop_back();
+        return object;
+    }
+
+    void release(T* object) {
+        free_list.push_back(object);
+    }
+
+    size_t in_use() const { return allocated - free_list.size(); }
+    size_t capacity_bytes() const { return allocated * sizeof(T); }
+
+private:
+    void grow() {
+        size_t count = BLOCK_SIZE;
+        if (allocated + count > max_objects) count = max_objects - allocated;
+
+        blocks.emplace_back(new T[count]);
+        T* block = blocks.back().get();
+        for (size_t i = count; i-- > 0; ) free_list.push_back(&block[i]);
+        allocated += count;
+    }
+
+    size_t max_objects;
+    size_t allocated;
+    std::vector<std::unique_ptr<T[]>> blocks;
+    std::vector<T*> free_list;
+};
@@ -0,0 +1,93 @@
+#include "snapshot.h"
+#include <unordered_map>
+#include <cstdio>
+
+static bool process_row_changed(const ProcessInfo& a, const ProcessInfo& b) {
+    return a.cpu_usage != b.cpu_usage ||
+           a.memory_rss != b.memory_rss ||
+           a.memory_usage != b.memory_usage ||
+           a.thread_count != b.thread_count ||
+           a.socket_count != b.socket_count ||
+           a.net_send_rate != b.net_send_rate ||
+           a.net_recv_rate != b.net_recv_rate ||
+           a.state != b.state ||
+           a.name != b.name ||
+           a.user != b.user ||
+           a.uid != b.uid ||
+           a.ppid != b.ppid ||             // Reparenting moves it between app groups
+           a.exe_path != b.exe_path ||
+           a.cgroup != b.cgroup;           // Throttling shows in the Limit column
+}
+
+void compute_process_delta(const Snapshot* previous, Snapshot& current) {
+    ProcessDelta& delta = current.process_delta;
+    delta.removed.clear();
+    delta.updated.clear();
+
+    if (!previous) {
+        delta.full = true;
+        return;
+    }
+    delta.full = false;
+
+    std::unordered_map<pid_t, const ProcessInfo*> old_procs;
+    old_procs.reserve(previous->processes->size());
+    for (const auto& proc : *previous->processes) {
+        old_procs[proc.pid] = &proc;
+    }
+
+    const std::vector<ProcessInfo>& processes = *current.processes;
+    for (size_t i = 0; i < processes.size(); i++) {
+        const ProcessInfo& proc = processes[i];
+        auto it = old_procs.find(proc.pid);
+        if (it == old_procs.end()) {
+            delta.updated.push_back(i);
+            continue;
+        }
+        if (process_row_changed(*it->second, proc)) {
+            delta.updated.push_back(i);
+        }
+        // Whatever is left in the map afterwards has exited
+        old_procs.erase(it);
+    }
+
+    for (const auto& pair : old_procs) {
+        delta.removed.push_back(pair.first);
+    }
+}
+
+void append_json_string(std::string& out, const std::string& value) {
+    out += '"';
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+void append_process_json(std::string& out, const ProcessInfo& proc) {
+    char numbers[256];
+    snprintf(numbers, sizeof(numbers),
+             "{\"pid\":%d,\"ppid\":%d,\"cpu\":%.2f,\"mem\":%.2f,\"rss\":%llu,\"threads\":%d,\"nice\":%d,\"name\":",
+             proc.pid, proc.ppid, proc.cpu_usage, proc.memory_usage,
+             static_cast<unsigned long long>(proc.memory_rss), proc.thread_count, proc.nice);
+    out += numbers;
+    append_json_string(out, proc.name);
+    out += ",\"user\":";
+    append_json_string(out, proc.user);
+    out += ",\"state\":";
+    append_json_string(out, proc.state);
+    out += '}';
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include "proc_parser.h"
+#include "systemd_manager.h"
+#include "socket_index.h"
+#include "link_stats.h"
+#include "disk_stats.h"
+#include "vm_stats.h"
+
+struct ProcessDelta {
+    // Set when there is no previous snapshot (first tick); the consumer must
+    // reconcile every row. A consumer that skipped snapshots must do the same.
+    bool full = true;
+    std::vector<pid_t> removed;   // PIDs gone since the previous snapshot
+    std::vector<size_t> updated;  // Indices into Snapshot::processes of new or changed rows
+};
+
+// One uid's share of the machine, summed during the process scan
+struct UserUsage {
+    uid_t uid = 0;
+    std::string user;
+    int processes = 0;
+    int threads = 0;
+    double cpu_usage = 0;
+    double memory_usage = 0;
+    uint64_t memory_rss = 0;
+};
+
+// Everything one collector tick produced. Built on the collector thread and
+// never modified once published, so the UI can read it without locking.
+// Each collector's part is shared with the previous snapshot until that
+// collector runs again, so a tick copies pointers, not rows. Parts are never
+// null.
+struct Snapshot {
+    // Parts refreshed for this snapshot; the rest are carried over unchanged
+    // from the previous one, since each collector runs on its own period
+    enum Part : uint32_t {
+        PROCESSES   = 1 << 0,
+        SYSTEM      = 1 << 1,
+        NETWORK     = 1 << 2,
+        SERVICES    = 1 << 3,
+        STARTUP     = 1 << 4,
+        CONNECTIONS = 1 << 5,
+        DISKS       = 1 << 6,
+        ALL_PARTS   = (1 << 7) - 1
+    };
+
+    uint64_t sequence = 0;
+    uint32_t fresh = 0;
+    std::chrono::steady_clock::time_point taken;
+    SystemStats stats = {};
+    VmRates vm;                 // Refreshed with SYSTEM
+    std::shared_ptr<const std::vector<ProcessInfo>> processes = empty_part<ProcessInfo>();
+    ProcessDelta process_delta;
+    // Refreshed with PROCESSES, by first appearance
+    std::shared_ptr<const std::vector<UserUsage>> users = empty_part<UserUsage>();
+    std::shared_ptr<const std::vector<ServiceInfo>> services = empty_part<ServiceInfo>();
+    std::shared_ptr<const std::vector<StartupEntry>> startup = empty_part<StartupEntry>();
+    uint64_t startup_generation = 0;
+    std::shared_ptr<const std::vector<InterfaceStats>> interfaces = empty_part<InterfaceStats>();
+    double network_mbps = 0;    // All interfaces but loopback, both directions
+    std::shared_ptr<const std::vector<DiskDeviceStats>> disks = empty_part<DiskDeviceStats>();
+    std::shared_ptr<const std::vector<ConnectionInfo>> connections = empty_part<ConnectionInfo>();
+
+    template <typename T>
+    static std::shared_ptr<const std::vector<T>> empty_part() {
+        static const auto empty = std::make_shared<const std::vector<T>>();
+        return empty;
+    }
+};
+
+void compute_process_delta(const Snapshot* previous, Snapshot& current);
+
+// JSON helpers shared by the IPC server and other exporters
+void append_json_string(std::string& out, const std::string& value);
+void append_process_json(std::string& out, const ProcessInfo& proc);
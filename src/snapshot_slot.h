@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+// Lock-free single-producer/single-consumer hand-off of the latest value.
+// publish() replaces anything the consumer has not picked up yet, so a slow
+// consumer only ever sees the newest snapshot and nothing queues up behind it.
+template <typename T>
+class SnapshotSlot {
+public:
+    SnapshotSlot() : pending(nullptr) {}
+    ~SnapshotSlot() { delete pending.load(); }
+
+    SnapshotSlot(const SnapshotSlot&) = delete;
+    SnapshotSlot& operator=(const SnapshotSlot&) = delete;
+
+    void publish(std::shared_ptr<const T> value) {
+        auto* box = new std::shared_ptr<const T>(std::move(value));
+        delete pending.exchange(box, std::memory_order_acq_rel);
+    }
+
+    std::shared_ptr<const T> take() {
+        auto* box = pending.exchange(nullptr, std::memory_order_acq_rel);
+        if (!box) return nullptr;
+        std::shared_ptr<const T> value = std::move(*box);
+        delete box;
+        return value;
+    }
+
+private:
+    std::atomic<std::shared_ptr<const T>*> pending;
+};
@@ -0,0 +1,268 @@
+#include "socket_index.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cinttypes>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    // Stands in for the fd count of a process whose fd table we cannot read
+    const size_t UNREADABLE = static_cast<size_t>(-1);
+
+    const char* const TCP_STATES[] = {
+        "", "ESTABLISHED", "SYN_SENT", "SYN_RECV", "FIN_WAIT1", "FIN_WAIT2", "TIME_WAIT",
+        "CLOSE", "CLOSE_WAIT", "LAST_ACK", "LISTEN", "CLOSING"
+    };
+
+    // The kernel prints addresses as the in-memory words in hex, so each
+    // 32-bit group goes back into memory unchanged
+    std::string format_address(const char* hex, unsigned port, bool ipv6) {
+        char text[INET6_ADDRSTRLEN] = "?";
+
+        if (!ipv6) {
+            struct in_addr addr;
+            addr.s_addr = static_cast<uint32_t>(strtoul(hex, nullptr, 16));
+            inet_ntop(AF_INET, &addr, text, sizeof(text));
+            return std::string(text) + ":" + std::to_string(port);
+        }
+
+        struct in6_addr addr;
+        for (int i = 0; i < 4; i++) {
+            char word[9];
+            memcpy(word, hex + i * 8, 8);
+            word[8] = '\0';
+            uint32_t value = static_cast<uint32_t>(strtoul(word, nullptr, 16));
+            memcpy(&addr.s6_addr[i * 4], &value, sizeof(value));
+        }
+        inet_ntop(AF_INET6, &addr, text, sizeof(text));
+        return "[" + std::string(text) + "]:" + std::to_string(port);
+    }
+}
+
+size_t SocketIndex::count_fds(const char* fd_dir) const {
+    if (fd_count_from_stat) {
+        struct stat st;
+        if (stat(fd_dir, &st) < 0) return UNREADABLE;
+        return static_cast<size_t>(st.st_size);
+    }
+
+    DIR* dir = opendir(fd_dir);
+    if (!dir) return UNREADABLE;
+
+    size_t count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+void SocketIndex::update(std::vector<ProcessInfo>& procs) {
+    generation++;
+    const std::string& proc_root = ProcParser::get_proc_root();
+    char fd_dir[PATH_MAX];
+
+    if (!probed) {
+        // A fixture tree has no self link and directories of a fixed size,
+        // so it falls back to readdir like an old kernel
+        struct stat st;
+        fd_count_from_stat = stat((proc_root + "/self/fd").c_str(), &st) == 0 && st.st_size > 0;
+        probed = true;
+    }
+
+    for (auto& proc : procs) {
+        snprintf(fd_dir, sizeof(fd_dir), "%s/%d/fd", proc_root.c_str(), proc.pid);
+        size_t fd_count = count_fds(fd_dir);
+
+        auto it = processes.find(proc.pid);
+        bool known = it != processes.end();
+        if (!known) it = processes.emplace(proc.pid, ProcessSockets()).first;
+        ProcessSockets& entry = it->second;
+
+        // CPU time going backwards means the PID now belongs to another process
+        if (!known || proc.cpu_time < entry.cpu_time || fd_count != entry.fd_count ||
+            (generation + proc.pid) % RESCAN_TICKS == 0) {
+            rescan(proc.pid, fd_dir, entry);
+        }
+
+        entry.fd_count = fd_count;
+        entry.cpu_time = proc.cpu_time;
+        entry.generation = generation;
+        proc.socket_count = static_cast<int>(entry.inodes.size());
+    }
+
+    for (auto it = processes.begin(); it != processes.end(); ) {
+        if (it->second.generation != generation) {
+            forget(it->first, it->second);
+            it = processes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!orphans.empty()) resolve_orphans();
+}
+
+void SocketIndex::rescan(pid_t pid, const char* fd_dir, ProcessSockets& entry) {
+    forget(pid, entry);
+    entry.inodes.clear();
+
+    DIR* dir = opendir(fd_dir);
+    if (!dir) return;
+
+    char target[64];
+    struct dirent* fd_entry;
+    while ((fd_entry = readdir(dir)) != nullptr) {
+        if (fd_entry->d_name[0] < '0' || fd_entry->d_name[0] > '9') continue;
+
+        ssize_t len = readlinkat(dirfd(dir), fd_entry->d_name, target, sizeof(target) - 1);
+        if (len < 8 || strncmp(target, "socket:[", 8) != 0) continue;
+        target[len] = '\0';
+
+        uint64_t inode = strtoull(target + 8, nullptr, 10);
+        entry.inodes.push_back(inode);
+        // Sockets shared across fork() stay with whichever holder came first
+        SocketOwner& socket = owners[inode];
+        socket.holders++;
+        if (!socket.owner) socket.owner = pid;
+    }
+    closedir(dir);
+}
+
+void SocketIndex::forget(pid_t pid, const ProcessSockets& entry) {
+    for (uint64_t inode : entry.inodes) {
+        auto it = owners.find(inode);
+        if (it == owners.end()) continue;
+        if (--it->second.holders == 0) {
+            owners.erase(it);
+        } else if (it->second.owner == pid) {
+            // Another process still holds it; it becomes the owner, or
+            // resolve_orphans() picks one at the end of the tick
+            it->second.owner = 0;
+            orphans.push_back(inode);
+        }
+    }
+}
+
+void SocketIndex::resolve_orphans() {
+    size_t unresolved = 0;
+    for (uint64_t inode : orphans) {
+        auto it = owners.find(inode);
+        if (it != owners.end() && !it->second.owner) unresolved++;
+    }
+    orphans.clear();
+    if (!unresolved) return;
+
+    // Rare (a shared socket's owner exited or dropped it without the other
+    // holders being rescanned), so one pass over every fd table we know
+    for (const auto& pair : processes) {
+        for (uint64_t inode : pair.second.inodes) {
+            auto it = owners.find(inode);
+            if (it == owners.end() || it->second.owner) continue;
+            it->second.owner = pair.first;
+            if (--unresolved == 0) return;
+        }
+    }
+}
+
+pid_t SocketIndex::get_owner(uint64_t inode) const {
+    auto it = owners.find(inode);
+    return it != owners.end() ? it->second.owner : 0;
+}
+
+std::vector<ConnectionInfo> SocketIndex::get_connections() const {
+    std::vector<ConnectionInfo> connections;
+    read_inet_table("tcp", false, connections);
+    read_inet_table("tcp6", true, connections);
+    read_inet_table("udp", false, connections);
+    read_inet_table("udp6", true, connections);
+    read_unix_table(connections);
+
+    for (auto& connection : connections) {
+        connection.pid = get_owner(connection.inode);
+    }
+    return connections;
+}
+
+void SocketIndex::read_inet_table(const char* protocol, bool ipv6,
+                                  std::vector<ConnectionInfo>& out) const {
+    std::string path = ProcParser::get_proc_root() + "/net/" + protocol;
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) return;
+
+    bool udp = protocol[0] == 'u';
+    char line[512];
+    char local[65], remote[65];
+    unsigned local_port, remote_port, state;
+    uint64_t inode;
+
+    if (!fgets(line, sizeof(line), file)) {  // Column headings
+        fclose(file);
+        return;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        // sl local rem st tx:rx tr:when retrnsmt uid timeout inode
+        if (sscanf(line, " %*d: %64[0-9A-Fa-f]:%x %64[0-9A-Fa-f]:%x %x %*s %*s %*s %*u %*u %" SCNu64,
+                   local, &local_port, remote, &remote_port, &state, &inode) != 6) {
+            continue;
+        }
+
+        ConnectionInfo connection;
+        connection.protocol = protocol;
+        connection.local = format_address(local, local_port, ipv6);
+        connection.remote = format_address(remote, remote_port, ipv6);
+        if (udp && state == 7) {
+            connection.state = "UNCONN";  // Unconnected datagram socket, like ss(8)
+        } else if (state < sizeof(TCP_STATES) / sizeof(TCP_STATES[0])) {
+            connection.state = TCP_STATES[state];
+        }
+        connection.inode = inode;
+        out.push_back(std::move(connection));
+    }
+    fclose(file);
+}
+
+void SocketIndex::read_unix_table(std::vector<ConnectionInfo>& out) const {
+    std::string path = ProcParser::get_proc_root() + "/net/unix";
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) return;
+
+    char line[PATH_MAX + 128];
+    unsigned flags, state;
+    uint64_t inode;
+    int consumed;
+
+    if (!fgets(line, sizeof(line), file)) {  // Column headings
+        fclose(file);
+        return;
+    }
+    while (fgets(line, sizeof(line), file)) {
+        // Num RefCount Protocol Flags Type St Inode [Path]
+        consumed = 0;
+        if (sscanf(line, "%*s %*x %*x %x %*x %x %" SCNu64 " %n",
+                   &flags, &state, &inode, &consumed) != 3) {
+            continue;
+        }
+        line[strcspn(line, "\n")] = '\0';
+
+        ConnectionInfo connection;
+        connection.protocol = "unix";
+        connection.local = consumed > 0 ? line + consumed : "";
+        if (flags & 0x10000) {         // __SO_ACCEPTCON
+            connection.state = "LISTEN";
+        } else if (state == 3) {       // SS_CONNECTED
+            connection.state = "CONNECTED";
+        } else if (state == 1) {       // SS_UNCONNECTED
+            connection.state = "UNCONN";
+        }
+        connection.inode = inode;
+        out.push_back(std::move(connection));
+    }
+    fclose(file);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "proc_parser.h"
+
+struct ConnectionInfo {
+    std::string protocol;   // tcp, tcp6, udp, udp6 or unix
+    std::string local;      // addr:port, or the socket path for unix
+    std::string remote;
+    std::string state;
+    uint64_t inode = 0;
+    pid_t pid = 0;          // 0 if no readable fd table holds the socket
+};
+
+// Maps socket inodes to the processes holding them, from the
+// "socket:[inode]" links under /proc/[pid]/fd. Reading every fd link of every
+// process is far too slow to repeat each tick on a busy host, so update()
+// only re-reads the fd table of a process whose fd count changed, plus a
+// rotating 1/RESCAN_TICKS slice of the rest to catch a socket replaced by
+// another without the count moving. Collector thread only.
+class SocketIndex {
+public:
+    static const unsigned RESCAN_TICKS = 20;
+
+    // Refreshes ownership for the given processes, drops exited ones, and
+    // sets each ProcessInfo::socket_count
+    void update(std::vector<ProcessInfo>& procs);
+
+    // Every socket in /proc/net/{tcp,tcp6,udp,udp6,unix}, with its owner
+    std::vector<ConnectionInfo> get_connections() const;
+
+    pid_t get_owner(uint64_t inode) const;
+
+private:
+    struct ProcessSockets {
+        int64_t cpu_time = 0;
+        size_t fd_count = 0;
+        uint64_t generation = 0;
+        std::vector<uint64_t> inodes;
+    };
+
+    size_t count_fds(const char* fd_dir) const;
+    void rescan(pid_t pid, const char* fd_dir, ProcessSockets& entry);
+    void forget(pid_t pid, const ProcessSockets& entry);
+    void resolve_orphans();
+    void read_inet_table(const char* protocol, bool ipv6, std::vector<ConnectionInfo>& out) const;
+    void read_unix_table(std::vector<ConnectionInfo>& out) const;
+
+    // One per socket inode. A socket shared across fork() is counted once per
+    // fd holding it; owner is any one of those holders, 0 while unresolved.
+    struct SocketOwner {
+        pid_t owner = 0;
+        uint32_t holders = 0;
+    };
+
+    // Since Linux 6.2 stat() on /proc/[pid]/fd reports the open fd count
+    // as st_size; older kernels need a readdir. Probed on the first update(),
+    // once the proc root is set.
+    bool probed = false;
+    bool fd_count_from_stat = false;
+    uint64_t generation = 0;
+    std::unordered_map<pid_t, ProcessSockets> processes;
+    std::unordered_map<uint64_t, SocketOwner> owners;
+    std::vector<uint64_t> orphans;  // Still held, but their owner let go
+};
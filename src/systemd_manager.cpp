@@ -1,152 +1,719 @@
 #include "systemd_manager.h"
+#include "proc_parser.h"
 #include "debug.h"
+#include "privileged_helper.h"
 #include <iostream>
 #include <cstdlib>
 #include <sstream>
 #include <fstream>
 #include <dirent.h>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <set>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/sysinfo.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <gio/gio.h>
+
+namespace {
+    const char* SYSTEMD_BUS_NAME = "org.freedesktop.systemd1";
+    const char* SYSTEMD_OBJECT_PATH = "/org/freedesktop/systemd1";
+    const char* SYSTEMD_MANAGER_IFACE = "org.freedesktop.systemd1.Manager";
+    const char* SYSTEMD_UNIT_IFACE = "org.freedesktop.systemd1.Unit";
+    const char* SYSTEMD_SERVICE_IFACE = "org.freedesktop.systemd1.Service";
+    const char* DBUS_PROPERTIES_IFACE = "org.freedesktop.DBus.Properties";
+
+    // Guards everything below; signal callbacks and readers may run on different threads
+    std::recursive_mutex services_mutex;
+    GDBusConnection* services_bus = nullptr;
+    GMainContext* services_context = nullptr;
+    bool services_listed = false;
+    std::map<std::string, ServiceInfo> services_by_name;
+    std::map<std::string, std::string> service_names_by_path;
+    // Units whose Service interface (MainPID, ControlGroup) has been fetched once
+    std::set<std::string> services_resolved;
+
+    struct CgroupSample {
+        uint64_t usage_usec = 0;
+        uint64_t io_bytes = 0;
+        std::chrono::steady_clock::time_point when;
+    };
+    std::map<std::string, CgroupSample> cgroup_samples;
+
+    const char* CGROUP_SUBDIR = "/fs/cgroup";
+
+    // Startup entries, cached per file and refreshed from inotify events
+    struct StartupDir {
+        std::string path;
+        std::string source;
+        const char* suffix;
+        int wd;
+        int wants_wd;   // default.target.wants, for unit directories
+        std::chrono::steady_clock::time_point retry_after;  // While the directory is missing
+
+        StartupDir(const std::string& p, const std::string& src, const char* sfx)
+            : path(p), source(src), suffix(sfx), wd(-1), wants_wd(-1) {}
+    };
+
+    struct StartupFile {
+        ino_t inode;
+        struct timespec mtime;
+        StartupEntry entry;
+    };
+
+    const uint32_t STARTUP_WATCH_MASK = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM |
+                                        IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+    // Enabling a user unit only adds or removes a symlink here
+    const uint32_t STARTUP_WANTS_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                        IN_DELETE_SELF | IN_MOVE_SELF;
+    const char* const STARTUP_WANTS_DIR = "default.target.wants";
+    // How often a missing directory is looked for again
+    const std::chrono::seconds STARTUP_RETRY_INTERVAL(10);
+
+    std::mutex startup_mutex;
+    int startup_inotify_fd = -1;
+    std::vector<StartupDir> startup_dirs;
+    std::map<int, size_t> startup_dirs_by_wd;
+    std::map<int, size_t> startup_wants_by_wd;
+    std::map<std::string, StartupFile> startup_files;   // keyed by full path
+    std::atomic<uint64_t> startup_generation(0);
+
+    bool is_service_unit(const char* name) {
+        return name && g_str_has_suffix(name, ".service");
+    }
 
-std::vector<ServiceInfo> SystemdManager::get_all_services() {
-    std::vector<ServiceInfo> services;
-    
-    // Use systemctl to list services - simpler approach
-    std::string output = exec_command("systemctl list-units --type=service --no-pager 2>&1 | grep service");
+    // Applies a a{sv} property dictionary from either the Unit or Service interface
+    void apply_service_properties(ServiceInfo& info, GVariant* props) {
+        GVariantIter iter;
+        const gchar* key;
+        GVariant* value;
+
+        g_variant_iter_init(&iter, props);
+        while (g_variant_iter_next(&iter, "{&sv}", &key, &value)) {
+            if (g_strcmp0(key, "Description") == 0 && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)) {
+                info.description = g_variant_get_string(value, nullptr);
+            } else if (g_strcmp0(key, "LoadState") == 0 && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)) {
+                info.state = g_variant_get_string(value, nullptr);
+            } else if (g_strcmp0(key, "ActiveState") == 0 && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)) {
+                info.active = g_variant_get_string(value, nullptr);
+            } else if (g_strcmp0(key, "MainPID") == 0 && g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32)) {
+                info.main_pid = static_cast<pid_t>(g_variant_get_uint32(value));
+            } else if (g_strcmp0(key, "ControlGroup") == 0 && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)) {
+                info.cgroup_path = g_variant_get_string(value, nullptr);
+            }
+            g_variant_unref(value);
+        }
+    }
 
-    DEBUG_ACTION(std::cerr << "DEBUG systemctl output:\n" << output << std::endl);
+    // Fetches the current properties of one unit; used for new units and invalidations
+    void load_service_properties(ServiceInfo& info, const char* iface) {
+        GError* error = nullptr;
+        GVariant* reply = g_dbus_connection_call_sync(services_bus, SYSTEMD_BUS_NAME,
+            info.object_path.c_str(), DBUS_PROPERTIES_IFACE, "GetAll",
+            g_variant_new("(s)", iface), G_VARIANT_TYPE("(a{sv})"),
+            G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &error);
+        if (!reply) {
+            DEBUG_ACTION(std::cerr << "DEBUG: GetAll " << info.name << " failed: " << error->message << std::endl);
+            g_error_free(error);
+            return;
+        }
 
-    std::istringstream iss(output);
-    std::string line;
+        GVariant* props = g_variant_get_child_value(reply, 0);
+        apply_service_properties(info, props);
+        g_variant_unref(props);
+        g_variant_unref(reply);
+    }
 
-    int count = 0;
-    while (std::getline(iss, line) && count < 20) {
-        if (line.empty() || line.find("service") == std::string::npos) continue;
+    void on_unit_new(GDBusConnection*, const gchar*, const gchar*, const gchar*,
+                     const gchar*, GVariant* parameters, gpointer) {
+        const gchar* name = nullptr;
+        const gchar* path = nullptr;
+        g_variant_get(parameters, "(&s&o)", &name, &path);
+        if (!is_service_unit(name)) return;
 
-        count++;
+        std::lock_guard<std::recursive_mutex> lock(services_mutex);
+        if (services_by_name.count(name)) return;
 
-        // Parse line like: "ssh.service loaded active running OpenSSH"
-        std::istringstream line_stream(line);
-        std::string name, loaded, active, sub, description;
+        ServiceInfo info;
+        info.name = name;
+        info.object_path = path;
+        info.main_pid = 0;
+        info.unit_type = "service";
+        load_service_properties(info, SYSTEMD_UNIT_IFACE);
+        load_service_properties(info, SYSTEMD_SERVICE_IFACE);
+        services_resolved.insert(info.name);
 
-        line_stream >> name >> loaded >> active >> sub;
-        std::getline(line_stream, description);
+        service_names_by_path[info.object_path] = info.name;
+        services_by_name[info.name] = info;
+    }
 
-        if (name.empty()) continue;
+    void on_unit_removed(GDBusConnection*, const gchar*, const gchar*, const gchar*,
+                         const gchar*, GVariant* parameters, gpointer) {
+        const gchar* name = nullptr;
+        const gchar* path = nullptr;
+        g_variant_get(parameters, "(&s&o)", &name, &path);
+        if (!is_service_unit(name)) return;
+
+        std::lock_guard<std::recursive_mutex> lock(services_mutex);
+        if (services_by_name.erase(name)) {
+            service_names_by_path.erase(path);
+            services_resolved.erase(name);
+            cgroup_samples.erase(name);
+        }
+    }
 
-        ServiceInfo info;
-        info.name = name;
-        info.state = loaded;
-        info.active = active;
-        if (!description.empty() && description[0] == ' ') {
-            info.description = description.substr(1);
+    void on_properties_changed(GDBusConnection*, const gchar*, const gchar* object_path,
+                               const gchar*, const gchar*, GVariant* parameters, gpointer) {
+        const gchar* iface = nullptr;
+        GVariant* changed = nullptr;
+        GVariant* invalidated = nullptr;
+        g_variant_get(parameters, "(&s@a{sv}@as)", &iface, &changed, &invalidated);
+
+        if (g_strcmp0(iface, SYSTEMD_UNIT_IFACE) == 0 || g_strcmp0(iface, SYSTEMD_SERVICE_IFACE) == 0) {
+            std::lock_guard<std::recursive_mutex> lock(services_mutex);
+            auto path_it = service_names_by_path.find(object_path);
+            if (path_it != service_names_by_path.end()) {
+                ServiceInfo& info = services_by_name[path_it->second];
+                apply_service_properties(info, changed);
+
+                // systemd sends some properties as invalidated-only; fetch those explicitly
+                if (g_variant_n_children(invalidated) > 0) {
+                    load_service_properties(info, iface);
+                }
+            }
         }
-        info.main_pid = 0;
 
-        services.push_back(info);
-        DEBUG_ACTION(std::cerr << "DEBUG: Parsed service " << name << " state=" << loaded << " active=" << active << std::endl);
+        g_variant_unref(changed);
+        g_variant_unref(invalidated);
+    }
+
+    // Small sysfs files fit in one read; avoids stream setup for four files per unit
+    bool read_cgroup_file(const std::string& path, char* buffer, size_t size) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        ssize_t len = read(fd, buffer, size - 1);
+        close(fd);
+        if (len < 0) return false;
+        buffer[len] = '\0';
+        return true;
+    }
+
+    uint64_t parse_cgroup_key(const char* text, const char* key) {
+        const char* pos = strstr(text, key);
+        return pos ? strtoull(pos + strlen(key), nullptr, 10) : 0;
+    }
+
+    // io.stat has one line per device: "8:0 rbytes=N wbytes=N rios=N ..."
+    uint64_t sum_io_bytes(const char* text) {
+        uint64_t total = 0;
+        for (const char* pos = text; (pos = strstr(pos, "bytes=")) != nullptr; pos += 6) {
+            if (pos > text && (pos[-1] == 'r' || pos[-1] == 'w')) {
+                total += strtoull(pos + 6, nullptr, 10);
+            }
+        }
+        return total;
+    }
+
+    // Reads key=value pairs from one [section] of a .desktop or unit file.
+    // Localized keys such as Name[de] are skipped.
+    std::map<std::string, std::string> read_key_file_section(const std::string& path, const std::string& section) {
+        std::map<std::string, std::string> values;
+        std::ifstream file(path);
+        std::string line;
+        bool in_section = false;
+
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            if (line[0] == '[') {
+                in_section = (line.compare(0, section.size() + 2, "[" + section + "]") == 0);
+                continue;
+            }
+            if (!in_section) continue;
+
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) continue;
+
+            std::string key = line.substr(0, eq);
+            while (!key.empty() && key.back() == ' ') key.pop_back();
+            if (key.find('[') != std::string::npos) continue;
+
+            size_t value_start = line.find_first_not_of(' ', eq + 1);
+            // First occurrence wins, matching GKeyFile for our purposes
+            values.insert(std::make_pair(key, value_start == std::string::npos ? "" : line.substr(value_start)));
+        }
+        return values;
+    }
+
+    // A user unit starts at login when it is linked into default.target.wants
+    bool unit_wanted(const StartupDir& dir, const std::string& filename) {
+        struct stat st;
+        std::string wants = dir.path + "/" + STARTUP_WANTS_DIR + "/" + filename;
+        return lstat(wants.c_str(), &st) == 0;
+    }
+
+    StartupEntry parse_startup_file(const StartupDir& dir, const std::string& filename) {
+        StartupEntry startup;
+        startup.path = dir.path + "/" + filename;
+        startup.source = dir.source;
+        startup.name = filename.substr(0, filename.size() - strlen(dir.suffix));
+        startup.enabled = true;
+
+        if (strcmp(dir.suffix, ".desktop") == 0) {
+            auto keys = read_key_file_section(startup.path, "Desktop Entry");
+            if (!keys["Name"].empty()) startup.name = keys["Name"];
+            startup.description = keys["Comment"];
+            startup.exec = keys["Exec"];
+            startup.enabled = keys["Hidden"] != "true" && keys["X-GNOME-Autostart-enabled"] != "false";
+        } else {
+            auto unit_keys = read_key_file_section(startup.path, "Unit");
+            auto service_keys = read_key_file_section(startup.path, "Service");
+            startup.description = unit_keys["Description"];
+            startup.exec = service_keys["ExecStart"];
+
+            startup.enabled = unit_wanted(dir, filename);
+        }
+        return startup;
+    }
+
+    // Re-reads whether one unit is enabled; its file did not change, only the link
+    void refresh_unit_enabled(const StartupDir& dir, const std::string& filename) {
+        auto it = startup_files.find(dir.path + "/" + filename);
+        if (it == startup_files.end()) return;
+        bool enabled = unit_wanted(dir, filename);
+        if (it->second.entry.enabled != enabled) {
+            it->second.entry.enabled = enabled;
+            startup_generation++;
+        }
+    }
+
+    void refresh_units_enabled(const StartupDir& dir) {
+        std::string prefix = dir.path + "/";
+        for (auto it = startup_files.lower_bound(prefix);
+             it != startup_files.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            refresh_unit_enabled(dir, it->first.substr(prefix.size()));
+        }
+    }
+
+    void watch_unit_wants(StartupDir& dir, size_t index) {
+        if (dir.wants_wd >= 0) return;
+        dir.wants_wd = inotify_add_watch(startup_inotify_fd, (dir.path + "/" + STARTUP_WANTS_DIR).c_str(),
+                                         STARTUP_WANTS_MASK);
+        // Without the directory nothing is enabled; its creation shows up on the parent watch
+        if (dir.wants_wd >= 0) startup_wants_by_wd[dir.wants_wd] = index;
+        refresh_units_enabled(dir);
+    }
+
+    // Re-parses one file if its inode or mtime moved; drops it if it is gone
+    void refresh_startup_file(const StartupDir& dir, const std::string& filename) {
+        std::string path = dir.path + "/" + filename;
+        struct stat st;
+
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            if (startup_files.erase(path)) startup_generation++;
+            return;
+        }
+
+        auto it = startup_files.find(path);
+        if (it != startup_files.end() && it->second.inode == st.st_ino &&
+            it->second.mtime.tv_sec == st.st_mtim.tv_sec && it->second.mtime.tv_nsec == st.st_mtim.tv_nsec) {
+            return;
+        }
+
+        StartupFile file;
+        file.inode = st.st_ino;
+        file.mtime = st.st_mtim;
+        file.entry = parse_startup_file(dir, filename);
+        startup_files[path] = file;
+        startup_generation++;
+    }
+
+    void scan_startup_dir(const StartupDir& dir) {
+        DIR* handle = opendir(dir.path.c_str());
+        if (!handle) return;
+
+        struct dirent* entry;
+        while ((entry = readdir(handle)) != nullptr) {
+            if (entry->d_type != DT_REG && entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN) continue;
+            if (!g_str_has_suffix(entry->d_name, dir.suffix)) continue;
+            refresh_startup_file(dir, entry->d_name);
+        }
+        closedir(handle);
+    }
+
+    void forget_startup_dir(const StartupDir& dir) {
+        std::string prefix = dir.path + "/";
+        for (auto it = startup_files.lower_bound(prefix);
+             it != startup_files.end() && it->first.compare(0, prefix.size(), prefix) == 0; ) {
+            it = startup_files.erase(it);
+            startup_generation++;
+        }
+    }
+}
+
+bool SystemdManager::connect_services_bus() {
+    if (services_bus) return true;
+
+    GError* error = nullptr;
+
+    // Allow pointing at a private bus so a mock systemd service can stand in for the real one
+    const char* address = getenv("TASKMGR_SYSTEMD_BUS_ADDRESS");
+    if (address && *address) {
+        services_bus = g_dbus_connection_new_for_address_sync(address,
+            static_cast<GDBusConnectionFlags>(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                              G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+            nullptr, nullptr, &error);
+    } else {
+        services_bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, nullptr, &error);
+    }
+
+    if (!services_bus) {
+        std::cerr << "Failed to connect to system bus: " << error->message << std::endl;
+        g_error_free(error);
+        return false;
+    }
+
+    // Signal callbacks are dispatched on our own context, which is drained on every read.
+    // This keeps delivery independent of whichever thread (or main loop) is calling us.
+    services_context = g_main_context_new();
+    g_main_context_push_thread_default(services_context);
+
+    g_dbus_connection_signal_subscribe(services_bus, SYSTEMD_BUS_NAME, SYSTEMD_MANAGER_IFACE,
+        "UnitNew", SYSTEMD_OBJECT_PATH, nullptr, G_DBUS_SIGNAL_FLAGS_NONE,
+        on_unit_new, nullptr, nullptr);
+    g_dbus_connection_signal_subscribe(services_bus, SYSTEMD_BUS_NAME, SYSTEMD_MANAGER_IFACE,
+        "UnitRemoved", SYSTEMD_OBJECT_PATH, nullptr, G_DBUS_SIGNAL_FLAGS_NONE,
+        on_unit_removed, nullptr, nullptr);
+    g_dbus_connection_signal_subscribe(services_bus, SYSTEMD_BUS_NAME, DBUS_PROPERTIES_IFACE,
+        "PropertiesChanged", nullptr, nullptr, G_DBUS_SIGNAL_FLAGS_NONE,
+        on_properties_changed, nullptr, nullptr);
+
+    g_main_context_pop_thread_default(services_context);
+
+    // systemd only emits unit signals to clients that asked for them
+    GVariant* reply = g_dbus_connection_call_sync(services_bus, SYSTEMD_BUS_NAME, SYSTEMD_OBJECT_PATH,
+        SYSTEMD_MANAGER_IFACE, "Subscribe", nullptr, nullptr,
+        G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &error);
+    if (reply) {
+        g_variant_unref(reply);
+    } else {
+        DEBUG_ACTION(std::cerr << "DEBUG: Subscribe failed: " << error->message << std::endl);
+        g_clear_error(&error);
+    }
+
+    return true;
+}
+
+void SystemdManager::dispatch_service_signals() {
+    if (!services_context) return;
+    while (g_main_context_iteration(services_context, FALSE)) {}
+}
+
+std::vector<ServiceInfo> SystemdManager::get_all_services() {
+    std::vector<ServiceInfo> services;
+
+    std::lock_guard<std::recursive_mutex> lock(services_mutex);
+    if (!connect_services_bus()) return services;
+
+    if (!services_listed) {
+        GError* error = nullptr;
+        GVariant* reply = g_dbus_connection_call_sync(services_bus, SYSTEMD_BUS_NAME, SYSTEMD_OBJECT_PATH,
+            SYSTEMD_MANAGER_IFACE, "ListUnits", nullptr, G_VARIANT_TYPE("(a(ssssssouso))"),
+            G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &error);
+        if (!reply) {
+            std::cerr << "Failed to list units: " << error->message << std::endl;
+            g_error_free(error);
+            return services;
+        }
+
+        GVariantIter* units = nullptr;
+        g_variant_get(reply, "(a(ssssssouso))", &units);
+
+        const gchar *name, *description, *load_state, *active_state, *sub_state, *following, *path;
+        const gchar *job_type, *job_path;
+        guint32 job_id;
+        while (g_variant_iter_next(units, "(&s&s&s&s&s&s&ou&s&o)", &name, &description, &load_state,
+                                   &active_state, &sub_state, &following, &path, &job_id,
+                                   &job_type, &job_path)) {
+            if (!is_service_unit(name)) continue;
+
+            ServiceInfo info;
+            info.name = name;
+            info.description = description;
+            info.state = load_state;
+            info.active = active_state;
+            info.main_pid = 0;
+            info.unit_type = "service";
+            info.object_path = path;
+
+            service_names_by_path[info.object_path] = info.name;
+            services_by_name[info.name] = info;
+        }
+        g_variant_iter_free(units);
+        g_variant_unref(reply);
+
+        services_listed = true;
+        DEBUG_ACTION(std::cerr << "DEBUG: Listed " << services_by_name.size() << " services" << std::endl);
     }
 
-    DEBUG_ACTION(std::cerr << "DEBUG: Total services parsed: " << services.size() << std::endl);
+    dispatch_service_signals();
+
+    services.reserve(services_by_name.size());
+    for (const auto& pair : services_by_name) {
+        services.push_back(pair.second);
+    }
     return services;
 }
 
 ServiceInfo SystemdManager::get_service_info(const std::string& name) {
-    ServiceInfo info;
+    ServiceInfo info = {};
+    info.name = name;
 
-    std::string cmd = "systemctl status " + name;
-    std::string output = exec_command(cmd);
-    parse_service_status(output, info);
+    std::lock_guard<std::recursive_mutex> lock(services_mutex);
+    if (!connect_services_bus()) return info;
+    dispatch_service_signals();
 
+    auto it = services_by_name.find(name);
+    if (it != services_by_name.end()) {
+        info = it->second;
+    }
     return info;
 }
 
+void SystemdManager::update_service_resources(std::vector<ServiceInfo>& services) {
+    std::lock_guard<std::recursive_mutex> lock(services_mutex);
+
+    auto now = std::chrono::steady_clock::now();
+    int num_cores = get_nprocs();
+    char buffer[4096];
+
+    for (auto& svc : services) {
+        if (svc.active != "active" && svc.active != "reloading") {
+            cgroup_samples.erase(svc.name);
+            continue;
+        }
+
+        // MainPID and ControlGroup only need one round-trip per unit; later
+        // changes arrive through PropertiesChanged on the Service interface
+        auto cached = services_by_name.find(svc.name);
+        if (cached != services_by_name.end() && services_bus && !services_resolved.count(svc.name)) {
+            load_service_properties(cached->second, SYSTEMD_SERVICE_IFACE);
+            services_resolved.insert(svc.name);
+        }
+        if (cached != services_by_name.end()) {
+            svc.main_pid = cached->second.main_pid;
+            svc.cgroup_path = cached->second.cgroup_path;
+        }
+
+        std::string dir = ProcParser::get_sys_root() + CGROUP_SUBDIR +
+            (svc.cgroup_path.empty() ? "/system.slice/" + svc.name : svc.cgroup_path);
+
+        CgroupSample sample;
+        sample.when = now;
+        if (read_cgroup_file(dir + "/cpu.stat", buffer, sizeof(buffer))) {
+            sample.usage_usec = parse_cgroup_key(buffer, "usage_usec ");
+        }
+        if (read_cgroup_file(dir + "/memory.current", buffer, sizeof(buffer))) {
+            svc.memory_current = strtoull(buffer, nullptr, 10);
+        }
+        if (read_cgroup_file(dir + "/pids.current", buffer, sizeof(buffer))) {
+            svc.tasks_current = atoi(buffer);
+        }
+        if (read_cgroup_file(dir + "/io.stat", buffer, sizeof(buffer))) {
+            sample.io_bytes = sum_io_bytes(buffer);
+        }
+
+        auto last = cgroup_samples.find(svc.name);
+        if (last != cgroup_samples.end()) {
+            double elapsed_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                now - last->second.when).count();
+            if (elapsed_usec > 0) {
+                // Same scale as the Processes tab: share of total system capacity
+                if (sample.usage_usec >= last->second.usage_usec) {
+                    svc.cpu_usage = (sample.usage_usec - last->second.usage_usec) * 100.0 /
+                                    (elapsed_usec * num_cores);
+                }
+                if (sample.io_bytes >= last->second.io_bytes) {
+                    svc.io_rate = (sample.io_bytes - last->second.io_bytes) * 1000000.0 / elapsed_usec;
+                }
+            }
+        }
+        cgroup_samples[svc.name] = sample;
+    }
+}
+
 bool SystemdManager::start_service(const std::string& name) {
-    std::string cmd = "systemctl start " + name;
-    exec_command_sudo(cmd);
-    return true;  // pkexec handles the UI, so we assume success if it returns
+    return run_service_action("start", name);
 }
 
 bool SystemdManager::stop_service(const std::string& name) {
-    std::string cmd = "systemctl stop " + name;
-    exec_command_sudo(cmd);
-    return true;
+    return run_service_action("stop", name);
 }
 
 bool SystemdManager::restart_service(const std::string& name) {
-    std::string cmd = "systemctl restart " + name;
-    exec_command_sudo(cmd);
-    return true;
+    return run_service_action("restart", name);
 }
 
 bool SystemdManager::enable_service(const std::string& name) {
-    std::string cmd = "systemctl enable " + name;
-    exec_command_sudo(cmd);
-    return true;
+    return run_service_action("enable", name);
 }
 
 bool SystemdManager::disable_service(const std::string& name) {
-    std::string cmd = "systemctl disable " + name;
-    exec_command_sudo(cmd);
-    return true;
+    return run_service_action("disable", name);
 }
 
 bool SystemdManager::enable_now_service(const std::string& name) {
-    std::string cmd = "systemctl enable --now " + name;
-    exec_command_sudo(cmd);
-    return true;
+    return run_service_action("enable-now", name);
 }
 
-std::vector<StartupEntry> SystemdManager::get_startup_entries() {
-    std::vector<StartupEntry> entries;
-
-    // Check user-specific autostart
-    const char* home = getenv("HOME");
-    if (!home) return entries;
-
-    std::string autostart_dir = std::string(home) + "/.config/autostart";
-    DIR* dir = opendir(autostart_dir.c_str());
-    if (!dir) return entries;
+void SystemdManager::queue_service_action(const std::string& action, const std::string& name,
+                                          std::function<void(bool, const std::string&)> done) {
+    PrivilegedHelper::get_instance().submit({action, name, 0},
+        [done](const HelperResult& result) {
+            if (done) done(result.status == 0, result.message);
+        });
+}
 
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (entry->d_type != DT_REG) continue;
+void SystemdManager::watch_startup_dirs() {
+    if (startup_inotify_fd < 0) {
+        startup_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (startup_inotify_fd < 0) {
+            perror("inotify_init1");
+            return;
+        }
 
-        std::string filename = entry->d_name;
-        if (filename.find(".desktop") == std::string::npos) continue;
+        const char* home = getenv("HOME");
+        if (home) {
+            startup_dirs.push_back({std::string(home) + "/.config/autostart", "User autostart", ".desktop"});
+        }
+        startup_dirs.push_back({"/etc/xdg/autostart", "System autostart", ".desktop"});
+        if (home) {
+            startup_dirs.push_back({std::string(home) + "/.config/systemd/user", "User systemd", ".service"});
+        }
+    }
 
-        StartupEntry startup;
-        startup.name = filename.substr(0, filename.find(".desktop"));
-        startup.path = autostart_dir.append("/").append(filename);
-        startup.source = "User autostart";
-        startup.enabled = true;
+    // Directories that did not exist yet are retried every so often; a fresh
+    // watch means a fresh scan
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < startup_dirs.size(); i++) {
+        StartupDir& dir = startup_dirs[i];
+        if (dir.wd >= 0 || now < dir.retry_after) continue;
+
+        dir.wd = inotify_add_watch(startup_inotify_fd, dir.path.c_str(), STARTUP_WATCH_MASK);
+        if (dir.wd < 0) {
+            dir.retry_after = now + STARTUP_RETRY_INTERVAL;
+            continue;
+        }
+        startup_dirs_by_wd[dir.wd] = i;
+        scan_startup_dir(dir);
+        if (strcmp(dir.suffix, ".service") == 0) watch_unit_wants(dir, i);
+    }
+}
 
-        entries.push_back(startup);
+void SystemdManager::drain_startup_events() {
+    alignas(struct inotify_event) char buffer[4096];
+    bool rescan = false;
+
+    for (;;) {
+        ssize_t len = read(startup_inotify_fd, buffer, sizeof(buffer));
+        if (len <= 0) break;
+
+        for (char* ptr = buffer; ptr < buffer + len; ) {
+            auto* event = reinterpret_cast<struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                rescan = true;
+                continue;
+            }
+
+            auto wants_it = startup_wants_by_wd.find(event->wd);
+            if (wants_it != startup_wants_by_wd.end()) {
+                StartupDir& dir = startup_dirs[wants_it->second];
+                if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    if (!(event->mask & IN_IGNORED)) inotify_rm_watch(startup_inotify_fd, dir.wants_wd);
+                    startup_wants_by_wd.erase(wants_it);
+                    dir.wants_wd = -1;
+                    refresh_units_enabled(dir);
+                } else if (event->len > 0 && g_str_has_suffix(event->name, dir.suffix)) {
+                    refresh_unit_enabled(dir, event->name);
+                }
+                continue;
+            }
+
+            auto dir_it = startup_dirs_by_wd.find(event->wd);
+            if (dir_it == startup_dirs_by_wd.end()) continue;
+            StartupDir& dir = startup_dirs[dir_it->second];
+
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // Directory itself went away; forget its entries and re-add the watch later
+                if (!(event->mask & IN_IGNORED)) inotify_rm_watch(startup_inotify_fd, dir.wd);
+                startup_dirs_by_wd.erase(dir_it);
+                dir.wd = -1;
+                if (dir.wants_wd >= 0) {
+                    inotify_rm_watch(startup_inotify_fd, dir.wants_wd);
+                    startup_wants_by_wd.erase(dir.wants_wd);
+                    dir.wants_wd = -1;
+                }
+                forget_startup_dir(dir);
+                continue;
+            }
+
+            if (event->len > 0 && g_str_has_suffix(event->name, dir.suffix)) {
+                refresh_startup_file(dir, event->name);
+            } else if (dir.wants_wd < 0 && event->len > 0 && strcmp(event->name, STARTUP_WANTS_DIR) == 0 &&
+                       strcmp(dir.suffix, ".service") == 0) {
+                // First "systemctl --user enable" creates the directory
+                watch_unit_wants(dir, dir_it->second);
+            }
+        }
     }
-    closedir(dir);
 
-    // Check systemd user services with WantedBy=default.target
-    std::string user_services = std::string(home) + "/.config/systemd/user";
-    dir = opendir(user_services.c_str());
-    if (dir) {
-        while ((entry = readdir(dir)) != nullptr) {
-            if (entry->d_type != DT_REG) continue;
+    if (rescan) {
+        for (auto& dir : startup_dirs) {
+            if (dir.wd < 0) continue;
+            forget_startup_dir(dir);
+            scan_startup_dir(dir);
+        }
+    }
+}
 
-            std::string filename = entry->d_name;
-            if (filename.find(".service") == std::string::npos) continue;
+std::vector<StartupEntry> SystemdManager::get_startup_entries() {
+    std::vector<StartupEntry> entries;
 
-            StartupEntry startup;
-            startup.name = filename.substr(0, filename.find(".service"));
-            startup.path = user_services.append("/").append(filename);
-            startup.source = "User systemd";
-            startup.enabled = true;
+    std::lock_guard<std::mutex> lock(startup_mutex);
+    watch_startup_dirs();
+    if (startup_inotify_fd < 0) return entries;
+    drain_startup_events();
 
-            entries.push_back(startup);
+    // A user autostart file shadows the system one with the same name (XDG autostart spec)
+    std::set<std::string> user_autostart;
+    for (const auto& pair : startup_files) {
+        if (pair.second.entry.source == "User autostart") {
+            user_autostart.insert(pair.first.substr(pair.first.find_last_of('/') + 1));
         }
-        closedir(dir);
     }
 
+    entries.reserve(startup_files.size());
+    for (const auto& pair : startup_files) {
+        const StartupEntry& entry = pair.second.entry;
+        if (entry.source == "System autostart" &&
+            user_autostart.count(pair.first.substr(pair.first.find_last_of('/') + 1))) {
+            continue;
+        }
+        entries.push_back(entry);
+    }
     return entries;
 }
 
+uint64_t SystemdManager::get_startup_generation() {
+    return startup_generation.load();
+}
+
 bool SystemdManager::enable_startup(const std::string& path) {
     // For .desktop files, remove Hidden=true
     std::ifstream file(path);
@@ -157,6 +724,9 @@ bool SystemdManager::enable_startup(const std::string& path) {
         if (line.find("Hidden=") == 0) {
             content += "Hidden=false\n";
             found_hidden = true;
+        } else if (line.find("X-GNOME-Autostart-enabled=") == 0) {
+            // GNOME's own switch also counts when the entry is read back
+            content += "X-GNOME-Autostart-enabled=true\n";
         } else {
             content += line + "\n";
         }
@@ -184,6 +754,9 @@ bool SystemdManager::disable_startup(const std::string& path) {
         if (line.find("Hidden=") == 0) {
             content += "Hidden=true\n";
             found_hidden = true;
+        } else if (line.find("X-GNOME-Autostart-enabled=") == 0) {
+            // GNOME's own switch also counts when the entry is read back
+            content += "X-GNOME-Autostart-enabled=false\n";
         } else {
             content += line + "\n";
         }
@@ -201,55 +774,10 @@ bool SystemdManager::disable_startup(const std::string& path) {
     return true;
 }
 
-std::string SystemdManager::exec_command(const std::string& cmd) {
-    // Suppress both stderr and stdout warnings
-    std::string full_cmd = cmd + " 2>/dev/null";
-    FILE* pipe = popen(full_cmd.c_str(), "r");
-    if (!pipe) return "";
-
-    std::string result;
-    char buffer[512];
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        result += buffer;
-    }
-    pclose(pipe);
-
-    return result;
-}
-
-std::string SystemdManager::exec_command_sudo(const std::string& cmd) {
-    // Use pkexec for graphical sudo authentication
-    // pkexec provides a GUI password prompt and won't hang
-    std::string full_cmd = "pkexec " + cmd;
-
-    FILE* pipe = popen(full_cmd.c_str(), "r");
-    if (!pipe) return "";
-
-    std::string result;
-    char buffer[512];
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        result += buffer;
-    }
-    int status = pclose(pipe);
-
-    // If user cancelled (status != 0), that's okay
-    return result;
-}
-
-bool SystemdManager::parse_service_status(const std::string& output, ServiceInfo& info) {
-    std::istringstream iss(output);
-    std::string line;
-
-    while (std::getline(iss, line)) {
-        if (line.find("Active:") != std::string::npos) {
-            size_t pos = line.find("Active:");
-            info.active = line.substr(pos + 7);
-        }
-        if (line.find("Loaded:") != std::string::npos) {
-            size_t pos = line.find("Loaded:");
-            info.state = line.substr(pos + 7);
-        }
+bool SystemdManager::run_service_action(const std::string& action, const std::string& name) {
+    HelperResult result = PrivilegedHelper::get_instance().call({action, name, 0});
+    if (result.status != 0) {
+        std::cerr << "Service " << action << " " << name << " failed: " << result.message << std::endl;
     }
-
-    return true;
+    return result.status == 0;
 }
\ No newline at end of file
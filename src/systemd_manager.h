@@ -2,6 +2,9 @@
 
 #include <string>
 #include <vector>
+#include <functional>
+#include <cstdint>
+#include <sys/types.h>
 
 struct ServiceInfo {
     std::string name;
@@ -10,34 +13,58 @@ struct ServiceInfo {
     std::string active;
     pid_t main_pid;
     std::string unit_type;
+    std::string object_path;
+    std::string cgroup_path;
+
+    // Filled from the unit's cgroup by update_service_resources()
+    double cpu_usage = 0;
+    uint64_t memory_current = 0;
+    int tasks_current = 0;
+    double io_rate = 0;  // bytes/sec read + written
 };
 
 struct StartupEntry {
     std::string name;
     std::string path;
     std::string description;
+    std::string exec;
     bool enabled;
     std::string source;
 };
 
 class SystemdManager {
 public:
+    // Services are listed once over D-Bus and kept current from systemd's
+    // UnitNew/UnitRemoved/PropertiesChanged signals, so repeated calls are cheap.
     static std::vector<ServiceInfo> get_all_services();
     static ServiceInfo get_service_info(const std::string& name);
+    // Reads cpu.stat, memory.current, pids.current and io.stat for every active
+    // service in one pass. MainPID and cgroup path are resolved once per unit.
+    static void update_service_resources(std::vector<ServiceInfo>& services);
 
+    // Service actions run in the persistent privileged helper and report the
+    // real job result. These block; the UI uses queue_service_action instead.
     static bool start_service(const std::string& name);
     static bool stop_service(const std::string& name);
     static bool restart_service(const std::string& name);
     static bool enable_service(const std::string& name);
     static bool disable_service(const std::string& name);
     static bool enable_now_service(const std::string& name);
+    // action is one of start, stop, restart, enable, disable, enable-now
+    static void queue_service_action(const std::string& action, const std::string& name,
+                                     std::function<void(bool, const std::string&)> done);
 
+    // Autostart and user unit directories are watched with inotify; files are
+    // only re-parsed when an event names them and their inode or mtime changed.
     static std::vector<StartupEntry> get_startup_entries();
+    static uint64_t get_startup_generation();
     static bool enable_startup(const std::string& path);
     static bool disable_startup(const std::string& path);
 
 private:
-    static std::string exec_command(const std::string& cmd);
-    static std::string exec_command_sudo(const std::string& cmd);
-    static bool parse_service_status(const std::string& output, ServiceInfo& info);
+    static bool run_service_action(const std::string& action, const std::string& name);
+    static bool connect_services_bus();
+    static void dispatch_service_signals();
+    static void watch_startup_dirs();
+    static void drain_startup_events();
 };
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include "task_manager.h"
 #include "debug.h"
+#include "privileged_helper.h"
+#include "ipc_server.h"
+#include "shm_publisher.h"
+#include "diagnostics.h"
+#include "trace_recorder.h"
+#include "inspector_window.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -7,20 +13,78 @@
 #include <chrono>
 #include <sys/resource.h>
 #include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+
+#define PRIME_INTERVAL_MS 100
+
+// Service actions are queued to the privileged helper so the UI never waits on
+// authentication or systemd; the outcome is logged once the job finishes
+static void queue_service_action(const char* action, const std::string& name,
+                                 const char* done_msg, const char* fail_msg) {
+    SystemdManager::queue_service_action(action, name,
+        [name, done_msg, fail_msg](bool ok, const std::string& message) {
+            if (ok) {
+                std::cout << done_msg << name << std::endl;
+            } else {
+                std::cerr << fail_msg << name << " (" << message << ")" << std::endl;
+            }
+        });
+}
 
-#define MAX_NET 100.0
-
-const char* headers[] = {"PID", "Name", "CPU%", "Mem%", "Memory (MB)", "Threads", "User", "State"};
-const char* headers2[] = {"Name", "Description", "State", "Active", "PID"};
-const char* headers3[] = {"Name", "Enabled", "Source", "Path"};
+// Signals and renices on processes we do not own are retried through the helper
+static void escalate_process_action(const HelperRequest& request, const char* done_msg, const char* fail_msg) {
+    PrivilegedHelper::get_instance().submit(request,
+        [request, done_msg, fail_msg](const HelperResult& result) {
+            if (result.status == 0) {
+                std::cout << done_msg << request.target << std::endl;
+            } else {
+                std::cerr << fail_msg << request.target << " (" << result.message << ")" << std::endl;
+            }
+        });
+}
 
-TaskManager::TaskManager() : running(true), paused(false) {
-    last_network_time = std::chrono::steady_clock::now();
-    last_network_stats = get_network_stats();
+const char* headers[] = {"PID", "Name", "CPU%", "Mem%", "Memory (MB)", "Threads", "User", "State", "Sockets", "Send (KB/s)", "Recv (KB/s)", "Limit"};
+const char* headers2[] = {"Name", "Description", "State", "Active", "PID", "CPU%", "Memory (MB)", "Tasks", "I/O (KB/s)"};
+const char* headers3[] = {"Name", "Enabled", "Source", "Path", "Command"};
+const char* headers4[] = {"Protocol", "Local Address", "Remote Address", "State", "PID", "Process"};
+const char* headers5[] = {"Application", "Processes", "CPU%", "Mem%", "Memory (MB)", "Threads"};
+const char* headers6[] = {"User", "UID", "Processes", "Threads", "CPU%", "Mem%", "Memory (MB)"};
+const char* headers7[] = {"Time", "Rule", "PID", "Process", "Action", "Result", "Detail"};
+
+TaskManager::TaskManager() : running(true), paused(false), apply_pending(false) {
+    // System stats first: the process collector needs total memory for Mem%
+    system_collector = scheduler.add_collector("system", std::chrono::milliseconds(1000),
+                                               CollectorScheduler::CHEAP);
+    processes_collector = scheduler.add_collector("processes", std::chrono::milliseconds(500),
+                                                  CollectorScheduler::MODERATE);
+    network_collector = scheduler.add_collector("network", std::chrono::milliseconds(1000),
+                                                CollectorScheduler::CHEAP);
+    // Disk history is kept from startup like the network one
+    disks_collector = scheduler.add_collector("disks", std::chrono::milliseconds(1000),
+                                              CollectorScheduler::CHEAP);
+    // Unit state arrives over D-Bus signals; this is mostly cgroup counters
+    services_collector = scheduler.add_collector("services", std::chrono::milliseconds(2000),
+                                                 CollectorScheduler::MODERATE, false);
+    // Only drains inotify events, and entries rarely change
+    startup_collector = scheduler.add_collector("startup", std::chrono::milliseconds(5000),
+                                                CollectorScheduler::CHEAP, false);
+    // Reads /proc/net tables; socket ownership itself is kept by the process scan
+    connections_collector = scheduler.add_collector("connections", std::chrono::milliseconds(2000),
+                                                    CollectorScheduler::MODERATE, false);
+
+    rules_path = RulesEngine::default_path();
+    rules_loaded = rules_engine.load(rules_path);
+    if (rules_loaded) {
+        std::cerr << "Loaded " << rules_engine.rule_count() << " rules from " << rules_path << std::endl;
+    }
+    if (getenv("TASKMGR_RULES_DRY_RUN")) rules_engine.set_dry_run(true);
 }
 
 TaskManager::~TaskManager() {
     running = false;
+    scheduler.wake();
     if (refresh_thread.joinable()) {
         refresh_thread.join();
     }
@@ -61,26 +125,35 @@ void TaskManager::run() {
 
     gtk_container_add(GTK_CONTAINER(window), vbox);
 
+    // Only Processes is built up front; the other tabs get an empty page that
+    // is filled in (and starts being collected) the first time it is shown
     setup_processes_tab();
-    setup_services_tab();
-    setup_startup_tab();
-    setup_performance_tab();
-
+    services_page = add_lazy_page("Services");
+    startup_page = add_lazy_page("Startup");
+    performance_page = add_lazy_page("Performance");
+    connections_page = add_lazy_page("Connections");
+    users_page = add_lazy_page("Users");
+    rules_page = add_lazy_page("Rules");
+
+    g_signal_connect(notebook, "switch-page", G_CALLBACK(on_switch_page), this);
     g_signal_connect(window, "delete-event", G_CALLBACK(on_delete_event), this);
+    g_signal_connect(window, "key-press-event", G_CALLBACK(on_key_press), this);
     g_signal_connect(end_process_btn, "clicked", G_CALLBACK(on_end_process), this);
     g_signal_connect(pause_button, "toggled", G_CALLBACK(on_pause_toggled), this);
     g_signal_connect(search_entry, "search-changed", G_CALLBACK(on_search_changed), this);
 
     gtk_widget_show_all(window);
 
-    refresh_thread = std::thread([this]() {
-        while (running) {
-            if (!paused) {
-                g_idle_add(refresh_data, this);
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        }
-    });
+    TraceRecorder::set_thread_name("ui");
+    if (getenv("TASKMGR_DIAGNOSTICS")) show_diagnostics_tab();
+
+    // Benchmark mode: measure one cold start to the first painted row and exit
+    if (getenv("TASKMGR_STARTUP_BENCH")) {
+        first_paint_handler = g_signal_connect_after(processes_tab.treeview, "draw",
+                                                     G_CALLBACK(on_first_paint), this);
+    }
+
+    refresh_thread = std::thread([this]() { collector_loop(); });
 
     gtk_main();
 }
@@ -90,7 +163,7 @@ void TaskManager::setup_processes_tab() {
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
         GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
 
-    processes_tab.store = gtk_list_store_new(8,
+    processes_tab.store = gtk_list_store_new(13,
         G_TYPE_INT,      // PID
         G_TYPE_STRING,   // Name
         G_TYPE_DOUBLE,   // CPU%
@@ -98,13 +171,23 @@ void TaskManager::setup_processes_tab() {
         G_TYPE_UINT64,   // Memory (MB)
         G_TYPE_INT,      // Threads
         G_TYPE_STRING,   // User
-        G_TYPE_STRING    // State
+        G_TYPE_STRING,   // State
+        G_TYPE_INT,      // Sockets
+        G_TYPE_DOUBLE,   // Send (KB/s)
+        G_TYPE_DOUBLE,   // Recv (KB/s)
+        G_TYPE_STRING,   // Limit (cgroup throttle)
+        G_TYPE_UINT      // UID, not shown; for the Users tab drill-down
     );
 
     processes_tab.filter = GTK_TREE_MODEL_FILTER(gtk_tree_model_filter_new(GTK_TREE_MODEL(processes_tab.store), nullptr));
     gtk_tree_model_filter_set_visible_func(processes_tab.filter,
         [](GtkTreeModel* model, GtkTreeIter* iter, gpointer data) -> gboolean {
             auto* self = static_cast<TaskManager*>(data);
+            if (self->filter_uid != static_cast<uid_t>(-1)) {
+                guint uid;
+                gtk_tree_model_get(model, iter, 12, &uid, -1);
+                if (uid != self->filter_uid) return FALSE;
+            }
             if (self->current_search_query.empty()) return TRUE;
 
             gchar* name = nullptr;
@@ -121,7 +204,7 @@ void TaskManager::setup_processes_tab() {
     g_object_unref(processes_tab.filter);
 
     // Create sortable columns
-    for (int i = 0; i < 8; i++) {
+    for (int i = 0; i < 12; i++) {
         GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
         GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
             headers[i], renderer, "text", i, nullptr);
@@ -144,12 +227,12 @@ void TaskManager::setup_processes_tab() {
             return (pid_a > pid_b) ? 1 : (pid_a < pid_b) ? -1 : 0;
         }, nullptr, nullptr);
 
-    for (int i = 1; i < 8; i++) {
+    for (int i = 1; i < 12; i++) {
         gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(processes_tab.store), i,
             [](GtkTreeModel* model, GtkTreeIter* a, GtkTreeIter* b, gpointer user_data) -> gint {
                 int col = GPOINTER_TO_INT(user_data);
 
-                if (col == 1 || col == 6 || col == 7) {  // String columns: Name, User, State
+                if (col == 1 || col == 6 || col == 7 || col == 11) {  // String columns: Name, User, State, Limit
                     gchar *str_a, *str_b;
                     gtk_tree_model_get(model, a, col, &str_a, -1);
                     gtk_tree_model_get(model, b, col, &str_b, -1);
@@ -157,7 +240,7 @@ void TaskManager::setup_processes_tab() {
                     g_free(str_a);
                     g_free(str_b);
                     return result;
-                } else if (col == 2 || col == 3) {  // Double columns: CPU%, Mem%
+                } else if (col == 2 || col == 3 || col == 9 || col == 10) {  // Double columns: CPU%, Mem%, Send, Recv
                     gdouble val_a, val_b;
                     gtk_tree_model_get(model, a, col, &val_a, -1);
                     gtk_tree_model_get(model, b, col, &val_b, -1);
@@ -167,7 +250,7 @@ void TaskManager::setup_processes_tab() {
                     gtk_tree_model_get(model, a, col, &val_a, -1);
                     gtk_tree_model_get(model, b, col, &val_b, -1);
                     return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
-                } else {  // Int columns: Threads
+                } else {  // Int columns: Threads, Sockets
                     gint val_a, val_b;
                     gtk_tree_model_get(model, a, col, &val_a, -1);
                     gtk_tree_model_get(model, b, col, &val_b, -1);
@@ -180,8 +263,194 @@ void TaskManager::setup_processes_tab() {
     g_signal_connect(processes_tab.treeview, "button-press-event",
                      G_CALLBACK(on_processes_button_press), this);
 
+    g_signal_connect(gtk_tree_view_get_selection(GTK_TREE_VIEW(processes_tab.treeview)), "changed",
+                     G_CALLBACK(on_process_selection_changed), this);
+
     gtk_container_add(GTK_CONTAINER(scrolled), processes_tab.treeview);
-    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), scrolled, gtk_label_new("Processes"));
+    processes_list = scrolled;
+
+    GtkWidget* group_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(group_box), 5);
+    gtk_box_pack_start(GTK_BOX(group_box), gtk_label_new("Group:"), FALSE, FALSE, 0);
+    group_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(group_combo), "None");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(group_combo), "Apps by executable");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(group_combo), "Apps by parent");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(group_combo), 0);
+    g_signal_connect(group_combo, "changed", G_CALLBACK(on_group_mode_changed), this);
+    gtk_box_pack_start(GTK_BOX(group_box), group_combo, FALSE, FALSE, 0);
+
+    // Set by drilling down from the Users tab
+    user_filter_label = GTK_LABEL(gtk_label_new(nullptr));
+    gtk_box_pack_start(GTK_BOX(group_box), GTK_WIDGET(user_filter_label), FALSE, FALSE, 10);
+    user_filter_button = gtk_button_new_with_label("Show all users");
+    g_signal_connect(user_filter_button, "clicked", G_CALLBACK(on_user_filter_cleared), this);
+    gtk_box_pack_start(GTK_BOX(group_box), user_filter_button, FALSE, FALSE, 0);
+    gtk_widget_set_no_show_all(GTK_WIDGET(user_filter_label), TRUE);
+    gtk_widget_set_no_show_all(user_filter_button, TRUE);
+
+    // Only one of the two lists is shown at a time
+    apps_list = create_apps_view();
+    gtk_widget_set_no_show_all(apps_list, TRUE);
+
+    GtkWidget* lists = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    gtk_box_pack_start(GTK_BOX(lists), group_box, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(lists), processes_list, TRUE, TRUE, 0);
+    gtk_box_pack_start(GTK_BOX(lists), apps_list, TRUE, TRUE, 0);
+
+    GtkWidget* paned = gtk_paned_new(GTK_ORIENTATION_VERTICAL);
+    gtk_paned_pack1(GTK_PANED(paned), lists, TRUE, FALSE);
+    gtk_paned_pack2(GTK_PANED(paned), create_process_details(), FALSE, FALSE);
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), paned, gtk_label_new("Processes"));
+}
+
+GtkWidget* TaskManager::create_apps_view() {
+    GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+        GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+
+    apps_tab.store = gtk_list_store_new(6,
+        G_TYPE_STRING,   // Application
+        G_TYPE_INT,      // Processes
+        G_TYPE_DOUBLE,   // CPU%
+        G_TYPE_DOUBLE,   // Memory%
+        G_TYPE_UINT64,   // Memory (MB)
+        G_TYPE_INT       // Threads
+    );
+
+    apps_tab.treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(apps_tab.store));
+    g_object_unref(apps_tab.store);
+
+    // Create sortable columns
+    for (int i = 0; i < 6; i++) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
+            headers5[i], renderer, "text", i, nullptr);
+        gtk_tree_view_column_set_resizable(column, TRUE);
+        gtk_tree_view_column_set_sort_column_id(column, i);
+        gtk_tree_view_column_set_clickable(column, TRUE);
+
+        g_signal_connect(column, "clicked", G_CALLBACK(on_column_clicked), this);
+
+        gtk_tree_view_append_column(GTK_TREE_VIEW(apps_tab.treeview), column);
+    }
+
+    // Make store sortable
+    for (int i = 0; i < 6; i++) {
+        gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(apps_tab.store), i,
+            [](GtkTreeModel* model, GtkTreeIter* a, GtkTreeIter* b, gpointer user_data) -> gint {
+                int col = GPOINTER_TO_INT(user_data);
+
+                if (col == 0) {  // String column: Application
+                    gchar *str_a, *str_b;
+                    gtk_tree_model_get(model, a, col, &str_a, -1);
+                    gtk_tree_model_get(model, b, col, &str_b, -1);
+                    int result = g_strcmp0(str_a, str_b);
+                    g_free(str_a);
+                    g_free(str_b);
+                    return result;
+                } else if (col == 2 || col == 3) {  // Double columns: CPU%, Mem%
+                    gdouble val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                } else if (col == 4) {  // UINT64: Memory MB
+                    guint64 val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                } else {  // Int columns: Processes, Threads
+                    gint val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                }
+            }, GINT_TO_POINTER(i), nullptr);
+    }
+
+    gtk_container_add(GTK_CONTAINER(scrolled), apps_tab.treeview);
+    gtk_widget_show(apps_tab.treeview);
+    return scrolled;
+}
+
+void TaskManager::on_group_mode_changed(GtkComboBox* combo, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+    int active = gtk_combo_box_get_active(combo);
+
+    self->apps_mode = active > 0;
+    // Totals are only kept while shown, so each switch starts from the
+    // latest snapshot rather than from deltas that were never folded in
+    gtk_list_store_clear(self->apps_tab.store);
+    self->app_rows.clear();
+    self->app_groups.set_mode(active == 2 ? AppGroups::BY_ANCESTOR : AppGroups::BY_EXECUTABLE);
+
+    if (self->apps_mode) {
+        if (self->latest_snapshot) self->refresh_apps(*self->latest_snapshot);
+        gtk_widget_hide(self->processes_list);
+        gtk_widget_show(self->apps_list);
+    } else {
+        gtk_widget_hide(self->apps_list);
+        gtk_widget_show(self->processes_list);
+    }
+}
+
+GtkWidget* TaskManager::create_process_details() {
+    GtkWidget* vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(vbox), 5);
+
+    details_label = GTK_LABEL(gtk_label_new("Select a process to see its recent history"));
+    gtk_widget_set_halign(GTK_WIDGET(details_label), GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(details_label), FALSE, FALSE, 0);
+
+    GtkWidget* hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    GtkWidget** areas[] = {&history_cpu_area, &history_rss_area, &history_io_area};
+    for (GtkWidget** area : areas) {
+        *area = gtk_drawing_area_new();
+        gtk_widget_set_size_request(*area, -1, 50);
+        g_signal_connect(*area, "draw", G_CALLBACK(on_history_draw), this);
+        gtk_box_pack_start(GTK_BOX(hbox), *area, TRUE, TRUE, 0);
+    }
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, 0);
+    return vbox;
+}
+
+void TaskManager::on_process_selection_changed(GtkTreeSelection* selection, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+    GtkTreeModel* model;
+    GtkTreeIter iter;
+
+    pid_t pid = 0;
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        gint selected;
+        gtk_tree_model_get(model, &iter, 0, &selected, -1);
+        pid = selected;
+    }
+    if (pid == self->selected_pid) return;
+
+    self->selected_pid = pid;
+    self->process_history.pin(pid);
+    self->refresh_process_details();
+}
+
+void TaskManager::refresh_process_details() {
+    if (!details_label) return;
+
+    selected_history = selected_pid > 0 ? process_history.get(selected_pid) : std::vector<ProcessSample>();
+    if (selected_history.empty()) {
+        gtk_label_set_text(details_label, selected_pid > 0
+            ? "No history for this process yet"
+            : "Select a process to see its recent history");
+    } else {
+        const ProcessSample& last = selected_history.back();
+        gchar* text = g_strdup_printf("PID %d    CPU %.1f%%    RSS %.1f MB    I/O %.1f KB/s    (last %zu samples)",
+            selected_pid, last.cpu, last.rss_kb / 1024.0, last.io_rate / 1024.0, selected_history.size());
+        gtk_label_set_text(details_label, text);
+        g_free(text);
+    }
+
+    gtk_widget_queue_draw(history_cpu_area);
+    gtk_widget_queue_draw(history_rss_area);
+    gtk_widget_queue_draw(history_io_area);
 }
 
 void TaskManager::setup_services_tab() {
@@ -189,19 +458,23 @@ void TaskManager::setup_services_tab() {
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
         GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
 
-    services_tab.store = gtk_list_store_new(5,
+    services_tab.store = gtk_list_store_new(9,
         G_TYPE_STRING,   // Name
         G_TYPE_STRING,   // Description
         G_TYPE_STRING,   // State
         G_TYPE_STRING,   // Active
-        G_TYPE_INT       // PID
+        G_TYPE_INT,      // PID
+        G_TYPE_DOUBLE,   // CPU%
+        G_TYPE_UINT64,   // Memory (MB)
+        G_TYPE_INT,      // Tasks
+        G_TYPE_DOUBLE    // I/O (KB/s)
     );
 
     services_tab.treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(services_tab.store));
     g_object_unref(services_tab.store);
 
     // Create sortable columns
-    for (int i = 0; i < 5; i++) {
+    for (int i = 0; i < 9; i++) {
         GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
         GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
             headers2[i], renderer, "text", i, nullptr);
@@ -215,16 +488,26 @@ void TaskManager::setup_services_tab() {
     }
 
     // Make store sortable
-    for (int i = 0; i < 5; i++) {
+    for (int i = 0; i < 9; i++) {
         gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(services_tab.store), i,
             [](GtkTreeModel* model, GtkTreeIter* a, GtkTreeIter* b, gpointer user_data) -> gint {
                 int col = GPOINTER_TO_INT(user_data);
 
-                if (col == 4) {  // PID column
+                if (col == 4 || col == 7) {  // Int columns: PID, Tasks
                     gint val_a, val_b;
                     gtk_tree_model_get(model, a, col, &val_a, -1);
                     gtk_tree_model_get(model, b, col, &val_b, -1);
                     return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                } else if (col == 5 || col == 8) {  // Double columns: CPU%, I/O
+                    gdouble val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                } else if (col == 6) {  // UINT64: Memory MB
+                    guint64 val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
                 } else {  // String columns
                     gchar *str_a, *str_b;
                     gtk_tree_model_get(model, a, col, &str_a, -1);
@@ -243,7 +526,8 @@ void TaskManager::setup_services_tab() {
     g_signal_connect(services_tab.treeview, "button-press-event",
                      G_CALLBACK(on_services_button_press), this);
 
-    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), scrolled, gtk_label_new("Services"));
+    gtk_box_pack_start(GTK_BOX(services_page), scrolled, TRUE, TRUE, 0);
+    gtk_widget_show_all(services_page);
 }
 
 void TaskManager::setup_startup_tab() {
@@ -251,18 +535,19 @@ void TaskManager::setup_startup_tab() {
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
         GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
 
-    startup_tab.store = gtk_list_store_new(4,
+    startup_tab.store = gtk_list_store_new(5,
         G_TYPE_STRING,   // Name
         G_TYPE_BOOLEAN,  // Enabled
         G_TYPE_STRING,   // Source
-        G_TYPE_STRING    // Path
+        G_TYPE_STRING,   // Path
+        G_TYPE_STRING    // Command
     );
 
     startup_tab.treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(startup_tab.store));
     g_object_unref(startup_tab.store);
 
     // Create sortable columns
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < 5; i++) {
         GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
         GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
             headers3[i], renderer, "text", i, nullptr);
@@ -276,7 +561,7 @@ void TaskManager::setup_startup_tab() {
     }
 
     // Make store sortable
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < 5; i++) {
         gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(startup_tab.store), i,
             [](GtkTreeModel* model, GtkTreeIter* a, GtkTreeIter* b, gpointer user_data) -> gint {
                 int col = GPOINTER_TO_INT(user_data);
@@ -304,7 +589,288 @@ void TaskManager::setup_startup_tab() {
     g_signal_connect(startup_tab.treeview, "button-press-event",
                      G_CALLBACK(on_startup_button_press), this);
 
-    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), scrolled, gtk_label_new("Startup"));
+    gtk_box_pack_start(GTK_BOX(startup_page), scrolled, TRUE, TRUE, 0);
+    gtk_widget_show_all(startup_page);
+}
+
+void TaskManager::setup_connections_tab() {
+    GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+        GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+
+    connections_tab.store = gtk_list_store_new(6,
+        G_TYPE_STRING,   // Protocol
+        G_TYPE_STRING,   // Local Address
+        G_TYPE_STRING,   // Remote Address
+        G_TYPE_STRING,   // State
+        G_TYPE_INT,      // PID
+        G_TYPE_STRING    // Process
+    );
+
+    connections_tab.treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(connections_tab.store));
+    g_object_unref(connections_tab.store);
+
+    // Create sortable columns
+    for (int i = 0; i < 6; i++) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
+            headers4[i], renderer, "text", i, nullptr);
+        gtk_tree_view_column_set_resizable(column, TRUE);
+        gtk_tree_view_column_set_sort_column_id(column, i);
+        gtk_tree_view_column_set_clickable(column, TRUE);
+
+        g_signal_connect(column, "clicked", G_CALLBACK(on_column_clicked), this);
+
+        gtk_tree_view_append_column(GTK_TREE_VIEW(connections_tab.treeview), column);
+    }
+
+    // Make store sortable
+    for (int i = 0; i < 6; i++) {
+        gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(connections_tab.store), i,
+            [](GtkTreeModel* model, GtkTreeIter* a, GtkTreeIter* b, gpointer user_data) -> gint {
+                int col = GPOINTER_TO_INT(user_data);
+
+                if (col == 4) {  // PID column (int)
+                    gint val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                } else {  // String columns
+                    gchar *str_a, *str_b;
+                    gtk_tree_model_get(model, a, col, &str_a, -1);
+                    gtk_tree_model_get(model, b, col, &str_b, -1);
+                    int result = g_strcmp0(str_a, str_b);
+                    g_free(str_a);
+                    g_free(str_b);
+                    return result;
+                }
+            }, GINT_TO_POINTER(i), nullptr);
+    }
+
+    gtk_container_add(GTK_CONTAINER(scrolled), connections_tab.treeview);
+    gtk_box_pack_start(GTK_BOX(connections_page), scrolled, TRUE, TRUE, 0);
+    gtk_widget_show_all(connections_page);
+}
+
+void TaskManager::setup_users_tab() {
+    GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+        GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+
+    users_tab.store = gtk_list_store_new(7,
+        G_TYPE_STRING,   // User
+        G_TYPE_UINT,     // UID
+        G_TYPE_INT,      // Processes
+        G_TYPE_INT,      // Threads
+        G_TYPE_DOUBLE,   // CPU%
+        G_TYPE_DOUBLE,   // Mem%
+        G_TYPE_UINT64    // Memory (MB)
+    );
+
+    users_tab.treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(users_tab.store));
+    g_object_unref(users_tab.store);
+
+    // Create sortable columns
+    for (int i = 0; i < 7; i++) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
+            headers6[i], renderer, "text", i, nullptr);
+        gtk_tree_view_column_set_resizable(column, TRUE);
+        gtk_tree_view_column_set_sort_column_id(column, i);
+        gtk_tree_view_column_set_clickable(column, TRUE);
+
+        g_signal_connect(column, "clicked", G_CALLBACK(on_column_clicked), this);
+
+        gtk_tree_view_append_column(GTK_TREE_VIEW(users_tab.treeview), column);
+    }
+
+    // Make store sortable
+    for (int i = 0; i < 7; i++) {
+        gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(users_tab.store), i,
+            [](GtkTreeModel* model, GtkTreeIter* a, GtkTreeIter* b, gpointer user_data) -> gint {
+                int col = GPOINTER_TO_INT(user_data);
+
+                if (col == 0) {  // String column: User
+                    gchar *str_a, *str_b;
+                    gtk_tree_model_get(model, a, col, &str_a, -1);
+                    gtk_tree_model_get(model, b, col, &str_b, -1);
+                    int result = g_strcmp0(str_a, str_b);
+                    g_free(str_a);
+                    g_free(str_b);
+                    return result;
+                } else if (col == 1) {  // UINT: UID
+                    guint val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                } else if (col == 4 || col == 5) {  // Double columns: CPU%, Mem%
+                    gdouble val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                } else if (col == 6) {  // UINT64: Memory MB
+                    guint64 val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                } else {  // Int columns: Processes, Threads
+                    gint val_a, val_b;
+                    gtk_tree_model_get(model, a, col, &val_a, -1);
+                    gtk_tree_model_get(model, b, col, &val_b, -1);
+                    return (val_a > val_b) ? 1 : (val_a < val_b) ? -1 : 0;
+                }
+            }, GINT_TO_POINTER(i), nullptr);
+    }
+
+    // Double-click (or Enter) lists that user's processes
+    g_signal_connect(users_tab.treeview, "row-activated", G_CALLBACK(on_user_activated), this);
+
+    gtk_container_add(GTK_CONTAINER(scrolled), users_tab.treeview);
+    gtk_box_pack_start(GTK_BOX(users_page), scrolled, TRUE, TRUE, 0);
+    gtk_widget_show_all(users_page);
+}
+
+void TaskManager::refresh_users(const Snapshot& snapshot) {
+    std::set<uid_t> present;
+    for (const auto& usage : *snapshot.users) {
+        present.insert(usage.uid);
+
+        auto row = user_rows.find(usage.uid);
+        if (row == user_rows.end()) {
+            GtkTreeIter new_iter;
+            gtk_list_store_append(users_tab.store, &new_iter);
+            row = user_rows.insert(std::make_pair(usage.uid, new_iter)).first;
+        }
+        gtk_list_store_set(users_tab.store, &row->second,
+            0, usage.user.c_str(),
+            1, static_cast<guint>(usage.uid),
+            2, usage.processes,
+            3, usage.threads,
+            4, usage.cpu_usage,
+            5, usage.memory_usage,
+            6, usage.memory_rss / (1024 * 1024),
+            -1);
+    }
+
+    for (auto it = user_rows.begin(); it != user_rows.end(); ) {
+        if (!present.count(it->first)) {
+            gtk_list_store_remove(users_tab.store, &it->second);
+            it = user_rows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TaskManager::on_user_activated(GtkTreeView* treeview, GtkTreePath* path, GtkTreeViewColumn*, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+    GtkTreeModel* model = gtk_tree_view_get_model(treeview);
+    GtkTreeIter iter;
+    if (!gtk_tree_model_get_iter(model, &iter, path)) return;
+
+    gchar* user = nullptr;
+    guint uid;
+    gtk_tree_model_get(model, &iter, 0, &user, 1, &uid, -1);
+    self->filter_uid = uid;
+
+    gchar* text = g_strdup_printf("Showing processes of %s", user ? user : "unknown");
+    gtk_label_set_text(self->user_filter_label, text);
+    g_free(text);
+    g_free(user);
+    gtk_widget_show(GTK_WIDGET(self->user_filter_label));
+    gtk_widget_show(self->user_filter_button);
+
+    // Processes are per-PID rows; the Apps mode has no per-user split
+    if (self->apps_mode) gtk_combo_box_set_active(GTK_COMBO_BOX(self->group_combo), 0);
+    gtk_tree_model_filter_refilter(self->processes_tab.filter);
+    gtk_notebook_set_current_page(GTK_NOTEBOOK(self->notebook), 0);
+}
+
+void TaskManager::on_user_filter_cleared(GtkWidget*, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+    self->filter_uid = static_cast<uid_t>(-1);
+    gtk_widget_hide(GTK_WIDGET(self->user_filter_label));
+    gtk_widget_hide(self->user_filter_button);
+    gtk_tree_model_filter_refilter(self->processes_tab.filter);
+}
+
+void TaskManager::setup_rules_tab() {
+    GtkWidget* header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(header), 5);
+
+    GtkWidget* dry_run = gtk_check_button_new_with_label("Dry run (log only)");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(dry_run), rules_engine.get_dry_run());
+    g_signal_connect(dry_run, "toggled", G_CALLBACK(on_rules_dry_run_toggled), this);
+    gtk_box_pack_start(GTK_BOX(header), dry_run, FALSE, FALSE, 0);
+
+    gchar* status = rules_loaded
+        ? g_strdup_printf("%zu rules from %s", rules_engine.rule_count(), rules_path.c_str())
+        : g_strdup_printf("No rules file at %s", rules_path.c_str());
+    GtkWidget* status_label = gtk_label_new(status);
+    g_free(status);
+    gtk_box_pack_start(GTK_BOX(header), status_label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(rules_page), header, FALSE, FALSE, 0);
+
+    GtkWidget* scrolled = gtk_scrolled_window_new(nullptr, nullptr);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+        GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+
+    rules_tab.store = gtk_list_store_new(7,
+        G_TYPE_STRING,   // Time
+        G_TYPE_STRING,   // Rule
+        G_TYPE_INT,      // PID
+        G_TYPE_STRING,   // Process
+        G_TYPE_STRING,   // Action
+        G_TYPE_STRING,   // Result
+        G_TYPE_STRING    // Detail
+    );
+
+    // A log reads top to bottom in order, so no sorting
+    rules_tab.treeview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(rules_tab.store));
+    g_object_unref(rules_tab.store);
+    for (int i = 0; i < 7; i++) {
+        GtkCellRenderer* renderer = gtk_cell_renderer_text_new();
+        GtkTreeViewColumn* column = gtk_tree_view_column_new_with_attributes(
+            headers7[i], renderer, "text", i, nullptr);
+        gtk_tree_view_column_set_resizable(column, TRUE);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(rules_tab.treeview), column);
+    }
+
+    gtk_container_add(GTK_CONTAINER(scrolled), rules_tab.treeview);
+    gtk_box_pack_start(GTK_BOX(rules_page), scrolled, TRUE, TRUE, 0);
+    gtk_widget_show_all(rules_page);
+}
+
+void TaskManager::refresh_rules_log() {
+    // Entries are rare, so the whole (bounded) log is reloaded when it grows
+    uint64_t generation = rules_engine.get_log_generation();
+    if (generation == rules_log_seen) return;
+    rules_log_seen = generation;
+
+    gtk_list_store_clear(rules_tab.store);
+    for (const RuleEvent& event : rules_engine.get_log()) {
+        time_t when = std::chrono::system_clock::to_time_t(event.when);
+        struct tm local;
+        localtime_r(&when, &local);
+        char time_text[32];
+        strftime(time_text, sizeof(time_text), "%H:%M:%S", &local);
+
+        GtkTreeIter iter;
+        gtk_list_store_insert_with_values(rules_tab.store, &iter, -1,
+            0, time_text,
+            1, event.rule.c_str(),
+            2, event.pid,
+            3, event.process.c_str(),
+            4, event.action.c_str(),
+            5, event.dry_run ? "Dry run" : event.ok ? "Done" : "Failed",
+            6, event.detail.c_str(),
+            -1);
+    }
+}
+
+void TaskManager::on_rules_dry_run_toggled(GtkToggleButton* button, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+    self->rules_engine.set_dry_run(gtk_toggle_button_get_active(button));
 }
 
 void TaskManager::setup_performance_tab() {
@@ -336,150 +902,446 @@ void TaskManager::setup_performance_tab() {
     gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(mem_drawing_area), FALSE, FALSE, 0);
     g_signal_connect(mem_drawing_area, "draw", G_CALLBACK(on_mem_draw), this);
 
-    mem_label = GTK_LABEL(gtk_label_new("Memory: 0 MB / 0 MB (0.0%)"));
-    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(mem_label), FALSE, FALSE, 0);
+    mem_label = GTK_LABEL(gtk_label_new("Memory: 0 MB / 0 MB (0.0%)"));
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(mem_label), FALSE, FALSE, 0);
+
+    mem_detail_label = GTK_LABEL(gtk_label_new(nullptr));
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(mem_detail_label), FALSE, FALSE, 0);
+
+    GtkWidget* net_title = gtk_label_new(nullptr);
+    gtk_label_set_markup(GTK_LABEL(net_title), "<b>Network I/O</b>");
+    gtk_box_pack_start(GTK_BOX(vbox), net_title, FALSE, FALSE, 0);
+
+    net_drawing_area = GTK_DRAWING_AREA(gtk_drawing_area_new());
+    gtk_widget_set_size_request(GTK_WIDGET(net_drawing_area), -1, 80);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(net_drawing_area), FALSE, FALSE, 0);
+    g_signal_connect(net_drawing_area, "draw", G_CALLBACK(on_net_draw), this);
+
+    net_label = GTK_LABEL(gtk_label_new("Network: 0 Mbps"));
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(net_label), FALSE, FALSE, 0);
+
+    interfaces_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(interfaces_box), 5);
+    gtk_box_pack_start(GTK_BOX(vbox), interfaces_box, FALSE, FALSE, 0);
+    for (auto& pair : interface_views) {
+        create_device_widgets(interfaces_box, pair.second);
+    }
+
+    GtkWidget* disk_title = gtk_label_new(nullptr);
+    gtk_label_set_markup(GTK_LABEL(disk_title), "<b>Disk I/O</b>");
+    gtk_box_pack_start(GTK_BOX(vbox), disk_title, FALSE, FALSE, 0);
+
+    disks_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_container_set_border_width(GTK_CONTAINER(disks_box), 5);
+    gtk_box_pack_start(GTK_BOX(vbox), disks_box, FALSE, FALSE, 0);
+    for (auto& pair : disk_views) {
+        create_device_widgets(disks_box, pair.second);
+    }
+
+    GtkWidget* gpu_title = gtk_label_new(nullptr);
+    gtk_label_set_markup(GTK_LABEL(gpu_title), "<b>GPU Usage</b>");
+    gtk_box_pack_start(GTK_BOX(vbox), gpu_title, FALSE, FALSE, 0);
+
+    gpu_drawing_area = GTK_DRAWING_AREA(gtk_drawing_area_new());
+    gtk_widget_set_size_request(GTK_WIDGET(gpu_drawing_area), -1, 80);
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(gpu_drawing_area), FALSE, FALSE, 0);
+    g_signal_connect(gpu_drawing_area, "draw", G_CALLBACK(on_gpu_draw), this);
+
+    gpu_label = GTK_LABEL(gtk_label_new("GPU: 0.0%"));
+    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(gpu_label), FALSE, FALSE, 0);
+
+    gtk_box_pack_start(GTK_BOX(vbox), gtk_label_new(nullptr), TRUE, TRUE, 0);
+
+    gtk_container_add(GTK_CONTAINER(scrolled), vbox);
+    gtk_box_pack_start(GTK_BOX(performance_page), scrolled, TRUE, TRUE, 0);
+    gtk_widget_show_all(performance_page);
+}
+
+GtkWidget* TaskManager::add_lazy_page(const char* title) {
+    GtkWidget* page = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), page, gtk_label_new(title));
+    return page;
+}
+
+void TaskManager::on_switch_page(GtkNotebook*, GtkWidget* page, guint, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+
+    // Collectors for a tab start with its first showing, and run right away
+    // rather than up to a full period later
+    if (page == self->services_page && !self->services_tab.treeview) {
+        self->setup_services_tab();
+        self->scheduler.set_enabled(self->services_collector, true);
+        self->scheduler.trigger(self->services_collector);
+    } else if (page == self->startup_page && !self->startup_tab.treeview) {
+        self->setup_startup_tab();
+        self->scheduler.set_enabled(self->startup_collector, true);
+        self->scheduler.trigger(self->startup_collector);
+    } else if (page == self->performance_page && !self->cpu_label) {
+        self->setup_performance_tab();
+        self->scheduler.trigger(self->system_collector);
+        self->scheduler.trigger(self->network_collector);
+        self->scheduler.trigger(self->disks_collector);
+    } else if (page == self->users_page && !self->users_tab.treeview) {
+        // Totals come with every process scan, so there is nothing to start
+        self->setup_users_tab();
+        if (self->latest_snapshot) self->refresh_users(*self->latest_snapshot);
+    } else if (page == self->rules_page && !self->rules_tab.treeview) {
+        self->setup_rules_tab();
+        self->refresh_rules_log();
+    } else if (page == self->connections_page && !self->connections_tab.treeview) {
+        self->setup_connections_tab();
+        self->scheduler.set_enabled(self->connections_collector, true);
+        self->scheduler.trigger(self->connections_collector);
+    }
+}
+
+// Milliseconds since this process was exec'd, from starttime in /proc/self/stat
+static double ms_since_exec() {
+    std::ifstream stat_file("/proc/self/stat");
+    std::string line;
+    std::getline(stat_file, line);
+
+    size_t paren_end = line.rfind(')');
+    if (paren_end == std::string::npos) return 0;
+
+    // starttime is field 22; fields after the comm start at field 3
+    std::istringstream iss(line.substr(paren_end + 2));
+    std::string field;
+    for (int i = 3; i < 22; i++) iss >> field;
+    unsigned long long start_ticks = 0;
+    iss >> start_ticks;
+
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    double now_ms = now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+    return now_ms - start_ticks * 1000.0 / sysconf(_SC_CLK_TCK);
+}
+
+gboolean TaskManager::on_first_paint(GtkWidget* widget, cairo_t*, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+    if (self->process_rows.empty()) return FALSE;
+
+    g_signal_handler_disconnect(widget, self->first_paint_handler);
+    self->first_paint_handler = 0;
+
+    double elapsed = ms_since_exec();
+    std::cerr << "Startup: first process row painted " << elapsed << " ms after exec" << std::endl;
+    g_idle_add([](gpointer) -> gboolean { gtk_main_quit(); return FALSE; }, nullptr);
+    return FALSE;
+}
+
+void TaskManager::collector_loop() {
+    TraceRecorder::set_thread_name("collector");
+
+    // Prime the CPU counters so the very first snapshot already has real CPU%
+    ProcParser::get_all_processes();
+    std::this_thread::sleep_for(std::chrono::milliseconds(PRIME_INTERVAL_MS));
+
+    while (running) {
+        uint32_t due = scheduler.wait_due();
+        if (!running) break;
+
+        if (!paused && due) {
+            auto snapshot = collect_snapshot(due);
+
+            TraceRecorder::Scope trace("publish");
+            last_published = snapshot;
+            snapshot_slot.publish(snapshot);
+            IpcServer::get_instance().publish_snapshot(snapshot);
+            ShmPublisher::get_instance().publish(*snapshot);
+
+            // The queued idle always takes the newest snapshot, so never queue a second one
+            if (!apply_pending.exchange(true)) {
+                g_idle_add(refresh_data, this);
+            }
+        }
+    }
+}
+
+std::shared_ptr<Snapshot> TaskManager::collect_snapshot(uint32_t due) {
+    Diagnostics::ScopedTimer timer(Diagnostics::TICK);
+
+    // Start from the previous snapshot, sharing its parts; only the due
+    // collectors replace theirs
+    auto snapshot = last_published ? std::make_shared<Snapshot>(*last_published)
+                                   : std::make_shared<Snapshot>();
+    snapshot->sequence = ++snapshot_sequence;
+    snapshot->taken = std::chrono::steady_clock::now();
+    snapshot->fresh = 0;
+
+    if (due & (1u << system_collector)) {
+        snapshot->stats = ProcParser::get_system_stats();
+        snapshot->vm = vm_stats.update(snapshot->taken);
+        snapshot->fresh |= Snapshot::SYSTEM;
+    }
+
+    if (due & (1u << processes_collector)) {
+        try {
+            // ProcParser::get_all_processes() handles CPU calculation internally
+            std::vector<ProcessInfo> processes = ProcParser::get_all_processes();
+
+            uint64_t total_mem = snapshot->stats.total_memory;
+            if (total_mem == 0) total_mem = 1; // Prevent division by zero
+
+            // Per-user totals ride along with the Mem% pass
+            std::vector<UserUsage> users;
+            std::unordered_map<uid_t, size_t> user_index;
+            for (auto& proc : processes) {
+                proc.memory_usage = (static_cast<double>(proc.memory_rss) / static_cast<double>(total_mem)) * 100.0;
+
+                auto found = user_index.find(proc.uid);
+                if (found == user_index.end()) {
+                    found = user_index.insert(std::make_pair(proc.uid, users.size())).first;
+                    users.push_back(UserUsage());
+                    users.back().uid = proc.uid;
+                    users.back().user = proc.user;
+                }
+                UserUsage& usage = users[found->second];
+                usage.processes++;
+                usage.threads += proc.thread_count;
+                usage.cpu_usage += proc.cpu_usage;
+                usage.memory_usage += proc.memory_usage;
+                usage.memory_rss += proc.memory_rss;
+            }
 
-    GtkWidget* net_title = gtk_label_new(nullptr);
-    gtk_label_set_markup(GTK_LABEL(net_title), "<b>Network I/O</b>");
-    gtk_box_pack_start(GTK_BOX(vbox), net_title, FALSE, FALSE, 0);
+            {
+                TraceRecorder::Scope trace("sockets");
+                socket_index.update(processes);
+                tcp_throughput.update(processes, socket_index, snapshot->taken);
+            }
+            snapshot->processes = std::make_shared<const std::vector<ProcessInfo>>(std::move(processes));
+            snapshot->users = std::make_shared<const std::vector<UserUsage>>(std::move(users));
+        } catch (const std::exception& e) {
+            std::cerr << "Error collecting processes: " << e.what() << std::endl;
+        }
+        process_history.record(*snapshot->processes, snapshot->taken);
+        snapshot->fresh |= Snapshot::PROCESSES;
+
+        // Always against the previous collected snapshot, whether or not the UI
+        // saw it; the UI notices sequence gaps itself
+        uint64_t delta_started = Diagnostics::now_ns();
+        compute_process_delta(last_published.get(), *snapshot);
+        Diagnostics::record(Diagnostics::DELTA, Diagnostics::now_ns() - delta_started);
+
+        if (rules_engine.rule_count()) {
+            TraceRecorder::Scope rules_trace("rules");
+            rules_engine.evaluate(*snapshot);
+        }
+    } else {
+        // Same rows as last time
+        snapshot->process_delta = ProcessDelta();
+        snapshot->process_delta.full = !last_published;
+    }
 
-    net_drawing_area = GTK_DRAWING_AREA(gtk_drawing_area_new());
-    gtk_widget_set_size_request(GTK_WIDGET(net_drawing_area), -1, 80);
-    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(net_drawing_area), FALSE, FALSE, 0);
-    g_signal_connect(net_drawing_area, "draw", G_CALLBACK(on_net_draw), this);
+    if (due & (1u << services_collector)) try {
+        Diagnostics::ScopedTimer services_timer(Diagnostics::SERVICES);
+        std::vector<ServiceInfo> services = SystemdManager::get_all_services();
+        SystemdManager::update_service_resources(services);
+        DEBUG_ACTION(std::cerr << "DEBUG: Found " << services.size() << " services" << std::endl);
+        snapshot->services = std::make_shared<const std::vector<ServiceInfo>>(std::move(services));
+        snapshot->fresh |= Snapshot::SERVICES;
+    } catch (const std::exception& e) {
+        std::cerr << "Error collecting services: " << e.what() << std::endl;
+    }
 
-    net_label = GTK_LABEL(gtk_label_new("Network: 0 Mbps"));
-    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(net_label), FALSE, FALSE, 0);
+    if (due & (1u << startup_collector)) try {
+        TraceRecorder::Scope trace("startup");
+        snapshot->startup = std::make_shared<const std::vector<StartupEntry>>(SystemdManager::get_startup_entries());
+        snapshot->startup_generation = SystemdManager::get_startup_generation();
+        snapshot->fresh |= Snapshot::STARTUP;
+    } catch (const std::exception& e) {
+        std::cerr << "Error collecting startup entries: " << e.what() << std::endl;
+    }
 
-    GtkWidget* gpu_title = gtk_label_new(nullptr);
-    gtk_label_set_markup(GTK_LABEL(gpu_title), "<b>GPU Usage</b>");
-    gtk_box_pack_start(GTK_BOX(vbox), gpu_title, FALSE, FALSE, 0);
+    if (due & (1u << connections_collector)) {
+        TraceRecorder::Scope trace("connections");
+        snapshot->connections = std::make_shared<const std::vector<ConnectionInfo>>(socket_index.get_connections());
+        snapshot->fresh |= Snapshot::CONNECTIONS;
+    }
 
-    gpu_drawing_area = GTK_DRAWING_AREA(gtk_drawing_area_new());
-    gtk_widget_set_size_request(GTK_WIDGET(gpu_drawing_area), -1, 80);
-    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(gpu_drawing_area), FALSE, FALSE, 0);
-    g_signal_connect(gpu_drawing_area, "draw", G_CALLBACK(on_gpu_draw), this);
+    if (due & (1u << network_collector)) {
+        TraceRecorder::Scope trace("network");
+        snapshot->interfaces = std::make_shared<const std::vector<InterfaceStats>>(link_stats.update(snapshot->taken));
 
-    gpu_label = GTK_LABEL(gtk_label_new("GPU: 0.0%"));
-    gtk_box_pack_start(GTK_BOX(vbox), GTK_WIDGET(gpu_label), FALSE, FALSE, 0);
+        double bytes_per_sec = 0;
+        for (const auto& iface : *snapshot->interfaces) {
+            if (!iface.loopback) bytes_per_sec += iface.rx_bytes_per_sec + iface.tx_bytes_per_sec;
+        }
+        snapshot->network_mbps = bytes_per_sec * 8.0 / 1000000.0;
+        snapshot->fresh |= Snapshot::NETWORK;
+    }
 
-    gtk_box_pack_start(GTK_BOX(vbox), gtk_label_new(nullptr), TRUE, TRUE, 0);
+    if (due & (1u << disks_collector)) {
+        TraceRecorder::Scope trace("disks");
+        snapshot->disks = std::make_shared<const std::vector<DiskDeviceStats>>(disk_stats.update(snapshot->taken));
+        snapshot->fresh |= Snapshot::DISKS;
+    }
 
-    gtk_container_add(GTK_CONTAINER(scrolled), vbox);
-    gtk_notebook_append_page(GTK_NOTEBOOK(notebook), scrolled, gtk_label_new("Performance"));
+    return snapshot;
 }
 
 gboolean TaskManager::refresh_data(gpointer data) {
     auto* self = static_cast<TaskManager*>(data);
-    self->refresh_processes();
-    self->refresh_services();
-    self->refresh_startup();
+    TraceRecorder::Scope trace("refresh_data");
+    self->apply_pending = false;
+
+    std::shared_ptr<const Snapshot> snapshot = self->snapshot_slot.take();
+    if (!snapshot) return FALSE;
+    self->latest_snapshot = snapshot;
+
+    // A sequence gap means snapshots were replaced in the slot unseen: their
+    // deltas and fresh parts are lost, so reconcile everything against this one
+    bool dropped = self->shown_sequence && snapshot->sequence != self->shown_sequence + 1;
+    self->shown_sequence = snapshot->sequence;
+    uint32_t fresh = dropped ? Snapshot::ALL_PARTS : snapshot->fresh;
+    if (dropped) self->app_groups.clear();
+
+    {
+        Diagnostics::ScopedTimer timer(Diagnostics::MODEL);
+        self->refresh_processes(*snapshot, dropped);
+        if (self->apps_mode && (fresh & Snapshot::PROCESSES)) self->refresh_apps(*snapshot);
+        if (self->users_tab.store && (fresh & Snapshot::PROCESSES)) self->refresh_users(*snapshot);
+        if (self->rules_tab.store) self->refresh_rules_log();
+        if (fresh & Snapshot::PROCESSES) self->refresh_process_details();
+        if (self->services_tab.store && (fresh & Snapshot::SERVICES)) {
+            self->refresh_services(*snapshot);
+        }
+        if (self->startup_tab.store) self->refresh_startup(*snapshot);
+        if (self->connections_tab.store && (fresh & Snapshot::CONNECTIONS)) {
+            self->refresh_connections(*snapshot);
+        }
+    }
+    self->refresh_diagnostics();
 
-    static int perf_counter = 0;
-    if (perf_counter++ % 2 == 0) {
-        self->refresh_performance();
+    if (fresh & Snapshot::SYSTEM) {
+        self->refresh_performance(*snapshot);
+    }
+    if (fresh & Snapshot::NETWORK) {
+        self->refresh_network(*snapshot);
+    }
+    if (fresh & Snapshot::DISKS) {
+        self->refresh_disks(*snapshot);
     }
     return FALSE;
 }
 
-void TaskManager::refresh_processes() {
-    try {
-        // ProcParser::get_all_processes() now handles CPU calculation internally
-        auto new_procs = ProcParser::get_all_processes();
-
-        SystemStats stats = ProcParser::get_system_stats();
+void TaskManager::refresh_processes(const Snapshot& snapshot, bool reconcile) {
+    const ProcessDelta& delta = snapshot.process_delta;
+    throttle.reap();
 
-        // Calculate memory percentage for each process
-        uint64_t total_mem = stats.total_memory;
-        if (total_mem == 0) total_mem = 1; // Prevent division by zero
-
-        for (auto& proc : new_procs) {
-            // CPU usage is already calculated by ProcParser
-            // Just calculate memory percentage here
-            proc.memory_usage = (static_cast<double>(proc.memory_rss) / static_cast<double>(total_mem)) * 100.0;
+    if (delta.full || reconcile) {
+        std::set<pid_t> live_pids;
+        for (const auto& proc : *snapshot.processes) {
+            live_pids.insert(proc.pid);
         }
 
-        processes_tab.processes = std::move(new_procs);
+        for (auto it = process_rows.begin(); it != process_rows.end(); ) {
+            if (!live_pids.count(it->first)) {
+                gtk_list_store_remove(processes_tab.store, &it->second);
+                it = process_rows.erase(it);
+            } else {
+                ++it;
+            }
+        }
 
-        // Build map of old PIDs
-        std::map<pid_t, GtkTreeIter> old_pids;
-        GtkTreeIter iter;
-        if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(processes_tab.store), &iter)) {
-            do {
-                gint pid;
-                gtk_tree_model_get(GTK_TREE_MODEL(processes_tab.store), &iter, 0, &pid, -1);
-                old_pids[pid] = iter;
-            } while (gtk_tree_model_iter_next(GTK_TREE_MODEL(processes_tab.store), &iter));
+        for (const auto& proc : *snapshot.processes) {
+            set_process_row(proc);
         }
+        return;
+    }
 
-        // Build set of new PIDs
-        std::set<pid_t> new_pids;
-        for (const auto& proc : processes_tab.processes) {
-            new_pids.insert(proc.pid);
+    for (pid_t pid : delta.removed) {
+        auto it = process_rows.find(pid);
+        if (it != process_rows.end()) {
+            gtk_list_store_remove(processes_tab.store, &it->second);
+            process_rows.erase(it);
         }
+    }
 
-        // Remove dead processes
-        for (auto it = old_pids.begin(); it != old_pids.end(); ) {
-            if (new_pids.find(it->first) == new_pids.end()) {
-                gtk_list_store_remove(processes_tab.store, &it->second);
-                it = old_pids.erase(it);
+    for (size_t index : delta.updated) {
+        set_process_row((*snapshot.processes)[index]);
+    }
+}
+
+void TaskManager::set_process_row(const ProcessInfo& proc) {
+    auto it = process_rows.find(proc.pid);
+    if (it == process_rows.end()) {
+        GtkTreeIter new_iter;
+        gtk_list_store_append(processes_tab.store, &new_iter);
+        it = process_rows.insert(std::make_pair(proc.pid, new_iter)).first;
+    }
+
+    gtk_list_store_set(processes_tab.store, &it->second,
+        0, proc.pid,
+        1, proc.name.c_str(),
+        2, proc.cpu_usage,
+        3, proc.memory_usage,
+        4, proc.memory_rss / (1024 * 1024),
+        5, proc.thread_count,
+        6, proc.user.c_str(),
+        7, proc.state.c_str(),
+        8, proc.socket_count,
+        9, proc.net_send_rate / 1024.0,
+        10, proc.net_recv_rate / 1024.0,
+        11, throttle.describe(proc.cgroup).c_str(),
+        12, static_cast<guint>(proc.uid),
+        -1);
+}
+
+void TaskManager::refresh_apps(const Snapshot& snapshot) {
+    bool rebuilt = app_groups.apply(snapshot);
+    const auto& groups = app_groups.get_groups();
+
+    if (rebuilt) {
+        for (auto it = app_rows.begin(); it != app_rows.end(); ) {
+            if (!groups.count(it->first)) {
+                gtk_list_store_remove(apps_tab.store, &it->second);
+                it = app_rows.erase(it);
             } else {
                 ++it;
             }
         }
+    }
 
-        // Create map of new procs by PID for O(1) lookup
-        std::map<pid_t, const ProcessInfo*> new_proc_map;
-        for (const auto& proc : processes_tab.processes) {
-            new_proc_map[proc.pid] = &proc;
+    auto set_row = [&](const std::string& key, const AppGroup& group) {
+        auto row = app_rows.find(key);
+        if (row == app_rows.end()) {
+            GtkTreeIter new_iter;
+            gtk_list_store_append(apps_tab.store, &new_iter);
+            row = app_rows.insert(std::make_pair(key, new_iter)).first;
         }
+        gtk_list_store_set(apps_tab.store, &row->second,
+            0, group.name.c_str(),
+            1, group.processes,
+            2, group.cpu_usage,
+            3, group.memory_usage,
+            4, group.memory_rss / (1024 * 1024),
+            5, group.thread_count,
+            -1);
+    };
+
+    if (rebuilt) {
+        for (const auto& pair : groups) set_row(pair.first, pair.second);
+        return;
+    }
 
-        // Update existing processes
-        for (auto& pair : old_pids) {
-            pid_t pid = pair.first;
-            if (new_proc_map.count(pid)) {
-                const ProcessInfo* proc = new_proc_map[pid];
-                gtk_list_store_set(processes_tab.store, &pair.second,
-                    0, proc->pid,
-                    1, proc->name.c_str(),
-                    2, proc->cpu_usage,
-                    3, proc->memory_usage,
-                    4, proc->memory_rss / (1024 * 1024),
-                    5, proc->thread_count,
-                    6, proc->user.c_str(),
-                    7, proc->state.c_str(),
-                    -1);
-            }
+    for (const std::string& key : app_groups.get_changed()) {
+        auto group = groups.find(key);
+        if (group != groups.end()) {
+            set_row(key, group->second);
+            continue;
         }
-
-        // Add new processes
-        for (const auto& proc : processes_tab.processes) {
-            if (!old_pids.count(proc.pid)) {
-                GtkTreeIter new_iter;
-                gtk_list_store_append(processes_tab.store, &new_iter);
-                gtk_list_store_set(processes_tab.store, &new_iter,
-                    0, proc.pid,
-                    1, proc.name.c_str(),
-                    2, proc.cpu_usage,
-                    3, proc.memory_usage,
-                    4, proc.memory_rss / (1024 * 1024),
-                    5, proc.thread_count,
-                    6, proc.user.c_str(),
-                    7, proc.state.c_str(),
-                    -1);
-            }
+        auto row = app_rows.find(key);
+        if (row != app_rows.end()) {
+            gtk_list_store_remove(apps_tab.store, &row->second);
+            app_rows.erase(row);
         }
-
-    } catch (const std::exception& e) {
-        std::cerr << "Error refreshing processes: " << e.what() << std::endl;
     }
 }
 
-void TaskManager::refresh_services() const {
+void TaskManager::refresh_services(const Snapshot& snapshot) const {
     try {
-        auto new_services = SystemdManager::get_all_services();
-
-        DEBUG_ACTION(std::cerr << "DEBUG: Found " << new_services.size() << " services" << std::endl);
+        const auto& new_services = *snapshot.services;
 
         std::map<std::string, GtkTreeIter> old_services;
         GtkTreeIter iter;
@@ -517,6 +1379,10 @@ void TaskManager::refresh_services() const {
                     2, svc.state.c_str(),
                     3, svc.active.c_str(),
                     4, static_cast<gint>(svc.main_pid),
+                    5, svc.cpu_usage,
+                    6, static_cast<guint64>(svc.memory_current / (1024 * 1024)),
+                    7, svc.tasks_current,
+                    8, svc.io_rate / 1024.0,
                     -1);
             } else {
                 GtkTreeIter new_iter;
@@ -527,6 +1393,10 @@ void TaskManager::refresh_services() const {
                     2, svc.state.c_str(),
                     3, svc.active.c_str(),
                     4, static_cast<gint>(svc.main_pid),
+                    5, svc.cpu_usage,
+                    6, static_cast<guint64>(svc.memory_current / (1024 * 1024)),
+                    7, svc.tasks_current,
+                    8, svc.io_rate / 1024.0,
                     -1);
             }
         }
@@ -535,9 +1405,13 @@ void TaskManager::refresh_services() const {
     }
 }
 
-void TaskManager::refresh_startup() const {
+void TaskManager::refresh_startup(const Snapshot& snapshot) {
+    // Entries only change on inotify events; skip the store walk otherwise
+    if (snapshot.startup_generation == startup_generation_seen) return;
+    startup_generation_seen = snapshot.startup_generation;
+
     try {
-        auto new_startups = SystemdManager::get_startup_entries();
+        const auto& new_startups = *snapshot.startup;
 
         std::map<std::string, GtkTreeIter> old_startups;
         GtkTreeIter iter;
@@ -574,6 +1448,7 @@ void TaskManager::refresh_startup() const {
                     1, entry.enabled,
                     2, entry.source.c_str(),
                     3, entry.path.c_str(),
+                    4, entry.exec.c_str(),
                     -1);
             } else {
                 GtkTreeIter new_iter;
@@ -583,6 +1458,7 @@ void TaskManager::refresh_startup() const {
                     1, entry.enabled,
                     2, entry.source.c_str(),
                     3, entry.path.c_str(),
+                    4, entry.exec.c_str(),
                     -1);
             }
         }
@@ -591,52 +1467,109 @@ void TaskManager::refresh_startup() const {
     }
 }
 
-void TaskManager::refresh_performance() {
-    SystemStats stats = ProcParser::get_system_stats();
+void TaskManager::refresh_connections(const Snapshot& snapshot) {
+    connections_refresh++;
 
-    perf_data.current_cpu = stats.total_cpu_usage;
-    uint64_t used_mem = stats.total_memory - stats.available_memory;
-    perf_data.current_mem = (used_mem * 100.0) / stats.total_memory;
+    std::unordered_map<pid_t, const std::string*> names;
+    names.reserve(snapshot.processes->size());
+    for (const auto& proc : *snapshot.processes) {
+        names[proc.pid] = &proc.name;
+    }
 
-    // Calculate network usage
-    auto now = std::chrono::steady_clock::now();
-    double time_diff = std::chrono::duration_cast<std::chrono::duration<double>>(now - last_network_time).count();
+    // Rows are only touched when their state or owner changed, so a host
+    // with 100k idle sockets costs a map lookup per socket, not a row update
+    std::string key;
+    for (const auto& connection : *snapshot.connections) {
+        key = connection.protocol;
+        key += '|';
+        key += connection.local;
+        key += '|';
+        key += connection.remote;
+        key += '|';
+        key += std::to_string(connection.inode);
+
+        auto it = connection_rows.find(key);
+        bool added = it == connection_rows.end();
+        if (added) {
+            ConnectionRow row;
+            gtk_list_store_append(connections_tab.store, &row.iter);
+            row.pid = 0;
+            it = connection_rows.insert(std::make_pair(key, row)).first;
+            gtk_list_store_set(connections_tab.store, &it->second.iter,
+                0, connection.protocol.c_str(),
+                1, connection.local.c_str(),
+                2, connection.remote.c_str(),
+                -1);
+        }
 
-    if (time_diff > 0.1) {  // Only calculate if enough time has passed
-        NetworkStats current_net = get_network_stats();
+        ConnectionRow& row = it->second;
+        row.seen = connections_refresh;
+        if (!added && row.state == connection.state && row.pid == connection.pid) continue;
+
+        auto name = names.find(connection.pid);
+        row.state = connection.state;
+        row.pid = connection.pid;
+        gtk_list_store_set(connections_tab.store, &row.iter,
+            3, connection.state.c_str(),
+            4, connection.pid,
+            5, name != names.end() ? name->second->c_str() : "",
+            -1);
+    }
 
-        uint64_t bytes_diff = (current_net.bytes_recv + current_net.bytes_sent) -
-                              (last_network_stats.bytes_recv + last_network_stats.bytes_sent);
+    for (auto it = connection_rows.begin(); it != connection_rows.end(); ) {
+        if (it->second.seen != connections_refresh) {
+            gtk_list_store_remove(connections_tab.store, &it->second.iter);
+            it = connection_rows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
 
-        // Convert to Mbps
-        perf_data.current_net = (bytes_diff * 8.0) / (time_diff * 1000000.0);
+// Memory chart layers, bottom to top; the legend uses the same colours
+static const double MEM_LAYER_RGB[PerformanceData::MEM_LAYERS][3] = {
+    {0.2, 0.6, 1.0},    // Anonymous
+    {0.7, 0.4, 1.0},    // Shared
+    {0.3, 0.8, 0.5},    // File cache
+    {1.0, 0.8, 0.2},    // Slab
+    {1.0, 0.5, 0.2},    // Page tables
+    {1.0, 0.3, 0.3},    // Swap
+};
+static const char* const MEM_LAYER_MARKUP[PerformanceData::MEM_LAYERS] = {
+    "#3399ff", "#b366ff", "#4dcc80", "#ffcc33", "#ff8033", "#ff4d4d"
+};
+
+void TaskManager::refresh_performance(const Snapshot& snapshot) {
+    const SystemStats& stats = snapshot.stats;
 
-        last_network_stats = current_net;
-        last_network_time = now;
-    }
+    perf_data.current_cpu = stats.total_cpu_usage;
+    uint64_t used_mem = stats.total_memory - stats.available_memory;
+    perf_data.current_mem = stats.total_memory ? (used_mem * 100.0) / stats.total_memory : 0.0;
 
     // GPU is placeholder for now - could be expanded with nvidia-smi or similar
     perf_data.current_gpu = 0.0;
 
-    if (perf_data.cpu_history.size() >= perf_data.max_history) {
-        perf_data.cpu_history.erase(perf_data.cpu_history.begin());
-    }
-    perf_data.cpu_history.push_back(stats.total_cpu_usage);
-
-    if (perf_data.mem_history.size() >= perf_data.max_history) {
-        perf_data.mem_history.erase(perf_data.mem_history.begin());
-    }
-    perf_data.mem_history.push_back(perf_data.current_mem);
-
-    if (perf_data.net_history.size() >= perf_data.max_history) {
-        perf_data.net_history.erase(perf_data.net_history.begin());
+    perf_data.push_sample(perf_data.cpu_history, stats.total_cpu_usage);
+
+    // Layers are shares of RAM + swap, so swap in use stacks above the RAM line
+    const MemoryComposition& memory = stats.memory;
+    double chart_total = static_cast<double>(stats.total_memory + memory.swap_total);
+    double layer_bytes[PerformanceData::MEM_LAYERS] = {};
+    layer_bytes[PerformanceData::MEM_ANON] = static_cast<double>(memory.anon);
+    layer_bytes[PerformanceData::MEM_SHMEM] = static_cast<double>(memory.shmem);
+    layer_bytes[PerformanceData::MEM_FILE] = static_cast<double>(memory.file);
+    layer_bytes[PerformanceData::MEM_SLAB] = static_cast<double>(memory.slab);
+    layer_bytes[PerformanceData::MEM_PAGE_TABLES] = static_cast<double>(memory.page_tables);
+    layer_bytes[PerformanceData::MEM_SWAP] = static_cast<double>(memory.swap_used);
+    for (int layer = 0; layer < PerformanceData::MEM_LAYERS; layer++) {
+        perf_data.push_sample(perf_data.mem_layer_history[layer],
+                              chart_total > 0 ? layer_bytes[layer] * 100.0 / chart_total : 0.0);
     }
-    perf_data.net_history.push_back(perf_data.current_net);
+    perf_data.mem_ram_share = chart_total > 0 ? stats.total_memory * 100.0 / chart_total : 100.0;
+    perf_data.push_sample(perf_data.gpu_history, perf_data.current_gpu);
 
-    if (perf_data.gpu_history.size() >= perf_data.max_history) {
-        perf_data.gpu_history.erase(perf_data.gpu_history.begin());
-    }
-    perf_data.gpu_history.push_back(perf_data.current_gpu);
+    // History keeps accumulating before the Performance tab is first opened
+    if (!cpu_label) return;
 
     gchar* cpu_text = g_strdup_printf("CPU: %.1f%%", perf_data.current_cpu);
     gtk_label_set_text(cpu_label, cpu_text);
@@ -649,9 +1582,27 @@ void TaskManager::refresh_performance() {
     gtk_label_set_text(mem_label, mem_text);
     g_free(mem_text);
 
-    gchar* net_text = g_strdup_printf("Network: %.1f Mbps", perf_data.current_net);
-    gtk_label_set_text(net_label, net_text);
-    g_free(net_text);
+    const double mb = 1024.0 * 1024.0;
+    gchar* detail = g_strdup_printf(
+        "<span foreground=\"%s\">\u25a0</span> Anonymous %.0f MB   "
+        "<span foreground=\"%s\">\u25a0</span> Shared %.0f MB   "
+        "<span foreground=\"%s\">\u25a0</span> File cache %.0f MB   "
+        "<span foreground=\"%s\">\u25a0</span> Slab %.0f MB   "
+        "<span foreground=\"%s\">\u25a0</span> Page tables %.0f MB   "
+        "<span foreground=\"%s\">\u25a0</span> Swap %.0f / %.0f MB   Free %.0f MB\n"
+        "Page faults %.0f/s (major %.0f/s)   Swap in %.0f / out %.0f pages/s   "
+        "Reclaim scanned %.0f / reclaimed %.0f pages/s",
+        MEM_LAYER_MARKUP[PerformanceData::MEM_ANON], memory.anon / mb,
+        MEM_LAYER_MARKUP[PerformanceData::MEM_SHMEM], memory.shmem / mb,
+        MEM_LAYER_MARKUP[PerformanceData::MEM_FILE], memory.file / mb,
+        MEM_LAYER_MARKUP[PerformanceData::MEM_SLAB], memory.slab / mb,
+        MEM_LAYER_MARKUP[PerformanceData::MEM_PAGE_TABLES], memory.page_tables / mb,
+        MEM_LAYER_MARKUP[PerformanceData::MEM_SWAP], memory.swap_used / mb, memory.swap_total / mb,
+        memory.free / mb,
+        snapshot.vm.page_faults, snapshot.vm.major_faults, snapshot.vm.swap_in, snapshot.vm.swap_out,
+        snapshot.vm.scanned, snapshot.vm.reclaimed);
+    gtk_label_set_markup(mem_detail_label, detail);
+    g_free(detail);
 
     gchar* gpu_text = g_strdup_printf("GPU: %.1f%%", perf_data.current_gpu);
     gtk_label_set_text(gpu_label, gpu_text);
@@ -659,17 +1610,159 @@ void TaskManager::refresh_performance() {
 
     if (cpu_drawing_area) gtk_widget_queue_draw(GTK_WIDGET(cpu_drawing_area));
     if (mem_drawing_area) gtk_widget_queue_draw(GTK_WIDGET(mem_drawing_area));
-    if (net_drawing_area) gtk_widget_queue_draw(GTK_WIDGET(net_drawing_area));
     if (gpu_drawing_area) gtk_widget_queue_draw(GTK_WIDGET(gpu_drawing_area));
 }
 
-static inline void draw_graph(GtkWidget* widget, cairo_t* cr, const std::vector<double>& history,
-                               double max_val, double r, double g, double b) {
-    GtkAllocation alloc;
-    gtk_widget_get_allocation(widget, &alloc);
+void TaskManager::refresh_network(const Snapshot& snapshot) {
+    perf_data.current_net = snapshot.network_mbps;
+    perf_data.push_sample(perf_data.net_history, perf_data.current_net);
+
+    // The total graph scales to the combined link speed when every link
+    // reports one, and to its own peak otherwise
+    std::set<int> present;
+    uint64_t total_speed = 0;
+    bool speeds_known = true;
+    for (const auto& iface : *snapshot.interfaces) {
+        if (iface.loopback) continue;
+        present.insert(iface.index);
+
+        DeviceView& view = interface_views[iface.index];
+        view.name = iface.name;
+        view.graph_max = static_cast<double>(iface.speed_mbps);
+        perf_data.push_sample(view.first_history, iface.rx_bytes_per_sec * 8.0 / 1000000.0);
+        perf_data.push_sample(view.second_history, iface.tx_bytes_per_sec * 8.0 / 1000000.0);
+
+        if (iface.up) {
+            total_speed += iface.speed_mbps;
+            if (!iface.speed_mbps) speeds_known = false;
+        }
 
-    if (alloc.width <= 1 || alloc.height <= 1) return;
+        if (!interfaces_box) continue;
+        if (!view.box) create_device_widgets(interfaces_box, view);
+
+        gchar* title = g_markup_printf_escaped(iface.speed_mbps ? "<b>%s</b>  %s, %llu Mbps" : "<b>%s</b>  %s",
+            iface.name.c_str(), iface.up ? "up" : "down",
+            static_cast<unsigned long long>(iface.speed_mbps));
+        gtk_label_set_markup(view.title, title);
+        g_free(title);
+
+        gchar* text = g_strdup_printf(
+            "Receive %.1f Mbps   Send %.1f Mbps   Packets %.0f / %.0f per sec   Errors %llu / %llu   Drops %llu / %llu",
+            view.first_history.back(), view.second_history.back(),
+            iface.rx_packets_per_sec, iface.tx_packets_per_sec,
+            static_cast<unsigned long long>(iface.rx_errors), static_cast<unsigned long long>(iface.tx_errors),
+            static_cast<unsigned long long>(iface.rx_dropped), static_cast<unsigned long long>(iface.tx_dropped));
+        gtk_label_set_text(view.label, text);
+        g_free(text);
+        gtk_widget_queue_draw(view.area);
+    }
+
+    for (auto it = interface_views.begin(); it != interface_views.end(); ) {
+        if (!present.count(it->first)) {
+            if (it->second.box) gtk_widget_destroy(it->second.box);
+            it = interface_views.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    double peak = *std::max_element(perf_data.net_history.begin(), perf_data.net_history.end());
+    net_graph_max = (speeds_known && total_speed) ? static_cast<double>(total_speed) : std::max(peak * 1.2, 1.0);
+
+    if (!net_label) return;
+
+    gchar* net_text = g_strdup_printf("Network: %.1f Mbps", perf_data.current_net);
+    gtk_label_set_text(net_label, net_text);
+    g_free(net_text);
+    if (net_drawing_area) gtk_widget_queue_draw(GTK_WIDGET(net_drawing_area));
+}
+
+void TaskManager::refresh_disks(const Snapshot& snapshot) {
+    std::set<std::string> present;
+    for (const auto& disk : *snapshot.disks) {
+        present.insert(disk.name);
+
+        DeviceView& view = disk_views[disk.name];
+        view.name = disk.name;
+        perf_data.push_sample(view.first_history, disk.read_bytes_per_sec / (1024.0 * 1024.0));
+        perf_data.push_sample(view.second_history, disk.write_bytes_per_sec / (1024.0 * 1024.0));
+
+        if (!disks_box) continue;
+        if (!view.box) {
+            create_device_widgets(disks_box, view);
+            gchar* title = g_markup_printf_escaped("<b>%s</b>", disk.name.c_str());
+            gtk_label_set_markup(view.title, title);
+            g_free(title);
+        }
+
+        gchar* text = g_strdup_printf(
+            "Read %.1f MB/s   Write %.1f MB/s   IOPS %.0f / %.0f   Await %.1f ms   Utilization %.0f%%",
+            view.first_history.back(), view.second_history.back(),
+            disk.read_iops, disk.write_iops, disk.await_ms, disk.utilization);
+        gtk_label_set_text(view.label, text);
+        g_free(text);
+        gtk_widget_queue_draw(view.area);
+    }
+
+    for (auto it = disk_views.begin(); it != disk_views.end(); ) {
+        if (!present.count(it->first)) {
+            if (it->second.box) gtk_widget_destroy(it->second.box);
+            it = disk_views.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TaskManager::create_device_widgets(GtkWidget* container, DeviceView& view) {
+    view.box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    view.title = GTK_LABEL(gtk_label_new(nullptr));
+    gtk_widget_set_halign(GTK_WIDGET(view.title), GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(view.box), GTK_WIDGET(view.title), FALSE, FALSE, 0);
+
+    // Map nodes never move, so the view itself can be the callback data;
+    // the widgets are destroyed before the view is erased
+    view.area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(view.area, -1, 60);
+    g_signal_connect(view.area, "draw", G_CALLBACK(on_device_draw), &view);
+    gtk_box_pack_start(GTK_BOX(view.box), view.area, FALSE, FALSE, 0);
+
+    view.label = GTK_LABEL(gtk_label_new(nullptr));
+    gtk_widget_set_halign(GTK_WIDGET(view.label), GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(view.box), GTK_WIDGET(view.label), FALSE, FALSE, 0);
+
+    gtk_box_pack_start(GTK_BOX(container), view.box, FALSE, FALSE, 0);
+    gtk_widget_show_all(view.box);
+}
 
+static void draw_history_line(cairo_t* cr, const GtkAllocation& alloc, const std::vector<double>& history,
+                              double max_val, double r, double g, double b) {
+    if (history.size() < 2) return;
+
+    cairo_set_source_rgb(cr, r, g, b);
+    cairo_set_line_width(cr, 2.0);
+    cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+    cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+
+    double x_step = static_cast<double>(alloc.width) / (history.size() - 1);
+
+    for (size_t i = 0; i < history.size(); i++) {
+        double x = i * x_step;
+        double val = history[i];
+        if (val > max_val) val = max_val;
+        double y = alloc.height - (val / max_val * alloc.height);
+
+        if (i == 0) {
+            cairo_move_to(cr, x, y);
+        } else {
+            cairo_line_to(cr, x, y);
+        }
+    }
+    cairo_stroke(cr);
+}
+
+static void draw_graph_background(cairo_t* cr, const GtkAllocation& alloc) {
     cairo_set_source_rgb(cr, 0.15, 0.15, 0.15);
     cairo_rectangle(cr, 0, 0, alloc.width, alloc.height);
     cairo_fill(cr);
@@ -682,56 +1775,217 @@ static inline void draw_graph(GtkWidget* widget, cairo_t* cr, const std::vector<
         cairo_line_to(cr, alloc.width, y);
     }
     cairo_stroke(cr);
+}
 
-    if (history.size() > 1) {
-        cairo_set_source_rgb(cr, r, g, b);
-        cairo_set_line_width(cr, 2.0);
-        cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
-        cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
-
-        double x_step = static_cast<double>(alloc.width) / (history.size() - 1);
+static inline void draw_graph(const char* trace_name, GtkWidget* widget, cairo_t* cr,
+                              const std::vector<double>& history,
+                              double max_val, double r, double g, double b,
+                              const std::vector<double>* second = nullptr) {
+    TraceRecorder::Scope trace(trace_name);
+    Diagnostics::ScopedTimer timer(Diagnostics::DRAW);
+    GtkAllocation alloc;
+    gtk_widget_get_allocation(widget, &alloc);
 
-        for (size_t i = 0; i < history.size(); i++) {
-            double x = i * x_step;
-            double val = history[i];
-            if (val > max_val) val = max_val;
-            double y = alloc.height - (val / max_val * alloc.height);
+    if (alloc.width <= 1 || alloc.height <= 1) return;
 
-            if (i == 0) {
-                cairo_move_to(cr, x, y);
-            } else {
-                cairo_line_to(cr, x, y);
-            }
-        }
-        cairo_stroke(cr);
-    }
+    draw_graph_background(cr, alloc);
+    draw_history_line(cr, alloc, history, max_val, r, g, b);
+    // An optional second series (e.g. send against receive) in a fixed contrasting colour
+    if (second) draw_history_line(cr, alloc, *second, max_val, 1.0, 0.4, 0.4);
 }
 
 gboolean TaskManager::on_perf_draw(GtkWidget* widget, cairo_t* cr, gpointer data) {
     auto* self = static_cast<TaskManager*>(data);
-    draw_graph(widget, cr, self->perf_data.cpu_history, 100.0, 0.0, 1.0, 0.0);
+    draw_graph("draw_graph:cpu", widget, cr, self->perf_data.cpu_history, 100.0, 0.0, 1.0, 0.0);
     return FALSE;
 }
 
 gboolean TaskManager::on_mem_draw(GtkWidget* widget, cairo_t* cr, gpointer data) {
     auto* self = static_cast<TaskManager*>(data);
-    draw_graph(widget, cr, self->perf_data.mem_history, 100.0, 0.2, 0.8, 1.0);
+    const PerformanceData& perf = self->perf_data;
+    TraceRecorder::Scope trace("draw_graph:mem");
+    Diagnostics::ScopedTimer timer(Diagnostics::DRAW);
+    GtkAllocation alloc;
+    gtk_widget_get_allocation(widget, &alloc);
+    if (alloc.width <= 1 || alloc.height <= 1) return FALSE;
+
+    draw_graph_background(cr, alloc);
+    size_t samples = perf.mem_layer_history[0].size();
+    if (samples < 2) return FALSE;
+
+    double x_step = static_cast<double>(alloc.width) / (samples - 1);
+    auto y_at = [&](double percent) {
+        return alloc.height - std::min(percent, 100.0) / 100.0 * alloc.height;
+    };
+
+    // Each layer is filled between its top edge and the one below it
+    std::vector<double> base(samples, 0.0);
+    for (int layer = 0; layer < PerformanceData::MEM_LAYERS; layer++) {
+        const std::vector<double>& history = perf.mem_layer_history[layer];
+        if (history.size() != samples) continue;
+        if (layer == PerformanceData::MEM_SWAP) std::fill(base.begin(), base.end(), perf.mem_ram_share);
+
+        cairo_move_to(cr, 0, y_at(base[0] + history[0]));
+        for (size_t i = 1; i < samples; i++) cairo_line_to(cr, i * x_step, y_at(base[i] + history[i]));
+        for (size_t i = samples; i-- > 0; ) cairo_line_to(cr, i * x_step, y_at(base[i]));
+        cairo_close_path(cr);
+        cairo_set_source_rgba(cr, MEM_LAYER_RGB[layer][0], MEM_LAYER_RGB[layer][1], MEM_LAYER_RGB[layer][2], 0.8);
+        cairo_fill(cr);
+
+        for (size_t i = 0; i < samples; i++) base[i] += history[i];
+    }
+
+    // Where RAM ends, when there is swap above it
+    if (perf.mem_ram_share < 100.0) {
+        double dash = 4.0;
+        cairo_set_source_rgb(cr, 0.8, 0.8, 0.8);
+        cairo_set_line_width(cr, 1.0);
+        cairo_set_dash(cr, &dash, 1, 0);
+        cairo_move_to(cr, 0, y_at(perf.mem_ram_share));
+        cairo_line_to(cr, alloc.width, y_at(perf.mem_ram_share));
+        cairo_stroke(cr);
+        cairo_set_dash(cr, nullptr, 0, 0);
+    }
     return FALSE;
 }
 
 gboolean TaskManager::on_net_draw(GtkWidget* widget, cairo_t* cr, gpointer data) {
     auto* self = static_cast<TaskManager*>(data);
-    draw_graph(widget, cr, self->perf_data.net_history, MAX_NET, 1.0, 1.0, 0.0);
+    draw_graph("draw_graph:net", widget, cr, self->perf_data.net_history, self->net_graph_max, 1.0, 1.0, 0.0);
+    return FALSE;
+}
+
+// Receive/read in green, send/write in red, against the link speed when the
+// driver reports one and the recent peak otherwise
+gboolean TaskManager::on_device_draw(GtkWidget* widget, cairo_t* cr, gpointer data) {
+    const auto* view = static_cast<const DeviceView*>(data);
+
+    double max_val = view->graph_max;
+    if (!max_val) {
+        double peak = 0;
+        for (double value : view->first_history) peak = std::max(peak, value);
+        for (double value : view->second_history) peak = std::max(peak, value);
+        max_val = std::max(peak * 1.2, 1.0);
+    }
+    draw_graph("draw_graph:device", widget, cr, view->first_history, max_val, 0.0, 1.0, 0.0, &view->second_history);
     return FALSE;
 }
 
 gboolean TaskManager::on_gpu_draw(GtkWidget* widget, cairo_t* cr, gpointer data) {
     auto* self = static_cast<TaskManager*>(data);
-    draw_graph(widget, cr, self->perf_data.gpu_history, 100.0, 1.0, 0.5, 0.0);
+    draw_graph("draw_graph:gpu", widget, cr, self->perf_data.gpu_history, 100.0, 1.0, 0.5, 0.0);
+    return FALSE;
+}
+
+// Ctrl+Shift+D reveals the Diagnostics tab, which is not listed otherwise
+gboolean TaskManager::on_key_press(GtkWidget*, GdkEventKey* event, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+    guint modifiers = event->state & gtk_accelerator_get_default_mod_mask();
+
+    if (modifiers == (GDK_CONTROL_MASK | GDK_SHIFT_MASK) &&
+        gdk_keyval_to_lower(event->keyval) == GDK_KEY_d) {
+        self->show_diagnostics_tab();
+        return TRUE;
+    }
+    return FALSE;
+}
+
+void TaskManager::show_diagnostics_tab() {
+    if (!diagnostics_view) {
+        GtkWidget* vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+        gtk_container_set_border_width(GTK_CONTAINER(vbox), 10);
+
+        GtkWidget* buttons = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+        GtkWidget* reset_btn = gtk_button_new_with_label("Reset");
+        GtkWidget* dump_btn = gtk_button_new_with_label("Dump to stderr");
+        GtkWidget* trace_btn = gtk_toggle_button_new_with_label("Record trace");
+        GtkWidget* save_trace_btn = gtk_button_new_with_label("Save trace");
+        gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(trace_btn), TraceRecorder::is_enabled());
+        gtk_box_pack_start(GTK_BOX(buttons), reset_btn, FALSE, FALSE, 0);
+        gtk_box_pack_start(GTK_BOX(buttons), dump_btn, FALSE, FALSE, 0);
+        gtk_box_pack_start(GTK_BOX(buttons), trace_btn, FALSE, FALSE, 0);
+        gtk_box_pack_start(GTK_BOX(buttons), save_trace_btn, FALSE, FALSE, 0);
+        gtk_box_pack_start(GTK_BOX(vbox), buttons, FALSE, FALSE, 0);
+
+        diagnostics_view = gtk_text_view_new();
+        gtk_text_view_set_editable(GTK_TEXT_VIEW(diagnostics_view), FALSE);
+        gtk_text_view_set_monospace(GTK_TEXT_VIEW(diagnostics_view), TRUE);
+        gtk_box_pack_start(GTK_BOX(vbox), diagnostics_view, TRUE, TRUE, 0);
+
+        g_signal_connect(reset_btn, "clicked", G_CALLBACK(on_diagnostics_reset), this);
+        g_signal_connect(dump_btn, "clicked", G_CALLBACK(on_diagnostics_dump), this);
+        g_signal_connect(trace_btn, "toggled", G_CALLBACK(on_trace_toggled), this);
+        g_signal_connect(save_trace_btn, "clicked", G_CALLBACK(on_trace_save), this);
+
+        diagnostics_page = vbox;
+        gtk_notebook_append_page(GTK_NOTEBOOK(notebook), diagnostics_page, gtk_label_new("Diagnostics"));
+        gtk_widget_show_all(diagnostics_page);
+    }
+
+    gtk_notebook_set_current_page(GTK_NOTEBOOK(notebook),
+        gtk_notebook_page_num(GTK_NOTEBOOK(notebook), diagnostics_page));
+    refresh_diagnostics();
+}
+
+void TaskManager::refresh_diagnostics() {
+    if (!diagnostics_view) return;
+
+    // Formatting the report is the only cost here, so skip it while hidden
+    int current = gtk_notebook_get_current_page(GTK_NOTEBOOK(notebook));
+    if (gtk_notebook_get_nth_page(GTK_NOTEBOOK(notebook), current) != diagnostics_page) return;
+
+    std::string report = Diagnostics::format_report();
+    gtk_text_buffer_set_text(gtk_text_view_get_buffer(GTK_TEXT_VIEW(diagnostics_view)),
+                             report.c_str(), -1);
+}
+
+void TaskManager::on_diagnostics_reset(GtkWidget*, gpointer data) {
+    Diagnostics::reset();
+    static_cast<TaskManager*>(data)->refresh_diagnostics();
+}
+
+void TaskManager::on_diagnostics_dump(GtkWidget*, gpointer) {
+    std::cerr << Diagnostics::format_report();
+}
+
+void TaskManager::on_trace_toggled(GtkToggleButton* button, gpointer) {
+    TraceRecorder::set_enabled(gtk_toggle_button_get_active(button));
+}
+
+void TaskManager::on_trace_save(GtkWidget*, gpointer) {
+    std::string path = TraceRecorder::default_dump_path();
+    if (TraceRecorder::dump(path)) {
+        std::cerr << "Trace written to " << path << std::endl;
+    }
+}
+
+// Sparklines scale to their own peak so small processes still show a shape
+gboolean TaskManager::on_history_draw(GtkWidget* widget, cairo_t* cr, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+
+    std::vector<double> values;
+    values.reserve(self->selected_history.size());
+    double peak = 0;
+    for (const auto& sample : self->selected_history) {
+        double value = widget == self->history_cpu_area ? sample.cpu
+                     : widget == self->history_rss_area ? sample.rss_kb / 1024.0
+                     : sample.io_rate / 1024.0;
+        values.push_back(value);
+        if (value > peak) peak = value;
+    }
+
+    if (widget == self->history_cpu_area) {
+        draw_graph("draw_graph:pid_cpu", widget, cr, values, std::max(peak * 1.2, 1.0), 0.0, 1.0, 0.0);
+    } else if (widget == self->history_rss_area) {
+        draw_graph("draw_graph:pid_rss", widget, cr, values, std::max(peak * 1.2, 1.0), 0.2, 0.8, 1.0);
+    } else {
+        draw_graph("draw_graph:pid_io", widget, cr, values, std::max(peak * 1.2, 1.0), 1.0, 1.0, 0.0);
+    }
     return FALSE;
 }
 
 gboolean TaskManager::on_delete_event(GtkWidget*, GdkEvent*, gpointer) {
+    DEBUG_ACTION(std::cerr << Diagnostics::format_report());
     gtk_main_quit();
     return FALSE;
 }
@@ -750,6 +2004,8 @@ void TaskManager::on_end_process(GtkWidget*, gpointer data) {
 
         if (ProcParser::terminate_process(pid, false)) {
             std::cerr << "Terminated process " << pid << std::endl;
+        } else if (errno == EPERM) {
+            escalate_process_action({"signal", std::to_string(pid), SIGTERM}, "Terminated process ", "Failed to terminate process ");
         } else {
             std::cerr << "Failed to terminate process " << pid << std::endl;
         }
@@ -821,40 +2077,6 @@ void TaskManager::apply_search_filter(const std::string& query, const TabState&
     (void)tab;
 }
 
-NetworkStats TaskManager::get_network_stats() {
-    NetworkStats stats;
-    stats.bytes_recv = 0;
-    stats.bytes_sent = 0;
-
-    std::ifstream net_dev("/proc/net/dev");
-    if (!net_dev) return stats;
-
-    std::string line;
-    // Skip first two header lines
-    std::getline(net_dev, line);
-    std::getline(net_dev, line);
-
-    while (std::getline(net_dev, line)) {
-        std::istringstream iss(line);
-        std::string interface;
-        iss >> interface;
-
-        // Skip loopback interface
-        if (interface.find("lo:") != std::string::npos) continue;
-
-        uint64_t bytes_recv, packets_recv, errs_recv, drop_recv, fifo_recv, frame_recv, compressed_recv, multicast_recv;
-        uint64_t bytes_sent, packets_sent, errs_sent, drop_sent, fifo_sent, colls_sent, carrier_sent, compressed_sent;
-
-        iss >> bytes_recv >> packets_recv >> errs_recv >> drop_recv >> fifo_recv >> frame_recv >> compressed_recv >> multicast_recv;
-        iss >> bytes_sent >> packets_sent >> errs_sent >> drop_sent >> fifo_sent >> colls_sent >> carrier_sent >> compressed_sent;
-
-        stats.bytes_recv += bytes_recv;
-        stats.bytes_sent += bytes_sent;
-    }
-
-    return stats;
-}
-
 gboolean TaskManager::on_processes_button_press(GtkWidget* widget, GdkEventButton* event, gpointer data) {
     auto* self = static_cast<TaskManager*>(data);
 
@@ -876,6 +2098,8 @@ gboolean TaskManager::on_processes_button_press(GtkWidget* widget, GdkEventButto
             GtkWidget* suspend_item = gtk_menu_item_new_with_label("Suspend");
             GtkWidget* resume_item = gtk_menu_item_new_with_label("Resume");
             GtkWidget* separator1 = gtk_separator_menu_item_new();
+            GtkWidget* inspect_item = gtk_menu_item_new_with_label("Inspect...");
+            GtkWidget* throttle_item = gtk_menu_item_new_with_label("Throttle...");
 
             // Priority submenu
             GtkWidget* priority_item = gtk_menu_item_new_with_label("Set Priority");
@@ -899,6 +2123,8 @@ gboolean TaskManager::on_processes_button_press(GtkWidget* widget, GdkEventButto
             g_signal_connect(kill_item, "activate", G_CALLBACK(on_process_kill), self);
             g_signal_connect(suspend_item, "activate", G_CALLBACK(on_process_suspend), self);
             g_signal_connect(resume_item, "activate", G_CALLBACK(on_process_resume), self);
+            g_signal_connect(inspect_item, "activate", G_CALLBACK(on_process_inspect), self);
+            g_signal_connect(throttle_item, "activate", G_CALLBACK(on_process_throttle), self);
 
             g_object_set_data(G_OBJECT(realtime_item), "priority", GINT_TO_POINTER(-20));
             g_object_set_data(G_OBJECT(high_item), "priority", GINT_TO_POINTER(-10));
@@ -918,6 +2144,8 @@ gboolean TaskManager::on_processes_button_press(GtkWidget* widget, GdkEventButto
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), resume_item);
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), separator1);
             gtk_menu_shell_append(GTK_MENU_SHELL(menu), priority_item);
+            gtk_menu_shell_append(GTK_MENU_SHELL(menu), throttle_item);
+            gtk_menu_shell_append(GTK_MENU_SHELL(menu), inspect_item);
 
             gtk_widget_show_all(menu);
             gtk_menu_popup_at_pointer(GTK_MENU(menu), reinterpret_cast<GdkEvent*>(event));
@@ -1026,11 +2254,7 @@ void TaskManager::on_service_start(GtkWidget*, gpointer data) {
         gtk_tree_model_get(model, &iter, 0, &name, -1);
 
         if (name) {
-            if (SystemdManager::start_service(name)) {
-                std::cout << "Started service: " << name << std::endl;
-            } else {
-                std::cerr << "Failed to start service: " << name << std::endl;
-            }
+            queue_service_action("start", name, "Started service: ", "Failed to start service: ");
             g_free(name);
         }
     }
@@ -1049,11 +2273,7 @@ void TaskManager::on_service_stop(GtkWidget*, gpointer data) {
         gtk_tree_model_get(model, &iter, 0, &name, -1);
 
         if (name) {
-            if (SystemdManager::stop_service(name)) {
-                std::cout << "Stopped service: " << name << std::endl;
-            } else {
-                std::cerr << "Failed to stop service: " << name << std::endl;
-            }
+            queue_service_action("stop", name, "Stopped service: ", "Failed to stop service: ");
             g_free(name);
         }
     }
@@ -1072,11 +2292,7 @@ void TaskManager::on_service_restart(GtkWidget*, gpointer data) {
         gtk_tree_model_get(model, &iter, 0, &name, -1);
 
         if (name) {
-            if (SystemdManager::restart_service(name)) {
-                std::cout << "Restarted service: " << name << std::endl;
-            } else {
-                std::cerr << "Failed to restart service: " << name << std::endl;
-            }
+            queue_service_action("restart", name, "Restarted service: ", "Failed to restart service: ");
             g_free(name);
         }
     }
@@ -1095,11 +2311,7 @@ void TaskManager::on_service_enable(GtkWidget*, gpointer data) {
         gtk_tree_model_get(model, &iter, 0, &name, -1);
 
         if (name) {
-            if (SystemdManager::enable_service(name)) {
-                std::cout << "Enabled service: " << name << std::endl;
-            } else {
-                std::cerr << "Failed to enable service: " << name << std::endl;
-            }
+            queue_service_action("enable", name, "Enabled service: ", "Failed to enable service: ");
             g_free(name);
         }
     }
@@ -1118,11 +2330,7 @@ void TaskManager::on_service_disable(GtkWidget*, gpointer data) {
         gtk_tree_model_get(model, &iter, 0, &name, -1);
 
         if (name) {
-            if (SystemdManager::disable_service(name)) {
-                std::cout << "Disabled service: " << name << std::endl;
-            } else {
-                std::cerr << "Failed to disable service: " << name << std::endl;
-            }
+            queue_service_action("disable", name, "Disabled service: ", "Failed to disable service: ");
             g_free(name);
         }
     }
@@ -1141,11 +2349,7 @@ void TaskManager::on_service_enable_now(GtkWidget*, gpointer data) {
         gtk_tree_model_get(model, &iter, 0, &name, -1);
 
         if (name) {
-            if (SystemdManager::enable_now_service(name)) {
-                std::cout << "Enabled and started service: " << name << std::endl;
-            } else {
-                std::cerr << "Failed to enable and start service: " << name << std::endl;
-            }
+            queue_service_action("enable-now", name, "Enabled and started service: ", "Failed to enable and start service: ");
             g_free(name);
         }
     }
@@ -1211,6 +2415,8 @@ void TaskManager::on_process_terminate(GtkWidget*, gpointer data) {
 
         if (ProcParser::terminate_process(pid, false)) {
             std::cout << "Terminated process " << pid << std::endl;
+        } else if (errno == EPERM) {
+            escalate_process_action({"signal", std::to_string(pid), SIGTERM}, "Terminated process ", "Failed to terminate process ");
         } else {
             std::cerr << "Failed to terminate process " << pid << std::endl;
         }
@@ -1231,6 +2437,8 @@ void TaskManager::on_process_kill(GtkWidget*, gpointer data) {
 
         if (ProcParser::terminate_process(pid, true)) {
             std::cout << "Killed process " << pid << std::endl;
+        } else if (errno == EPERM) {
+            escalate_process_action({"signal", std::to_string(pid), SIGKILL}, "Killed process ", "Failed to kill process ");
         } else {
             std::cerr << "Failed to kill process " << pid << std::endl;
         }
@@ -1251,6 +2459,8 @@ void TaskManager::on_process_suspend(GtkWidget*, gpointer data) {
 
         if (ProcParser::suspend_process(pid)) {
             std::cout << "Suspended process " << pid << std::endl;
+        } else if (errno == EPERM) {
+            escalate_process_action({"signal", std::to_string(pid), SIGSTOP}, "Suspended process ", "Failed to suspend process ");
         } else {
             std::cerr << "Failed to suspend process " << pid << std::endl;
         }
@@ -1271,12 +2481,170 @@ void TaskManager::on_process_resume(GtkWidget*, gpointer data) {
 
         if (ProcParser::resume_process(pid)) {
             std::cout << "Resumed process " << pid << std::endl;
+        } else if (errno == EPERM) {
+            escalate_process_action({"signal", std::to_string(pid), SIGCONT}, "Resumed process ", "Failed to resume process ");
         } else {
             std::cerr << "Failed to resume process " << pid << std::endl;
         }
     }
 }
 
+void TaskManager::on_process_inspect(GtkWidget*, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+
+    GtkTreeSelection* selection = gtk_tree_view_get_selection(
+        GTK_TREE_VIEW(self->processes_tab.treeview));
+    GtkTreeIter iter;
+    GtkTreeModel* model;
+
+    if (gtk_tree_selection_get_selected(selection, &model, &iter)) {
+        gint pid;
+        gchar* name;
+        gtk_tree_model_get(model, &iter, 0, &pid, 1, &name, -1);
+
+        InspectorWindow::open(GTK_WINDOW(self->window), pid, name ? name : "");
+        g_free(name);
+    }
+}
+
+void TaskManager::on_process_throttle(GtkWidget*, gpointer data) {
+    auto* self = static_cast<TaskManager*>(data);
+
+    GtkTreeSelection* selection = gtk_tree_view_get_selection(
+        GTK_TREE_VIEW(self->processes_tab.treeview));
+    GtkTreeIter iter;
+    GtkTreeModel* model;
+    if (!gtk_tree_selection_get_selected(selection, &model, &iter) || !self->latest_snapshot) return;
+
+    gint pid;
+    gchar* name;
+    gtk_tree_model_get(model, &iter, 0, &pid, 1, &name, -1);
+    std::string title = "Throttle " + std::string(name ? name : "") + " (" + std::to_string(pid) + ")";
+    g_free(name);
+
+    if (!self->throttle.available()) {
+        std::cerr << "Cannot throttle process " << pid << ": " << self->throttle.get_error() << std::endl;
+        return;
+    }
+
+    // gtk_dialog_run() keeps refreshing underneath, which replaces
+    // latest_snapshot; hold on to the one the dialog is built from
+    std::shared_ptr<const Snapshot> shown = self->latest_snapshot;
+    const Snapshot& snapshot = *shown;
+    pid_t leader = 0;
+    for (const auto& proc : *snapshot.processes) {
+        if (proc.pid == pid) {
+            leader = self->throttle.find_leader(proc.cgroup);
+            break;
+        }
+    }
+    // Editing a throttled process edits the group it is in
+    ThrottleLimits limits;
+    if (leader) limits = *self->throttle.get_limits(leader);
+
+    const int RESPONSE_REMOVE = 1;
+    GtkWidget* dialog = gtk_dialog_new_with_buttons(title.c_str(), GTK_WINDOW(self->window),
+        static_cast<GtkDialogFlags>(GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT),
+        "_Cancel", GTK_RESPONSE_CANCEL, nullptr);
+    if (leader) gtk_dialog_add_button(GTK_DIALOG(dialog), "_Remove Limits", RESPONSE_REMOVE);
+    gtk_dialog_add_button(GTK_DIALOG(dialog), "_Apply", GTK_RESPONSE_APPLY);
+
+    GtkWidget* grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID(grid), 6);
+    gtk_grid_set_column_spacing(GTK_GRID(grid), 12);
+    gtk_container_set_border_width(GTK_CONTAINER(grid), 12);
+
+    // 0 leaves a resource unlimited
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    double total_mb = snapshot.stats.total_memory / (1024.0 * 1024.0);
+    GtkWidget* cpu_spin = gtk_spin_button_new_with_range(0, 100.0 * (cpus > 0 ? cpus : 1), 5);
+    GtkWidget* mem_spin = gtk_spin_button_new_with_range(0, total_mb > 0 ? total_mb : 1 << 20, 64);
+    GtkWidget* io_spin = gtk_spin_button_new_with_range(0, 10000, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(cpu_spin), limits.cpu_percent);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(mem_spin), limits.memory_high / (1024.0 * 1024.0));
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(io_spin), limits.io_bps / (1024.0 * 1024.0));
+
+    const char* labels[] = {"CPU (% of one core, 0 = no limit):", "Memory high (MB, 0 = no limit):",
+                            "Disk I/O per disk (MB/s, 0 = no limit):"};
+    GtkWidget* spins[] = {cpu_spin, mem_spin, io_spin};
+    for (int i = 0; i < 3; i++) {
+        GtkWidget* label = gtk_label_new(labels[i]);
+        gtk_widget_set_halign(label, GTK_ALIGN_START);
+        gtk_grid_attach(GTK_GRID(grid), label, 0, i, 1, 1);
+        gtk_grid_attach(GTK_GRID(grid), spins[i], 1, i, 1, 1);
+    }
+    // Children forked later land in the group anyway; this is for existing ones
+    GtkWidget* children = gtk_check_button_new_with_label("Include child processes");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(children), TRUE);
+    gtk_grid_attach(GTK_GRID(grid), children, 0, 3, 2, 1);
+
+    gtk_container_add(GTK_CONTAINER(gtk_dialog_get_content_area(GTK_DIALOG(dialog))), grid);
+    gtk_widget_show_all(dialog);
+    gint response = gtk_dialog_run(GTK_DIALOG(dialog));
+
+    limits.cpu_percent = gtk_spin_button_get_value(GTK_SPIN_BUTTON(cpu_spin));
+    limits.memory_high = static_cast<uint64_t>(gtk_spin_button_get_value(GTK_SPIN_BUTTON(mem_spin))) * 1024 * 1024;
+    limits.io_bps = static_cast<uint64_t>(gtk_spin_button_get_value(GTK_SPIN_BUTTON(io_spin))) * 1024 * 1024;
+    bool with_children = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(children));
+    gtk_widget_destroy(dialog);
+    if (response != RESPONSE_REMOVE && response != GTK_RESPONSE_APPLY) return;
+
+    // Collected before the group is released and forgotten
+    std::set<pid_t> members{pid};
+    if (leader) {
+        for (const auto& proc : *self->latest_snapshot->processes) {
+            if (self->throttle.find_leader(proc.cgroup) == leader) members.insert(proc.pid);
+        }
+    }
+
+    // systemd is asked on the throttle's worker thread; the rows are redrawn
+    // once it has answered
+    if (response == RESPONSE_REMOVE) {
+        self->throttle.release(leader, [self, leader, members](bool ok, const std::string& message) {
+            if (ok) {
+                std::cout << "Removed limits from process " << leader << std::endl;
+            } else {
+                std::cerr << "Failed to remove limits from process " << leader << ": " << message << std::endl;
+            }
+            self->redraw_process_rows(members);
+        });
+    } else {
+        std::vector<pid_t> pids{pid};
+        if (with_children) {
+            // Breadth-first over ppid, from the newest scan rather than the
+            // one the dialog opened with
+            std::unordered_map<pid_t, std::vector<pid_t>> children_of;
+            for (const auto& proc : *self->latest_snapshot->processes) children_of[proc.ppid].push_back(proc.pid);
+            for (size_t i = 0; i < pids.size(); i++) {
+                auto it = children_of.find(pids[i]);
+                if (it != children_of.end()) pids.insert(pids.end(), it->second.begin(), it->second.end());
+            }
+        }
+
+        size_t count = pids.size();
+        self->throttle.throttle(leader ? leader : pid, pids, limits,
+            [self, pid, count, members](bool ok, const std::string& message) {
+                if (ok) {
+                    std::cout << "Throttled process " << pid << " (" << count << " processes)" << std::endl;
+                    if (!message.empty()) std::cerr << message << std::endl;
+                } else {
+                    std::cerr << "Failed to throttle process " << pid << ": " << message << std::endl;
+                }
+                self->redraw_process_rows(members);
+            });
+    }
+}
+
+void TaskManager::redraw_process_rows(const std::set<pid_t>& pids) {
+    // New limits on a group the rows are already in never show up in a delta;
+    // processes that moved are picked up by the next scan. Only rows still
+    // shown are redrawn, from the current snapshot.
+    if (!latest_snapshot) return;
+    for (const auto& proc : *latest_snapshot->processes) {
+        if (process_rows.count(proc.pid) && pids.count(proc.pid)) set_process_row(proc);
+    }
+}
+
 void TaskManager::on_process_priority(GtkWidget* widget, gpointer data) {
     auto* self = static_cast<TaskManager*>(data);
 
@@ -1293,6 +2661,10 @@ void TaskManager::on_process_priority(GtkWidget* widget, gpointer data) {
 
         if (ProcParser::set_priority(pid, priority)) {
             std::cout << "Set priority of process " << pid << " to " << priority << std::endl;
+        } else if (errno == EPERM || errno == EACCES) {
+            // Raising priority, or renicing another user's process, needs root
+            escalate_process_action({"renice", std::to_string(pid), priority},
+                                    "Set priority of process ", "Failed to set priority of process ");
         } else {
             std::cerr << "Failed to set priority of process " << pid << std::endl;
         }
@@ -9,35 +9,31 @@
 #include <map>
 #include <set>
 #include <chrono>
+#include <unordered_map>
 #include "proc_parser.h"
 #include "systemd_manager.h"
+#include "snapshot.h"
+#include "snapshot_slot.h"
+#include "perf_history.h"
+#include "collector_scheduler.h"
+#include "process_history.h"
+#include "socket_index.h"
+#include "tcp_throughput.h"
+#include "link_stats.h"
+#include "disk_stats.h"
+#include "vm_stats.h"
+#include "app_groups.h"
+#include "rules_engine.h"
+#include "cgroup_throttle.h"
 
 struct TabState {
     GtkWidget* treeview = nullptr;
     GtkListStore* store = nullptr;
     GtkTreeModelFilter* filter = nullptr;
-    std::vector<ProcessInfo> processes;
     GtkTreeViewColumn* sort_column = nullptr;
     GtkSortType sort_order = GTK_SORT_ASCENDING;
 };
 
-struct PerformanceData {
-    std::vector<double> cpu_history;
-    std::vector<double> mem_history;
-    std::vector<double> net_history;
-    std::vector<double> gpu_history;
-    double current_cpu = 0;
-    double current_mem = 0;
-    double current_net = 0;
-    double current_gpu = 0;
-    const size_t max_history = 60;
-};
-
-struct NetworkStats {
-    uint64_t bytes_recv = 0;
-    uint64_t bytes_sent = 0;
-};
-
 class TaskManager {
 public:
     TaskManager();
@@ -54,9 +50,26 @@ private:
     GtkScrolledWindow* services_scrolled = nullptr;
     GtkScrolledWindow* startup_scrolled = nullptr;
 
+    // Notebook pages for tabs that are built on first show
+    GtkWidget* services_page = nullptr;
+    GtkWidget* startup_page = nullptr;
+    GtkWidget* performance_page = nullptr;
+    GtkWidget* connections_page = nullptr;
+    GtkWidget* users_page = nullptr;
+    GtkWidget* rules_page = nullptr;
+    gulong first_paint_handler = 0;
+
+    // Hidden until Ctrl+Shift+D (or $TASKMGR_DIAGNOSTICS)
+    GtkWidget* diagnostics_page = nullptr;
+    GtkWidget* diagnostics_view = nullptr;
+
     TabState processes_tab;
     TabState services_tab;
     TabState startup_tab;
+    TabState connections_tab;
+    TabState apps_tab;
+    TabState users_tab;
+    TabState rules_tab;
     PerformanceData perf_data;
     GtkDrawingArea* cpu_drawing_area = nullptr;
     GtkDrawingArea* mem_drawing_area = nullptr;
@@ -64,20 +77,115 @@ private:
     GtkDrawingArea* gpu_drawing_area = nullptr;
     GtkLabel* cpu_label = nullptr;
     GtkLabel* mem_label = nullptr;
+    GtkLabel* mem_detail_label = nullptr;
     GtkLabel* net_label = nullptr;
     GtkLabel* gpu_label = nullptr;
+    double net_graph_max = 1.0;
+
+    // One graph per network interface or disk, added and removed as devices
+    // come and go. History is kept from startup, widgets once the tab is built.
+    struct DeviceView {
+        std::string name;
+        double graph_max = 0;                 // Fixed scale (link speed); 0 scales to the peak
+        std::vector<double> first_history;    // Receive / read, drawn green
+        std::vector<double> second_history;   // Send / write, drawn red
+        GtkWidget* box = nullptr;
+        GtkLabel* title = nullptr;
+        GtkWidget* area = nullptr;
+        GtkLabel* label = nullptr;
+    };
+    std::map<int, DeviceView> interface_views;        // Mbps, by ifindex
+    std::map<std::string, DeviceView> disk_views;     // MB/s, by device name
+    GtkWidget* disks_box = nullptr;
+    GtkWidget* interfaces_box = nullptr;
+
+    // Details pane under the process list: sparklines for the selected PID
+    ProcessHistory process_history;
+    pid_t selected_pid = 0;
+    std::vector<ProcessSample> selected_history;
+    GtkLabel* details_label = nullptr;
+    GtkWidget* history_cpu_area = nullptr;
+    GtkWidget* history_rss_area = nullptr;
+    GtkWidget* history_io_area = nullptr;
 
     std::thread refresh_thread;
     std::atomic<bool> running;
     std::atomic<bool> paused;
+    // Each collector runs on its own period; services and startup are only
+    // enabled once their tab has been shown
+    CollectorScheduler scheduler;
+    int system_collector = -1;
+    int processes_collector = -1;
+    int network_collector = -1;
+    int services_collector = -1;
+    int startup_collector = -1;
+    int connections_collector = -1;
+    int disks_collector = -1;
+
+    // Collector -> UI hand-off. Only one refresh_data idle is queued at a time.
+    SnapshotSlot<Snapshot> snapshot_slot;
+    std::atomic<bool> apply_pending;
+    std::shared_ptr<const Snapshot> latest_snapshot;   // UI thread
+    uint64_t shown_sequence = 0;                        // UI thread; sequence of latest_snapshot
+    std::shared_ptr<const Snapshot> last_published;    // Collector thread
+    uint64_t snapshot_sequence = 0;
+
+    // Persistent list store iters for O(1) row updates by PID
+    std::unordered_map<pid_t, GtkTreeIter> process_rows;
+
+    // Apps mode of the Processes tab: one row per application, aggregated
+    // from the process delta only while the mode is shown
+    AppGroups app_groups;
+    bool apps_mode = false;
+    std::unordered_map<std::string, GtkTreeIter> app_rows;
+    GtkWidget* processes_list = nullptr;
+    GtkWidget* apps_list = nullptr;
+    GtkWidget* group_combo = nullptr;
+
+    // Users tab rows by uid; activating one filters the process list to it
+    std::unordered_map<uid_t, GtkTreeIter> user_rows;
+    uid_t filter_uid = static_cast<uid_t>(-1);
+    GtkLabel* user_filter_label = nullptr;
+    GtkWidget* user_filter_button = nullptr;
+    uint64_t startup_generation_seen = 0;
+
+    // Connections rows keyed by protocol, endpoints and inode; seen is the
+    // refresh that last listed the row, so stale ones can be dropped
+    struct ConnectionRow {
+        GtkTreeIter iter;
+        std::string state;
+        pid_t pid;
+        uint64_t seen;
+    };
+    std::unordered_map<std::string, ConnectionRow> connection_rows;
+    uint64_t connections_refresh = 0;
 
     ProcParser proc_parser;
     SystemdManager systemd_mgr;
     std::string current_search_query;
 
-    // Network monitoring
-    NetworkStats last_network_stats;
-    std::chrono::steady_clock::time_point last_network_time;
+    // Socket inode -> PID ownership (collector thread)
+    SocketIndex socket_index;
+    TcpThroughput tcp_throughput;
+
+    // Per-interface counters over rtnetlink, per-disk ones from /proc/diskstats
+    // (collector thread)
+    LinkStats link_stats;
+    DiskStats disk_stats;
+
+    // Paging rates from /proc/vmstat (collector thread)
+    VmStats vm_stats;
+
+    // Threshold rules, checked on every process scan in the collector so they
+    // act whether or not anyone is looking; the Rules tab shows the log
+    RulesEngine rules_engine;
+    std::string rules_path;
+    bool rules_loaded = false;
+    uint64_t rules_log_seen = 0;
+
+    // Transient cgroups for processes throttled from the Processes tab (UI
+    // thread); the Limit column shows what applies to each row
+    CgroupThrottle throttle;
 
     // UI Callbacks
     static gboolean on_delete_event(GtkWidget* widget, GdkEvent* event, gpointer data);
@@ -88,11 +196,25 @@ private:
     static gboolean refresh_data(gpointer data);
     static void on_column_clicked(GtkTreeViewColumn* col, gpointer data);
     static void on_search_changed(GtkSearchEntry* entry, gpointer data);
+    static void on_group_mode_changed(GtkComboBox* combo, gpointer data);
+    static void on_user_activated(GtkTreeView* treeview, GtkTreePath* path, GtkTreeViewColumn* column, gpointer data);
+    static void on_user_filter_cleared(GtkWidget* widget, gpointer data);
+    static void on_rules_dry_run_toggled(GtkToggleButton* button, gpointer data);
     static void on_pause_toggled(GtkToggleButton* button, gpointer data);
     static gboolean on_perf_draw(GtkWidget* widget, cairo_t* cr, gpointer data);
+    static gboolean on_history_draw(GtkWidget* widget, cairo_t* cr, gpointer data);
+    static void on_process_selection_changed(GtkTreeSelection* selection, gpointer data);
     static gboolean on_mem_draw(GtkWidget* widget, cairo_t* cr, gpointer data);
     static gboolean on_net_draw(GtkWidget* widget, cairo_t* cr, gpointer data);
+    static gboolean on_device_draw(GtkWidget* widget, cairo_t* cr, gpointer data);
     static gboolean on_gpu_draw(GtkWidget* widget, cairo_t* cr, gpointer data);
+    static void on_switch_page(GtkNotebook* notebook, GtkWidget* page, guint page_num, gpointer data);
+    static gboolean on_first_paint(GtkWidget* widget, cairo_t* cr, gpointer data);
+    static gboolean on_key_press(GtkWidget* widget, GdkEventKey* event, gpointer data);
+    static void on_diagnostics_reset(GtkWidget* widget, gpointer data);
+    static void on_diagnostics_dump(GtkWidget* widget, gpointer data);
+    static void on_trace_toggled(GtkToggleButton* button, gpointer data);
+    static void on_trace_save(GtkWidget* widget, gpointer data);
 
     // Right-click menu callbacks
     static gboolean on_processes_button_press(GtkWidget* widget, GdkEventButton* event, gpointer data);
@@ -105,6 +227,8 @@ private:
     static void on_process_suspend(GtkWidget* widget, gpointer data);
     static void on_process_resume(GtkWidget* widget, gpointer data);
     static void on_process_priority(GtkWidget* widget, gpointer data);
+    static void on_process_inspect(GtkWidget* widget, gpointer data);
+    static void on_process_throttle(GtkWidget* widget, gpointer data);
 
     // Service menu callbacks
     static void on_service_start(GtkWidget* widget, gpointer data);
@@ -120,16 +244,35 @@ private:
 
     // Internal methods
     void setup_processes_tab();
+    GtkWidget* create_process_details();
+    void refresh_process_details();
     void setup_services_tab();
     void setup_startup_tab();
     void setup_performance_tab();
-    void refresh_processes();
-    void refresh_services() const;
-    void refresh_startup() const;
-    void refresh_performance();
-
-    // Network monitoring helper
-    NetworkStats get_network_stats();
+    void setup_connections_tab();
+    GtkWidget* add_lazy_page(const char* title);
+    void show_diagnostics_tab();
+    void refresh_diagnostics();
+    void collector_loop();
+    std::shared_ptr<Snapshot> collect_snapshot(uint32_t due);
+    // reconcile: rebuild every row instead of applying the snapshot's delta
+    void refresh_processes(const Snapshot& snapshot, bool reconcile);
+    void set_process_row(const ProcessInfo& proc);
+    // Redraws the listed PIDs' rows that are still shown
+    void redraw_process_rows(const std::set<pid_t>& pids);
+    GtkWidget* create_apps_view();
+    void refresh_apps(const Snapshot& snapshot);
+    void setup_users_tab();
+    void refresh_users(const Snapshot& snapshot);
+    void setup_rules_tab();
+    void refresh_rules_log();
+    void refresh_services(const Snapshot& snapshot) const;
+    void refresh_startup(const Snapshot& snapshot);
+    void refresh_connections(const Snapshot& snapshot);
+    void refresh_performance(const Snapshot& snapshot);
+    void refresh_network(const Snapshot& snapshot);
+    void refresh_disks(const Snapshot& snapshot);
+    void create_device_widgets(GtkWidget* container, DeviceView& view);
 
     // Helper methods for scroll preservation
     void save_scroll_position(GtkScrolledWindow* scrolled, double& v_pos, double& h_pos);
@@ -0,0 +1,68 @@
+/*
+ * Shared-memory snapshot layout published by taskmgr.
+ *
+ * taskmgr writes every tick's system and per-process snapshot into a POSIX
+ * shared memory object named by TASKMGR_SHM_NAME_FMT (formatted with the
+ * owner's uid). Readers map it read-only and copy a consistent snapshot
+ * without any syscalls, using the seqlock in the header:
+ *
+ *   1. s1 = atomic load-acquire of header->seq; if odd, a write is in progress, retry
+ *   2. copy the header fields and process records you need
+ *   3. acquire fence, s2 = load of header->seq; if s1 != s2, retry
+ *
+ * The region is a header followed by `capacity` process records. Capacity
+ * only grows; if it exceeds what you mapped, re-map using the object's
+ * current size (fstat) and retry.
+ *
+ * This header is plain C so non-C++ agents can include it directly.
+ */
+#ifndef TASKMGR_SHM_H
+#define TASKMGR_SHM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TASKMGR_SHM_NAME_FMT "/linux-taskmanager-%u"
+#define TASKMGR_SHM_MAGIC 0x534d4754u   /* "TGMS" */
+#define TASKMGR_SHM_VERSION 1
+#define TASKMGR_SHM_NAME_LEN 32
+
+struct taskmgr_shm_process {
+    int32_t pid;
+    int32_t ppid;
+    double cpu_usage;        /* % of total system capacity */
+    double memory_usage;     /* % of MemTotal */
+    uint64_t memory_rss;     /* bytes */
+    uint64_t memory_vms;     /* bytes */
+    int32_t thread_count;
+    int32_t nice;
+    char state;
+    char reserved[7];
+    char name[TASKMGR_SHM_NAME_LEN];   /* NUL-terminated, truncated */
+    char user[TASKMGR_SHM_NAME_LEN];   /* NUL-terminated, truncated */
+};
+
+struct taskmgr_shm_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t seq;             /* seqlock counter; odd while the writer is updating */
+    uint64_t capacity;        /* process records following the header */
+    uint64_t snapshot_seq;    /* collector tick number */
+    int64_t timestamp_ns;     /* CLOCK_MONOTONIC time the snapshot was taken */
+    double total_cpu_usage;
+    uint64_t total_memory;
+    uint64_t available_memory;
+    uint64_t cached_memory;
+    double uptime;
+    uint64_t process_count;   /* valid records, always <= capacity */
+};
+
+static inline size_t taskmgr_shm_size(uint64_t capacity) {
+    return sizeof(struct taskmgr_shm_header) + capacity * sizeof(struct taskmgr_shm_process);
+}
+
+static inline struct taskmgr_shm_process* taskmgr_shm_processes(struct taskmgr_shm_header* header) {
+    return (struct taskmgr_shm_process*)(header + 1);
+}
+
+#endif
@@ -0,0 +1,160 @@
+#include "tcp_throughput.h"
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    // From the kernel's tcp_states.h, which is not exported to userspace
+    const unsigned TCP_STATE_TIME_WAIT = 6;
+    const unsigned TCP_STATE_LISTEN = 10;
+}
+
+TcpThroughput::TcpThroughput() : buffer(32768) {
+    netlink_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (netlink_fd < 0) perror("socket(NETLINK_SOCK_DIAG)");
+}
+
+TcpThroughput::~TcpThroughput() {
+    if (netlink_fd >= 0) close(netlink_fd);
+}
+
+void TcpThroughput::update(std::vector<ProcessInfo>& procs, const SocketIndex& index,
+                           std::chrono::steady_clock::time_point when) {
+    double seconds = generation ? std::chrono::duration<double>(when - last_update).count() : 0;
+    last_update = when;
+    generation++;
+
+    std::unordered_map<pid_t, Rates> deltas;
+    bool complete = false;
+    if (netlink_fd >= 0) {
+        complete = dump(AF_INET, deltas, index);
+        complete = dump(AF_INET6, deltas, index) && complete;
+    }
+
+    // Sockets missing from a partial dump keep their baseline
+    for (auto it = sockets.begin(); complete && it != sockets.end(); ) {
+        if (it->second.generation != generation) {
+            it = sockets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto& proc : procs) {
+        auto it = deltas.find(proc.pid);
+        if (it == deltas.end() || seconds <= 0) {
+            proc.net_send_rate = 0;
+            proc.net_recv_rate = 0;
+        } else {
+            proc.net_send_rate = it->second.sent / seconds;
+            proc.net_recv_rate = it->second.received / seconds;
+        }
+    }
+}
+
+bool TcpThroughput::dump(int family, std::unordered_map<pid_t, Rates>& deltas,
+                         const SocketIndex& index) {
+    struct {
+        struct nlmsghdr header;
+        struct inet_diag_req_v2 request;
+    } message;
+    memset(&message, 0, sizeof(message));
+    message.header.nlmsg_len = sizeof(message);
+    message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.header.nlmsg_seq = ++sequence;
+    message.request.sdiag_family = static_cast<__u8>(family);
+    message.request.sdiag_protocol = IPPROTO_TCP;
+    // Listening sockets never carry data and TIME_WAIT ones have no owner
+    message.request.idiag_states = ~((1u << TCP_STATE_LISTEN) | (1u << TCP_STATE_TIME_WAIT));
+    message.request.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+
+    struct sockaddr_nl kernel;
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    if (sendto(netlink_fd, &message, sizeof(message), 0,
+               reinterpret_cast<struct sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        perror("sock_diag sendto");
+        return false;
+    }
+
+    // The kernel fills in the rest of a dump as it is read, and refuses a new
+    // one on this socket until the last has been read to NLMSG_DONE
+    bool complete = true;
+    while (true) {
+        ssize_t received = recv(netlink_fd, buffer.data(), buffer.size(), 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                // Some replies were dropped; the dump itself goes on
+                complete = false;
+                continue;
+            }
+            perror("sock_diag recv");
+            return false;
+        }
+
+        int remaining = static_cast<int>(received);
+        for (auto* header = reinterpret_cast<struct nlmsghdr*>(buffer.data());
+             NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+            // Left over from a dump that was cut short
+            if (header->nlmsg_seq != sequence) continue;
+            if (header->nlmsg_type == NLMSG_DONE) {
+                // Carries the dump's error, if it failed part way
+                auto* status = static_cast<int*>(NLMSG_DATA(header));
+                if (header->nlmsg_len >= NLMSG_LENGTH(sizeof(int)) && *status < 0) {
+                    fprintf(stderr, "sock_diag: %s\n", strerror(-*status));
+                    return false;
+                }
+                return complete;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                // Only sent instead of a dump, so nothing follows it
+                auto* error = static_cast<struct nlmsgerr*>(NLMSG_DATA(header));
+                fprintf(stderr, "sock_diag: %s\n", strerror(-error->error));
+                return false;
+            }
+
+            auto* diag = static_cast<struct inet_diag_msg*>(NLMSG_DATA(header));
+            if (diag->idiag_inode == 0) continue;
+
+            // Older kernels send a shorter tcp_info; the missing tail stays zero
+            struct tcp_info info;
+            memset(&info, 0, sizeof(info));
+            int attr_len = static_cast<int>(header->nlmsg_len - NLMSG_LENGTH(sizeof(*diag)));
+            for (auto* attr = reinterpret_cast<struct rtattr*>(diag + 1);
+                 RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+                if (attr->rta_type == INET_DIAG_INFO) {
+                    size_t len = RTA_PAYLOAD(attr);
+                    memcpy(&info, RTA_DATA(attr), len < sizeof(info) ? len : sizeof(info));
+                }
+            }
+
+            auto found = sockets.find(diag->idiag_inode);
+            bool known = found != sockets.end();
+            Counters& counters = known ? found->second : sockets[diag->idiag_inode];
+
+            if (known && info.tcpi_bytes_acked >= counters.sent &&
+                info.tcpi_bytes_received >= counters.received) {
+                pid_t owner = index.get_owner(diag->idiag_inode);
+                if (owner > 0) {
+                    Rates& rates = deltas[owner];
+                    rates.sent += info.tcpi_bytes_acked - counters.sent;
+                    rates.received += info.tcpi_bytes_received - counters.received;
+                }
+            }
+            counters.sent = info.tcpi_bytes_acked;
+            counters.received = info.tcpi_bytes_received;
+            counters.generation = generation;
+        }
+    }
+}
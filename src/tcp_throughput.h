@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "proc_parser.h"
+#include "socket_index.h"
+
+// Per-process TCP send/receive rates. One NETLINK_SOCK_DIAG dump per family
+// returns every TCP socket with its tcp_info byte counters; the change since
+// the previous dump is credited to the socket's owner from the SocketIndex.
+// A socket first seen in a dump only sets its baseline. Loopback traffic
+// counts on both ends, since each end is its own socket. Collector thread only.
+class TcpThroughput {
+public:
+    TcpThroughput();
+    ~TcpThroughput();
+
+    TcpThroughput(const TcpThroughput&) = delete;
+    TcpThroughput& operator=(const TcpThroughput&) = delete;
+
+    // Sets net_send_rate / net_recv_rate on every process
+    void update(std::vector<ProcessInfo>& procs, const SocketIndex& index,
+                std::chrono::steady_clock::time_point when);
+
+private:
+    struct Counters {
+        uint64_t sent = 0;       // tcpi_bytes_acked
+        uint64_t received = 0;   // tcpi_bytes_received
+        uint64_t generation = 0;
+    };
+
+    struct Rates {
+        uint64_t sent = 0;
+        uint64_t received = 0;
+    };
+
+    bool dump(int family, std::unordered_map<pid_t, Rates>& deltas, const SocketIndex& index);
+
+    int netlink_fd = -1;
+    uint32_t sequence = 0;   // nlmsg_seq of the current dump
+    uint64_t generation = 0;
+    std::unordered_map<uint64_t, Counters> sockets;   // By inode
+    std::chrono::steady_clock::time_point last_update;
+    std::vector<char> buffer;
+};
@@ -0,0 +1,186 @@
+#include "trace_recorder.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    // About a minute of collector + UI activity at the default refresh rate
+    const uint64_t RING_CAPACITY = 16384;
+
+    // Fields are atomics because dump() reads slots the owner may be
+    // overwriting; such slots are detected via the head index and dropped
+    struct TraceEvent {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> ts_ns;
+        std::atomic<char> phase;  // 'B' or 'E'
+    };
+
+    struct ThreadRing {
+        pid_t tid = 0;
+        std::atomic<const char*> thread_name;
+        std::atomic<uint64_t> head;  // Events ever written; only the owner stores
+        TraceEvent events[RING_CAPACITY];
+
+        ThreadRing() : thread_name(nullptr), head(0) {}
+    };
+
+    // Rings outlive their threads so late dumps still see what they did
+    std::mutex rings_mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    thread_local ThreadRing* current_ring = nullptr;
+
+    uint64_t monotonic_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    ThreadRing* ring_for_this_thread() {
+        if (!current_ring) {
+            std::unique_ptr<ThreadRing> ring(new ThreadRing());
+            ring->tid = static_cast<pid_t>(syscall(SYS_gettid));
+            current_ring = ring.get();
+
+            std::lock_guard<std::mutex> lock(rings_mutex);
+            rings.push_back(std::move(ring));
+        }
+        return current_ring;
+    }
+
+    void append(const char* name, char phase) {
+        ThreadRing* ring = ring_for_this_thread();
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+
+        TraceEvent& event = ring->events[head % RING_CAPACITY];
+        event.name.store(name, std::memory_order_relaxed);
+        event.ts_ns.store(monotonic_ns(), std::memory_order_relaxed);
+        event.phase.store(phase, std::memory_order_relaxed);
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    void append_json_name(std::string& out, const char* name) {
+        // Trace names are our own literals; just keep the JSON valid
+        out += '"';
+        for (const char* c = name; *c; c++) {
+            if (*c == '"' || *c == '\\') out += '\\';
+            out += *c;
+        }
+        out += '"';
+    }
+}
+
+std::atomic<bool> TraceRecorder::enabled(getenv("TASKMGR_TRACE") != nullptr);
+
+void TraceRecorder::set_enabled(bool value) {
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+void TraceRecorder::begin(const char* name) {
+    append(name, 'B');
+}
+
+void TraceRecorder::end(const char* name) {
+    append(name, 'E');
+}
+
+void TraceRecorder::set_thread_name(const char* name) {
+    ring_for_this_thread()->thread_name.store(name, std::memory_order_relaxed);
+}
+
+std::string TraceRecorder::default_dump_path() {
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    return std::string(dir ? dir : "/tmp") + "/taskmgr-trace-" + std::to_string(getpid()) + ".json";
+}
+
+bool TraceRecorder::dump(const std::string& path, double window_seconds) {
+    uint64_t now = monotonic_ns();
+    uint64_t window_ns = static_cast<uint64_t>(window_seconds * 1e9);
+    uint64_t cutoff = now > window_ns ? now - window_ns : 0;
+    pid_t pid = getpid();
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char buffer[128];
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for (const auto& ring : rings) {
+        const char* thread_name = ring->thread_name.load(std::memory_order_relaxed);
+        if (thread_name) {
+            snprintf(buffer, sizeof(buffer),
+                     "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                     first ? "" : ",", pid, ring->tid);
+            out += buffer;
+            append_json_name(out, thread_name);
+            out += "}}";
+            first = false;
+        }
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t start = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+
+        struct Copied { const char* name; uint64_t ts_ns; char phase; };
+        std::vector<Copied> copied;
+        copied.reserve(head - start);
+        for (uint64_t i = start; i < head; i++) {
+            const TraceEvent& event = ring->events[i % RING_CAPACITY];
+            copied.push_back({event.name.load(std::memory_order_relaxed),
+                              event.ts_ns.load(std::memory_order_relaxed),
+                              event.phase.load(std::memory_order_relaxed)});
+        }
+
+        // The owner kept writing while we copied, and may be mid-way through
+        // the slot after its head; anything it lapped is torn
+        uint64_t lapped_until = ring->head.load(std::memory_order_acquire) + 1;
+        size_t skip = lapped_until > start + RING_CAPACITY ? lapped_until - start - RING_CAPACITY : 0;
+
+        // Drop ends whose begin fell out of the window so spans stay balanced
+        int depth = 0;
+        for (size_t i = skip; i < copied.size(); i++) {
+            const Copied& event = copied[i];
+            if (event.ts_ns < cutoff || !event.name) continue;
+            if (event.phase == 'E') {
+                if (depth == 0) continue;
+                depth--;
+            } else {
+                depth++;
+            }
+
+            snprintf(buffer, sizeof(buffer), "%s{\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"name\":",
+                     first ? "" : ",", event.phase, pid, ring->tid, event.ts_ns / 1000.0);
+            out += buffer;
+            append_json_name(out, event.name);
+            out += '}';
+            first = false;
+        }
+    }
+    out += "]}\n";
+
+    // The default path is predictable when it falls back to /tmp, so never
+    // open it directly: write a fresh mkstemp() file (O_EXCL, 0600) and rename
+    // it into place, which replaces a planted symlink instead of following it
+    std::string temp = path + ".XXXXXX";
+    int fd = mkstemp(&temp[0]);
+    if (fd < 0) {
+        perror(temp.c_str());
+        return false;
+    }
+    FILE* file = fdopen(fd, "w");
+    if (!file) {
+        perror(temp.c_str());
+        close(fd);
+        unlink(temp.c_str());
+        return false;
+    }
+    size_t written = fwrite(out.data(), 1, out.size(), file);
+    if (fclose(file) != 0 || written != out.size() || rename(temp.c_str(), path.c_str()) != 0) {
+        perror(path.c_str());
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
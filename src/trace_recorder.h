@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+// Opt-in timeline of what the collector and UI threads did recently. Each
+// thread appends begin/end events to its own fixed-size lock-free ring, so
+// recording never blocks; dump() writes the last few seconds as Chrome trace
+// JSON for chrome://tracing or ui.perfetto.dev.
+//
+// Enabled with $TASKMGR_TRACE, the Diagnostics tab, or {"cmd":"trace"} over IPC.
+class TraceRecorder {
+public:
+    static void set_enabled(bool enabled);
+    static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Names must be string literals; only the pointer is stored
+    static void begin(const char* name);
+    static void end(const char* name);
+    static void set_thread_name(const char* name);
+
+    // Writes events from the last window_seconds to path; false on I/O error
+    static bool dump(const std::string& path, double window_seconds = 10.0);
+    static std::string default_dump_path();
+
+    class Scope {
+    public:
+        explicit Scope(const char* name) : name(is_enabled() ? name : nullptr) {
+            if (this->name) begin(this->name);
+        }
+        ~Scope() {
+            if (name) end(name);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+    };
+
+private:
+    static std::atomic<bool> enabled;
+};
@@ -0,0 +1,37 @@
+#include "vm_stats.h"
+
+namespace {
+    enum { PGFAULT, PGMAJFAULT, PSWPIN, PSWPOUT, PGSCAN_KSWAPD, PGSCAN_DIRECT,
+           PGSTEAL_KSWAPD, PGSTEAL_DIRECT, FIELD_COUNT };
+}
+
+VmStats::VmStats()
+    : vmstat("vmstat", {"pgfault", "pgmajfault", "pswpin", "pswpout", "pgscan_kswapd",
+                        "pgscan_direct", "pgsteal_kswapd", "pgsteal_direct"}),
+      previous(FIELD_COUNT, 0) {
+}
+
+VmRates VmStats::update(std::chrono::steady_clock::time_point when) {
+    VmRates rates;
+    if (!vmstat.read(counters)) return rates;
+
+    double seconds = std::chrono::duration<double>(when - last_update).count();
+    if (primed && seconds > 0) {
+        auto rate = [&](int field) {
+            // A counter going backwards is taken as a reset
+            uint64_t now = counters[field], before = previous[field];
+            return now >= before ? (now - before) / seconds : 0.0;
+        };
+        rates.page_faults = rate(PGFAULT);
+        rates.major_faults = rate(PGMAJFAULT);
+        rates.swap_in = rate(PSWPIN);
+        rates.swap_out = rate(PSWPOUT);
+        rates.scanned = rate(PGSCAN_KSWAPD) + rate(PGSCAN_DIRECT);
+        rates.reclaimed = rate(PGSTEAL_KSWAPD) + rate(PGSTEAL_DIRECT);
+    }
+
+    previous.swap(counters);
+    last_update = when;
+    primed = true;
+    return rates;
+}
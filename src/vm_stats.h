@@ -0,0 +1,32 @@
+#pragma once
+
+#include "proc_table.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Paging activity per second from /proc/vmstat counter deltas
+struct VmRates {
+    double page_faults = 0;     // All faults, minor included
+    double major_faults = 0;    // Faults that had to read from disk
+    double swap_in = 0;         // Pages
+    double swap_out = 0;
+    double scanned = 0;         // Pages scanned for reclaim, kswapd and direct
+    double reclaimed = 0;       // Pages stolen by that reclaim
+};
+
+// Collector thread only
+class VmStats {
+public:
+    VmStats();
+
+    // Rates since the previous call; zeros on the first
+    VmRates update(std::chrono::steady_clock::time_point when);
+
+private:
+    ProcTable vmstat;
+    std::vector<uint64_t> counters;
+    std::vector<uint64_t> previous;
+    std::chrono::steady_clock::time_point last_update;
+    bool primed = false;
+};
@@ -0,0 +1,310 @@
+// SystemdManager's service tracking against a mock systemd on a private bus.
+//
+// Starts a throwaway dbus-daemon, claims org.freedesktop.systemd1 on it with
+// a minimal Manager (ListUnits, Subscribe) and per-unit Unit/Service
+// properties, points TASKMGR_SYSTEMD_BUS_ADDRESS at it, then feeds UnitNew,
+// UnitRemoved and PropertiesChanged and checks what get_all_services() sees.
+// Exits 77 (skipped) when dbus-daemon is not installed.
+
+#include "systemd_manager.h"
+#include <gio/gio.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char* SYSTEMD_BUS_NAME = "org.freedesktop.systemd1";
+    const char* SYSTEMD_OBJECT_PATH = "/org/freedesktop/systemd1";
+    const char* UNIT_PATH_PREFIX = "/org/freedesktop/systemd1/unit";
+
+    const char* MOCK_XML =
+        "<node>"
+        "  <interface name='org.freedesktop.systemd1.Manager'>"
+        "    <method name='ListUnits'>"
+        "      <arg type='a(ssssssouso)' direction='out'/>"
+        "    </method>"
+        "    <method name='Subscribe'/>"
+        "  </interface>"
+        "  <interface name='org.freedesktop.systemd1.Unit'>"
+        "    <property name='Description' type='s' access='read'/>"
+        "    <property name='LoadState' type='s' access='read'/>"
+        "    <property name='ActiveState' type='s' access='read'/>"
+        "  </interface>"
+        "  <interface name='org.freedesktop.systemd1.Service'>"
+        "    <property name='MainPID' type='u' access='read'/>"
+        "    <property name='ControlGroup' type='s' access='read'/>"
+        "  </interface>"
+        "</node>";
+
+    struct MockUnit {
+        std::string name;
+        std::string description;
+        std::string active;
+        guint32 main_pid;
+    };
+
+    // Read by the mock's thread, changed by the test's
+    std::mutex units_mutex;
+    std::map<std::string, MockUnit> units;   // By object path
+    GDBusNodeInfo* node_info = nullptr;
+    GDBusConnection* mock_bus = nullptr;
+    int failures = 0;
+
+    #define CHECK(condition) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+    std::string unit_path(const std::string& name) {
+        std::string path = UNIT_PATH_PREFIX;
+        path += "/";
+        // Good enough for the names below; systemd escapes every other byte
+        for (char c : name) path += c == '.' ? std::string("_2e") : std::string(1, c);
+        return path;
+    }
+
+    void add_unit(const std::string& name, const std::string& description, const std::string& active,
+                  guint32 main_pid) {
+        std::lock_guard<std::mutex> lock(units_mutex);
+        MockUnit unit;
+        unit.name = name;
+        unit.description = description;
+        unit.active = active;
+        unit.main_pid = main_pid;
+        units[unit_path(name)] = unit;
+    }
+
+    void emit(const std::string& path, const char* iface, const char* signal, GVariant* parameters) {
+        GError* error = nullptr;
+        if (!g_dbus_connection_emit_signal(mock_bus, nullptr, path.c_str(), iface, signal, parameters, &error)) {
+            fprintf(stderr, "emit %s: %s\n", signal, error->message);
+            g_error_free(error);
+            failures++;
+        }
+        g_dbus_connection_flush_sync(mock_bus, nullptr, nullptr);
+    }
+
+    void on_manager_call(GDBusConnection*, const gchar*, const gchar*, const gchar*,
+                         const gchar* method, GVariant*, GDBusMethodInvocation* invocation, gpointer) {
+        if (g_strcmp0(method, "Subscribe") == 0) {
+            g_dbus_method_invocation_return_value(invocation, nullptr);
+            return;
+        }
+
+        GVariantBuilder list;
+        g_variant_builder_init(&list, G_VARIANT_TYPE("a(ssssssouso)"));
+        std::lock_guard<std::mutex> lock(units_mutex);
+        for (const auto& pair : units) {
+            const MockUnit& unit = pair.second;
+            g_variant_builder_add(&list, "(ssssssouso)", unit.name.c_str(), unit.description.c_str(),
+                                  "loaded", unit.active.c_str(), "running", "", pair.first.c_str(),
+                                  0u, "", "/");
+        }
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a(ssssssouso))", &list));
+    }
+
+    GVariant* on_unit_get_property(GDBusConnection*, const gchar*, const gchar* path, const gchar*,
+                                   const gchar* property, GError** error, gpointer) {
+        std::lock_guard<std::mutex> lock(units_mutex);
+        auto it = units.find(path);
+        if (it == units.end()) {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT, "no unit at %s", path);
+            return nullptr;
+        }
+        const MockUnit& unit = it->second;
+        if (g_strcmp0(property, "Description") == 0) return g_variant_new_string(unit.description.c_str());
+        if (g_strcmp0(property, "LoadState") == 0) return g_variant_new_string("loaded");
+        if (g_strcmp0(property, "ActiveState") == 0) return g_variant_new_string(unit.active.c_str());
+        if (g_strcmp0(property, "MainPID") == 0) return g_variant_new_uint32(unit.main_pid);
+        return g_variant_new_string(("/system.slice/" + unit.name).c_str());
+    }
+
+    const GDBusInterfaceVTable manager_vtable = {on_manager_call, nullptr, nullptr, {nullptr}};
+    const GDBusInterfaceVTable unit_vtable = {nullptr, on_unit_get_property, nullptr, {nullptr}};
+
+    // Units come and go while the test runs, so they are served as a subtree
+    gchar** enumerate_units(GDBusConnection*, const gchar*, const gchar*, gpointer) {
+        std::lock_guard<std::mutex> lock(units_mutex);
+        GPtrArray* nodes = g_ptr_array_new();
+        for (const auto& pair : units) {
+            g_ptr_array_add(nodes, g_strdup(pair.first.c_str() + strlen(UNIT_PATH_PREFIX) + 1));
+        }
+        g_ptr_array_add(nodes, nullptr);
+        return reinterpret_cast<gchar**>(g_ptr_array_free(nodes, FALSE));
+    }
+
+    GDBusInterfaceInfo** introspect_unit(GDBusConnection*, const gchar*, const gchar*, const gchar* node,
+                                         gpointer) {
+        if (!node) return nullptr;
+        GPtrArray* interfaces = g_ptr_array_new();
+        g_ptr_array_add(interfaces, g_dbus_interface_info_ref(node_info->interfaces[1]));
+        g_ptr_array_add(interfaces, g_dbus_interface_info_ref(node_info->interfaces[2]));
+        g_ptr_array_add(interfaces, nullptr);
+        return reinterpret_cast<GDBusInterfaceInfo**>(g_ptr_array_free(interfaces, FALSE));
+    }
+
+    const GDBusInterfaceVTable* dispatch_unit(GDBusConnection*, const gchar*, const gchar*, const gchar*,
+                                              const gchar*, gpointer*, gpointer) {
+        return &unit_vtable;
+    }
+
+    const GDBusSubtreeVTable units_vtable = {enumerate_units, introspect_unit, dispatch_unit, {nullptr}};
+
+    // Runs the mock's objects on their own context and thread, since
+    // SystemdManager blocks in synchronous calls on the test's thread
+    void run_mock(const std::string& address, GMainLoop* loop, std::function<void(bool)> ready) {
+        GMainContext* context = g_main_loop_get_context(loop);
+        g_main_context_push_thread_default(context);
+
+        GError* error = nullptr;
+        mock_bus = g_dbus_connection_new_for_address_sync(address.c_str(),
+            static_cast<GDBusConnectionFlags>(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                              G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+            nullptr, nullptr, &error);
+        GVariant* owned = mock_bus ? g_dbus_connection_call_sync(mock_bus, "org.freedesktop.DBus",
+            "/org/freedesktop/DBus", "org.freedesktop.DBus", "RequestName",
+            g_variant_new("(su)", SYSTEMD_BUS_NAME, 0u), G_VARIANT_TYPE("(u)"),
+            G_DBUS_CALL_FLAGS_NONE, -1, nullptr, &error) : nullptr;
+        if (!owned) {
+            fprintf(stderr, "mock systemd: %s\n", error->message);
+            g_error_free(error);
+            g_main_context_pop_thread_default(context);
+            ready(false);
+            return;
+        }
+        g_variant_unref(owned);
+
+        g_dbus_connection_register_object(mock_bus, SYSTEMD_OBJECT_PATH, node_info->interfaces[0],
+                                          &manager_vtable, nullptr, nullptr, nullptr);
+        g_dbus_connection_register_subtree(mock_bus, UNIT_PATH_PREFIX, &units_vtable,
+                                           G_DBUS_SUBTREE_FLAGS_DISPATCH_TO_UNENUMERATED_NODES,
+                                           nullptr, nullptr, nullptr);
+        ready(true);
+        g_main_loop_run(loop);
+        g_main_context_pop_thread_default(context);
+    }
+
+    // Signals arrive asynchronously; poll until the cache shows the change
+    bool wait_for(std::function<bool(const std::map<std::string, ServiceInfo>&)> condition) {
+        for (int attempt = 0; attempt < 500; attempt++) {
+            std::map<std::string, ServiceInfo> services;
+            for (const auto& info : SystemdManager::get_all_services()) services[info.name] = info;
+            if (condition(services)) return true;
+            usleep(10000);
+        }
+        return false;
+    }
+}
+
+int main() {
+    gchar* daemon = g_find_program_in_path("dbus-daemon");
+    if (!daemon) {
+        printf("dbus-daemon not found; skipping\n");
+        return 77;
+    }
+    g_free(daemon);
+
+    GTestDBus* test_bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(test_bus);
+    std::string address = g_test_dbus_get_bus_address(test_bus);
+    setenv("TASKMGR_SYSTEMD_BUS_ADDRESS", address.c_str(), 1);
+
+    node_info = g_dbus_node_info_new_for_xml(MOCK_XML, nullptr);
+    add_unit("sshd.service", "OpenSSH server", "active", 812);
+    add_unit("cron.service", "Regular background jobs", "active", 640);
+    add_unit("dbus.socket", "D-Bus socket", "active", 0);
+
+    GMainContext* mock_context = g_main_context_new();
+    GMainLoop* loop = g_main_loop_new(mock_context, FALSE);
+    std::mutex ready_mutex;
+    std::condition_variable ready_cv;
+    int ready_state = 0;   // 0 waiting, 1 up, -1 failed
+    std::thread mock(run_mock, address, loop, [&](bool ok) {
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        ready_state = ok ? 1 : -1;
+        ready_cv.notify_all();
+    });
+    {
+        std::unique_lock<std::mutex> lock(ready_mutex);
+        ready_cv.wait(lock, [&]() { return ready_state != 0; });
+    }
+
+    if (ready_state > 0) {
+        // ListUnits: services only, with their ListUnits columns
+        std::vector<ServiceInfo> listed = SystemdManager::get_all_services();
+        CHECK(listed.size() == 2);
+        ServiceInfo sshd = SystemdManager::get_service_info("sshd.service");
+        CHECK(sshd.description == "OpenSSH server");
+        CHECK(sshd.active == "active");
+        CHECK(sshd.object_path == unit_path("sshd.service"));
+
+        // UnitNew: the unit's Unit and Service properties are fetched
+        add_unit("nginx.service", "Web server", "activating", 1234);
+        emit(SYSTEMD_OBJECT_PATH, "org.freedesktop.systemd1.Manager", "UnitNew",
+             g_variant_new("(so)", "nginx.service", unit_path("nginx.service").c_str()));
+        CHECK(wait_for([](const std::map<std::string, ServiceInfo>& services) {
+            auto it = services.find("nginx.service");
+            return it != services.end() && it->second.description == "Web server" &&
+                   it->second.main_pid == 1234 && it->second.cgroup_path == "/system.slice/nginx.service";
+        }));
+
+        // Units of other types are ignored
+        emit(SYSTEMD_OBJECT_PATH, "org.freedesktop.systemd1.Manager", "UnitNew",
+             g_variant_new("(so)", "tmp.mount", unit_path("tmp.mount").c_str()));
+
+        // PropertiesChanged with the new value in the signal
+        GVariantBuilder changed;
+        g_variant_builder_init(&changed, G_VARIANT_TYPE("a{sv}"));
+        g_variant_builder_add(&changed, "{sv}", "ActiveState", g_variant_new_string("active"));
+        emit(unit_path("nginx.service"), "org.freedesktop.DBus.Properties", "PropertiesChanged",
+             g_variant_new("(sa{sv}as)", "org.freedesktop.systemd1.Unit", &changed, nullptr));
+        CHECK(wait_for([](const std::map<std::string, ServiceInfo>& services) {
+            auto it = services.find("nginx.service");
+            return it != services.end() && it->second.active == "active";
+        }));
+
+        // PropertiesChanged that only invalidates: the value is fetched again
+        add_unit("cron.service", "Cron daemon", "active", 640);
+        const gchar* invalidated[] = {"Description", nullptr};
+        emit(unit_path("cron.service"), "org.freedesktop.DBus.Properties", "PropertiesChanged",
+             g_variant_new("(sa{sv}^as)", "org.freedesktop.systemd1.Unit", nullptr, invalidated));
+        CHECK(wait_for([](const std::map<std::string, ServiceInfo>& services) {
+            auto it = services.find("cron.service");
+            return it != services.end() && it->second.description == "Cron daemon";
+        }));
+
+        // UnitRemoved
+        emit(SYSTEMD_OBJECT_PATH, "org.freedesktop.systemd1.Manager", "UnitRemoved",
+             g_variant_new("(so)", "sshd.service", unit_path("sshd.service").c_str()));
+        CHECK(wait_for([](const std::map<std::string, ServiceInfo>& services) {
+            return !services.count("sshd.service") && services.size() == 2;
+        }));
+        CHECK(!SystemdManager::get_service_info("tmp.mount").description.size());
+    } else {
+        failures++;
+    }
+
+    g_main_loop_quit(loop);
+    mock.join();
+    g_main_loop_unref(loop);
+    g_main_context_unref(mock_context);
+    g_test_dbus_down(test_bus);
+    g_object_unref(test_bus);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("systemd_manager_test: all checks passed\n");
+    return 0;
+}
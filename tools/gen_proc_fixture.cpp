@@ -0,0 +1,352 @@
+// Synthesizes a fake procfs (and a little sysfs) tree for reproducible scan
+// benchmarks, e.g.
+//
+//   taskmgr-gen-fixture --processes 10000 --out /tmp/fx
+//   TASKMGR_PROC_ROOT=/tmp/fx/proc TASKMGR_SYS_ROOT=/tmp/fx/sys taskmgr --batch
+//
+// Contents are a pure function of --seed and --tick: regenerating the same
+// tree with --tick N+1 advances every CPU counter, so consecutive scans see
+// realistic CPU% deltas.
+
+#include <dirent.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+    struct Options {
+        int processes = 1000;
+        int services = 50;
+        int cpus = 8;
+        unsigned seed = 1;
+        unsigned tick = 0;
+        std::string out;
+    };
+
+    // Names and owners roughly in the proportions of a busy server
+    const char* PROCESS_NAMES[] = {
+        "systemd", "kworker/0:1-events", "sshd", "bash", "nginx", "postgres",
+        "java", "python3", "node", "containerd-shim", "dockerd", "rsyslogd",
+        "cron", "php-fpm", "redis-server", "Web Content", "(sd-pam)", "ksoftirqd/3",
+    };
+    const unsigned USER_IDS[] = { 0, 0, 0, 33, 100, 1000, 1000, 65534 };
+    const char STATES[] = { 'S', 'S', 'S', 'S', 'S', 'R', 'I', 'D' };
+
+    template <size_t N, typename T>
+    size_t count_of(T (&)[N]) { return N; }
+
+    bool make_dir(const std::string& path) {
+        if (mkdir(path.c_str(), 0755) == 0 || errno == EEXIST) return true;
+        perror(path.c_str());
+        return false;
+    }
+
+    // Creates every component of path, like mkdir -p
+    bool make_dirs(const std::string& path) {
+        for (size_t pos = 1; (pos = path.find('/', pos)) != std::string::npos; pos++) {
+            if (!make_dir(path.substr(0, pos))) return false;
+        }
+        return make_dir(path);
+    }
+
+    // Deletes a directory and everything under it, like rm -r
+    bool remove_tree(const std::string& path) {
+        auto remove_entry = [](const char* entry, const struct stat*, int, struct FTW*) -> int {
+            return remove(entry);
+        };
+        if (nftw(path.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS) == 0) return true;
+        perror(path.c_str());
+        return false;
+    }
+
+    // Regenerating into an existing --out (the --tick workflow) must not leave
+    // PIDs from a larger or differently seeded run behind, or scans would see both
+    bool remove_stale_processes(const std::string& proc_dir, const std::set<int>& pids) {
+        DIR* handle = opendir(proc_dir.c_str());
+        if (!handle) return true;
+
+        std::vector<std::string> stale;
+        struct dirent* entry;
+        while ((entry = readdir(handle)) != nullptr) {
+            char* end = nullptr;
+            long pid = strtol(entry->d_name, &end, 10);
+            if (end == entry->d_name || *end != '\0') continue;
+            if (!pids.count(static_cast<int>(pid))) stale.push_back(proc_dir + "/" + entry->d_name);
+        }
+        closedir(handle);
+
+        for (const auto& path : stale) {
+            if (!remove_tree(path)) return false;
+        }
+        return true;
+    }
+
+    bool write_file(const std::string& path, const std::string& contents) {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            perror(path.c_str());
+            return false;
+        }
+        fwrite(contents.data(), 1, contents.size(), file);
+        return fclose(file) == 0;
+    }
+
+    std::string format(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+    std::string format(const char* fmt, ...) {
+        char buffer[2048];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buffer, sizeof(buffer), fmt, args);
+        va_end(args);
+        return buffer;
+    }
+
+    struct FakeProcess {
+        int pid;
+        int ppid;
+        std::string name;
+        unsigned uid;
+        char state;
+        int threads;
+        int nice;
+        unsigned long long utime;
+        unsigned long long stime;
+        unsigned long long vsize_kb;
+        unsigned long long rss_kb;
+        unsigned long long starttime;
+        std::string cgroup;
+    };
+
+    std::vector<FakeProcess> make_processes(const Options& options) {
+        std::mt19937 rng(options.seed);
+        std::vector<FakeProcess> processes;
+        processes.reserve(options.processes);
+
+        for (int i = 0; i < options.processes; i++) {
+            FakeProcess proc;
+            proc.pid = i == 0 ? 1 : 2 + i * 3 + static_cast<int>(rng() % 3);
+            proc.ppid = i == 0 ? 0 : processes[rng() % processes.size()].pid;
+            proc.name = PROCESS_NAMES[i == 0 ? 0 : rng() % count_of(PROCESS_NAMES)];
+            proc.uid = i == 0 ? 0 : USER_IDS[rng() % count_of(USER_IDS)];
+            proc.state = STATES[rng() % count_of(STATES)];
+            proc.threads = 1 + static_cast<int>(rng() % 8 == 0 ? rng() % 64 : 0);
+            proc.nice = rng() % 10 == 0 ? static_cast<int>(rng() % 20) : 0;
+
+            // Most processes idle; a few burn CPU every tick
+            unsigned rate = rng() % 20 == 0 ? 20 + rng() % 80 : rng() % 2;
+            proc.utime = rng() % 100000 + options.tick * rate;
+            proc.stime = rng() % 20000 + options.tick * (rate / 4);
+
+            proc.vsize_kb = 4096 + rng() % (4 * 1024 * 1024);
+            proc.rss_kb = proc.vsize_kb / (2 + rng() % 30);
+            proc.starttime = 100 + rng() % 1000000;
+
+            unsigned service = options.services ? rng() % options.services : 0;
+            proc.cgroup = proc.uid >= 1000
+                ? format("0::/user.slice/user-%u.slice/session-2.scope", proc.uid)
+                : format("0::/system.slice/fixture-%u.service", service);
+            processes.push_back(proc);
+        }
+        return processes;
+    }
+
+    std::string stat_line(const FakeProcess& proc) {
+        // All 52 fields, as in proc(5)
+        return format("%d (%s) %c %d %d %d 0 -1 4194560 %llu 0 %llu 0 %llu %llu 0 0 %d %d %d 0 %llu "
+                      "%llu %llu 18446744073709551615 1 1 0 0 0 0 0 4096 17663 0 0 0 17 %d 0 0 0 0 0 "
+                      "0 0 0 0 0 0 0 0\n",
+                      proc.pid, proc.name.c_str(), proc.state, proc.ppid, proc.pid, proc.pid,
+                      proc.utime * 3, proc.utime / 100, proc.utime, proc.stime,
+                      20 + proc.nice, proc.nice, proc.threads, proc.starttime,
+                      proc.vsize_kb * 1024, proc.rss_kb / 4, proc.pid % 8);
+    }
+
+    std::string status_file(const FakeProcess& proc) {
+        return format("Name:\t%s\nUmask:\t0022\nState:\t%c (%s)\nTgid:\t%d\nNgid:\t0\nPid:\t%d\n"
+                      "PPid:\t%d\nTracerPid:\t0\nUid:\t%u\t%u\t%u\t%u\nGid:\t%u\t%u\t%u\t%u\n"
+                      "FDSize:\t64\nGroups:\t\nNStgid:\t%d\nNSpid:\t%d\nNSpgid:\t%d\nNSsid:\t%d\n"
+                      "VmPeak:\t%8llu kB\nVmSize:\t%8llu kB\nVmLck:\t       0 kB\nVmPin:\t       0 kB\n"
+                      "VmHWM:\t%8llu kB\nVmRSS:\t%8llu kB\nRssAnon:\t%8llu kB\nRssFile:\t%8llu kB\n"
+                      "RssShmem:\t       0 kB\nVmData:\t%8llu kB\nVmStk:\t     132 kB\nVmExe:\t     892 kB\n"
+                      "VmLib:\t    8432 kB\nVmPTE:\t     120 kB\nVmSwap:\t       0 kB\n"
+                      "HugetlbPages:\t       0 kB\nCoreDumping:\t0\nTHP_enabled:\t1\nThreads:\t%d\n"
+                      "SigQ:\t0/62711\nSigPnd:\t0000000000000000\nShdPnd:\t0000000000000000\n"
+                      "SigBlk:\t0000000000000000\nSigIgn:\t0000000000001000\nSigCgt:\t0000000180004a02\n"
+                      "CapInh:\t0000000000000000\nCapPrm:\t0000000000000000\nCapEff:\t0000000000000000\n"
+                      "CapBnd:\t000001ffffffffff\nCapAmb:\t0000000000000000\nNoNewPrivs:\t0\n"
+                      "Seccomp:\t0\nSpeculation_Store_Bypass:\tthread vulnerable\n"
+                      "Cpus_allowed:\tff\nCpus_allowed_list:\t0-7\nMems_allowed:\t1\n"
+                      "Mems_allowed_list:\t0\nvoluntary_ctxt_switches:\t%llu\n"
+                      "nonvoluntary_ctxt_switches:\t%llu\n",
+                      proc.name.c_str(), proc.state, proc.state == 'R' ? "running" : "sleeping",
+                      proc.pid, proc.pid, proc.ppid, proc.uid, proc.uid, proc.uid, proc.uid,
+                      proc.uid, proc.uid, proc.uid, proc.uid, proc.pid, proc.pid, proc.pid, proc.pid,
+                      proc.vsize_kb + 512, proc.vsize_kb, proc.rss_kb + 64, proc.rss_kb,
+                      proc.rss_kb * 3 / 4, proc.rss_kb / 4, proc.vsize_kb / 3, proc.threads,
+                      proc.utime / 7, proc.utime / 50);
+    }
+
+    std::string io_file(const FakeProcess& proc, unsigned tick) {
+        unsigned long long read_bytes = proc.utime * 4096 + tick * (proc.pid % 7) * 8192ULL;
+        unsigned long long write_bytes = proc.stime * 4096 + tick * (proc.pid % 3) * 4096ULL;
+        return format("rchar: %llu\nwchar: %llu\nsyscr: %llu\nsyscw: %llu\n"
+                      "read_bytes: %llu\nwrite_bytes: %llu\ncancelled_write_bytes: 0\n",
+                      read_bytes * 2, write_bytes * 2, proc.utime, proc.stime, read_bytes, write_bytes);
+    }
+
+    bool write_system_files(const Options& options, const std::string& proc_dir,
+                            const std::vector<FakeProcess>& processes) {
+        unsigned long long user = 0, system = 0;
+        for (const auto& proc : processes) {
+            user += proc.utime;
+            system += proc.stime;
+        }
+        // Idle grows with wall time so total CPU usage stays plausible
+        unsigned long long idle = 5000000ULL * options.cpus + options.tick * 50ULL * options.cpus;
+
+        std::string stat = format("cpu  %llu 120 %llu %llu 3100 0 2200 0 0 0\n", user, system, idle);
+        for (int cpu = 0; cpu < options.cpus; cpu++) {
+            stat += format("cpu%d %llu 15 %llu %llu 387 0 275 0 0 0\n", cpu, user / options.cpus,
+                           system / options.cpus, idle / options.cpus);
+        }
+        stat += format("intr 123456789\nctxt 987654321\nbtime 1700000000\nprocesses %zu\n"
+                       "procs_running %d\nprocs_blocked 0\n", processes.size() * 4,
+                       1 + options.cpus / 2);
+
+        unsigned long long total_kb = 64ULL * 1024 * 1024;
+        std::string meminfo = format("MemTotal:       %llu kB\nMemFree:        %llu kB\n"
+                                     "MemAvailable:   %llu kB\nBuffers:          524288 kB\n"
+                                     "Cached:         %llu kB\nSwapCached:            0 kB\n"
+                                     "SwapTotal:      8388604 kB\nSwapFree:       8388604 kB\n"
+                                     "AnonPages:      %llu kB\nShmem:           262144 kB\n"
+                                     "Slab:           1048576 kB\nPageTables:      131072 kB\n",
+                                     total_kb, total_kb / 4, total_kb / 2, total_kb / 5, total_kb / 3);
+
+        unsigned long long faults = 500000000ULL + options.tick * 20000ULL;
+        std::string vmstat = format("nr_free_pages 4194304\npgfault %llu\npgmajfault %llu\n"
+                                    "pswpin 0\npswpout 0\npgsteal_kswapd %llu\npgsteal_direct 0\n"
+                                    "pgscan_kswapd %llu\npgscan_direct 0\n",
+                                    faults, faults / 1000, options.tick * 300ULL, options.tick * 400ULL);
+
+        std::string net_dev =
+            "Inter-|   Receive                                                |  Transmit\n"
+            " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+            "    lo: 1000000 10000 0 0 0 0 0 0 1000000 10000 0 0 0 0 0 0\n" +
+            format("  eth0: %llu 900000 0 0 0 0 0 0 %llu 700000 0 0 0 0 0 0\n",
+                   900000000ULL + options.tick * 125000ULL, 300000000ULL + options.tick * 62500ULL);
+
+        return write_file(proc_dir + "/stat", stat) &&
+               write_file(proc_dir + "/meminfo", meminfo) &&
+               write_file(proc_dir + "/vmstat", vmstat) &&
+               write_file(proc_dir + "/uptime", format("%u.00 %u.00\n", 50000 + options.tick,
+                                                       300000 + options.tick * options.cpus)) &&
+               write_file(proc_dir + "/loadavg", "1.25 1.10 0.98 3/812 4242\n") &&
+               make_dir(proc_dir + "/net") &&
+               write_file(proc_dir + "/net/dev", net_dev);
+    }
+
+    bool write_cgroups(const Options& options, const std::string& sys_dir) {
+        std::string slice = sys_dir + "/fs/cgroup/system.slice";
+        if (!make_dirs(slice)) return false;
+
+        for (int i = 0; i < options.services; i++) {
+            std::string dir = slice + format("/fixture-%d.service", i);
+            unsigned long long usage = (i + 1) * 1000000ULL + options.tick * (i % 5) * 10000ULL;
+            unsigned long long io = (i + 1) * 4096ULL * (options.tick + 1);
+            if (!make_dir(dir) ||
+                !write_file(dir + "/cpu.stat", format("usage_usec %llu\nuser_usec %llu\nsystem_usec %llu\n",
+                                                      usage, usage * 3 / 4, usage / 4)) ||
+                !write_file(dir + "/memory.current", format("%d\n", (i + 1) * 8 * 1024 * 1024)) ||
+                !write_file(dir + "/pids.current", format("%d\n", 1 + i % 7)) ||
+                !write_file(dir + "/io.stat", format("8:0 rbytes=%llu wbytes=%llu rios=10 wios=10 dbytes=0 dios=0\n",
+                                                     io, io / 2))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void print_usage(const char* program) {
+        std::cerr << "Usage: " << program << " --out DIR [options]\n"
+                  << "  -o, --out DIR         fixture root; DIR/proc and DIR/sys are created\n"
+                  << "  -p, --processes N     number of fake processes (default 1000)\n"
+                  << "  -s, --services N      number of fake service cgroups (default 50)\n"
+                  << "  -c, --cpus N          CPUs listed in stat (default 8)\n"
+                  << "  -r, --seed N          random seed (default 1)\n"
+                  << "  -t, --tick N          advance CPU/IO counters N ticks (default 0)\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    static const struct option long_options[] = {
+        {"out", required_argument, nullptr, 'o'},
+        {"processes", required_argument, nullptr, 'p'},
+        {"services", required_argument, nullptr, 's'},
+        {"cpus", required_argument, nullptr, 'c'},
+        {"seed", required_argument, nullptr, 'r'},
+        {"tick", required_argument, nullptr, 't'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    Options options;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:p:s:c:r:t:h", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 'o': options.out = optarg; break;
+        case 'p': options.processes = atoi(optarg); break;
+        case 's': options.services = atoi(optarg); break;
+        case 'c': options.cpus = atoi(optarg); break;
+        case 'r': options.seed = static_cast<unsigned>(strtoul(optarg, nullptr, 10)); break;
+        case 't': options.tick = static_cast<unsigned>(strtoul(optarg, nullptr, 10)); break;
+        default:
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.out.empty() || options.processes < 1 || options.services < 0 || options.cpus < 1) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::string proc_dir = options.out + "/proc";
+    std::string sys_dir = options.out + "/sys";
+    if (!make_dirs(proc_dir)) return 1;
+
+    auto processes = make_processes(options);
+    std::set<int> pids;
+    for (const auto& proc : processes) pids.insert(proc.pid);
+    if (!remove_stale_processes(proc_dir, pids)) return 1;
+    if (!write_system_files(options, proc_dir, processes)) return 1;
+
+    for (const auto& proc : processes) {
+        std::string dir = proc_dir + "/" + std::to_string(proc.pid);
+        if (!make_dir(dir) ||
+            !write_file(dir + "/stat", stat_line(proc)) ||
+            !write_file(dir + "/status", status_file(proc)) ||
+            !write_file(dir + "/cgroup", proc.cgroup + "\n") ||
+            !write_file(dir + "/io", io_file(proc, options.tick)) ||
+            !write_file(dir + "/cmdline", proc.name + std::string(1, '\0'))) {
+            return 1;
+        }
+    }
+
+    if (!write_cgroups(options, sys_dir)) return 1;
+
+    std::cout << "Wrote " << processes.size() << " processes and " << options.services
+              << " service cgroups under " << options.out << " (tick " << options.tick << ")"
+              << std::endl;
+    return 0;
+}